@@ -0,0 +1,365 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CharacterSpatialHashSubsystem.h"
+
+#include "GameCharacterBase.h"
+
+UCharacterSpatialHashSubsystem::UCharacterSpatialHashSubsystem()
+{
+	bIsInitialized = false;
+	CellSize = 1000.0f;
+}
+
+template<typename VisitorType>
+void UCharacterSpatialHashSubsystem::ForEachEntryInCells(const FVector2D& Min, const FVector2D& Max, VisitorType&& Visitor) const
+{
+	const FIntPoint MinCell = GetCell(FVector(Min, 0.0f));
+	const FIntPoint MaxCell = GetCell(FVector(Max, 0.0f));
+
+	// A query bigger than the occupied cells is cheaper as a walk over the occupied cells
+	if ((int64)(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) > Cells.Num())
+	{
+		for (const TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+		{
+			if (Cell.Key.X < MinCell.X || Cell.Key.X > MaxCell.X || Cell.Key.Y < MinCell.Y || Cell.Key.Y > MaxCell.Y)
+			{
+				continue;
+			}
+
+			for (int32 EntryIndex : Cell.Value)
+			{
+				if (!Visitor(Entries[EntryIndex]))
+				{
+					return;
+				}
+			}
+		}
+
+		return;
+	}
+
+	for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+		{
+			const TArray<int32>* CellEntries = Cells.Find(FIntPoint(CellX, CellY));
+			if (!CellEntries)
+			{
+				continue;
+			}
+
+			for (int32 EntryIndex : *CellEntries)
+			{
+				if (!Visitor(Entries[EntryIndex]))
+				{
+					return;
+				}
+			}
+		}
+	}
+}
+
+void UCharacterSpatialHashSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsInitialized = true;
+}
+
+void UCharacterSpatialHashSubsystem::Deinitialize()
+{
+	bIsInitialized = false;
+	Entries.Empty();
+	EntryIndices.Empty();
+	Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCharacterSpatialHashSubsystem::AddCharacter(AGameCharacterBase* Character)
+{
+	if (!IsValid(Character) || EntryIndices.Contains(Character))
+	{
+		return;
+	}
+
+	FCharacterEntry Entry;
+	Entry.Character = Character;
+	Entry.Location = Character->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+	Entry.IndexInCell = INDEX_NONE;
+
+	const int32 EntryIndex = Entries.Add(Entry);
+	EntryIndices.Add(Character, EntryIndex);
+	LinkToCell(EntryIndex, Entry.Cell);
+}
+
+void UCharacterSpatialHashSubsystem::RemoveCharacter(AGameCharacterBase* Character)
+{
+	const int32* EntryIndex = EntryIndices.Find(Character);
+	if (EntryIndex)
+	{
+		RemoveEntry(*EntryIndex);
+	}
+}
+
+void UCharacterSpatialHashSubsystem::SetCellSize(float NewCellSize)
+{
+	if (NewCellSize <= 0.0f || NewCellSize == CellSize)
+	{
+		return;
+	}
+
+	CellSize = NewCellSize;
+
+	Cells.Reset();
+	for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); EntryIndex++)
+	{
+		Entries[EntryIndex].Cell = GetCell(Entries[EntryIndex].Location);
+		LinkToCell(EntryIndex, Entries[EntryIndex].Cell);
+	}
+}
+
+void UCharacterSpatialHashSubsystem::QuerySphere(const FVector& Location, float Radius, ECharacterQueryFilter Filter, TArray<AGameCharacterBase*>& OutCharacters) const
+{
+	OutCharacters.Reset();
+
+	const float RadiusSquared = FMath::Square(Radius);
+	const FVector2D Center(Location);
+
+	ForEachEntryInCells(Center - Radius, Center + Radius, [&](const FCharacterEntry& Entry)
+	{
+		AGameCharacterBase* Character = Entry.Character.Get();
+		if (FVector::DistSquared(Entry.Location, Location) <= RadiusSquared && PassesFilter(Character, Filter))
+		{
+			OutCharacters.Add(Character);
+		}
+		return true;
+	});
+}
+
+void UCharacterSpatialHashSubsystem::QueryBox(const FBox& Box, ECharacterQueryFilter Filter, TArray<AGameCharacterBase*>& OutCharacters) const
+{
+	OutCharacters.Reset();
+
+	ForEachEntryInCells(FVector2D(Box.Min), FVector2D(Box.Max), [&](const FCharacterEntry& Entry)
+	{
+		AGameCharacterBase* Character = Entry.Character.Get();
+		if (Box.IsInsideOrOn(Entry.Location) && PassesFilter(Character, Filter))
+		{
+			OutCharacters.Add(Character);
+		}
+		return true;
+	});
+}
+
+AGameCharacterBase* UCharacterSpatialHashSubsystem::FindNearest(const FVector& Location, float MaxDistance, ECharacterQueryFilter Filter, const AGameCharacterBase* IgnoredCharacter) const
+{
+	AGameCharacterBase* NearestCharacter = nullptr;
+	float NearestDistanceSquared = MaxDistance > 0.0f ? FMath::Square(MaxDistance) : MAX_flt;
+
+	auto VisitEntry = [&](const FCharacterEntry& Entry)
+	{
+		const float DistanceSquared = FVector::DistSquared(Entry.Location, Location);
+		if (DistanceSquared >= NearestDistanceSquared)
+		{
+			return;
+		}
+
+		AGameCharacterBase* Character = Entry.Character.Get();
+		if (Character != IgnoredCharacter && PassesFilter(Character, Filter))
+		{
+			NearestDistanceSquared = DistanceSquared;
+			NearestCharacter = Character;
+		}
+	};
+
+	// With no distance limit the ring search has no bound, and walking the dense entries is cheap enough
+	if (MaxDistance <= 0.0f)
+	{
+		for (const FCharacterEntry& Entry : Entries)
+		{
+			VisitEntry(Entry);
+		}
+
+		return NearestCharacter;
+	}
+
+	const FIntPoint CenterCell = GetCell(Location);
+	const int32 MaxRing = FMath::CeilToInt(MaxDistance / CellSize);
+
+	for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		// Anything in this ring or further out is at least (Ring - 1) cells away in XY
+		if (NearestCharacter && Ring > 0 && FMath::Square((Ring - 1) * CellSize) > NearestDistanceSquared)
+		{
+			break;
+		}
+
+		for (int32 CellY = CenterCell.Y - Ring; CellY <= CenterCell.Y + Ring; CellY++)
+		{
+			// Inner rows only need the two cells on the ring's edge
+			const bool bEdgeRow = CellY == CenterCell.Y - Ring || CellY == CenterCell.Y + Ring;
+			const int32 CellXStep = bEdgeRow || Ring == 0 ? 1 : Ring * 2;
+
+			for (int32 CellX = CenterCell.X - Ring; CellX <= CenterCell.X + Ring; CellX += CellXStep)
+			{
+				const TArray<int32>* CellEntries = Cells.Find(FIntPoint(CellX, CellY));
+				if (!CellEntries)
+				{
+					continue;
+				}
+
+				for (int32 EntryIndex : *CellEntries)
+				{
+					VisitEntry(Entries[EntryIndex]);
+				}
+			}
+		}
+	}
+
+	return NearestCharacter;
+}
+
+int UCharacterSpatialHashSubsystem::CountInSphere(const FVector& Location, float Radius, ECharacterQueryFilter Filter, int MaxCount) const
+{
+	int Count = 0;
+
+	const float RadiusSquared = FMath::Square(Radius);
+	const FVector2D Center(Location);
+
+	ForEachEntryInCells(Center - Radius, Center + Radius, [&](const FCharacterEntry& Entry)
+	{
+		if (FVector::DistSquared(Entry.Location, Location) <= RadiusSquared && PassesFilter(Entry.Character.Get(), Filter))
+		{
+			Count++;
+		}
+		return MaxCount <= 0 || Count < MaxCount;
+	});
+
+	return Count;
+}
+
+int UCharacterSpatialHashSubsystem::GetNumCharacters() const
+{
+	return Entries.Num();
+}
+
+void UCharacterSpatialHashSubsystem::Tick(float DeltaTime)
+{
+	// Walk backwards so removing an entry never skips the one swapped into its place
+	for (int32 EntryIndex = Entries.Num() - 1; EntryIndex >= 0; EntryIndex--)
+	{
+		FCharacterEntry& Entry = Entries[EntryIndex];
+		const AGameCharacterBase* Character = Entry.Character.Get();
+		if (!IsValid(Character))
+		{
+			RemoveEntry(EntryIndex);
+			continue;
+		}
+
+		Entry.Location = Character->GetActorLocation();
+
+		const FIntPoint NewCell = GetCell(Entry.Location);
+		if (NewCell != Entry.Cell)
+		{
+			UnlinkFromCell(EntryIndex);
+			LinkToCell(EntryIndex, NewCell);
+		}
+	}
+}
+
+bool UCharacterSpatialHashSubsystem::IsTickable() const
+{
+	return bIsInitialized && Entries.Num() > 0;
+}
+
+ETickableTickType UCharacterSpatialHashSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UCharacterSpatialHashSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UCharacterSpatialHashSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCharacterSpatialHashSubsystem, STATGROUP_Tickables);
+}
+
+FIntPoint UCharacterSpatialHashSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UCharacterSpatialHashSubsystem::LinkToCell(int32 EntryIndex, const FIntPoint& Cell)
+{
+	FCharacterEntry& Entry = Entries[EntryIndex];
+	Entry.Cell = Cell;
+	Entry.IndexInCell = Cells.FindOrAdd(Cell).Add(EntryIndex);
+}
+
+void UCharacterSpatialHashSubsystem::UnlinkFromCell(int32 EntryIndex)
+{
+	const FCharacterEntry& Entry = Entries[EntryIndex];
+
+	TArray<int32>* CellEntries = Cells.Find(Entry.Cell);
+	if (!CellEntries)
+	{
+		return;
+	}
+
+	CellEntries->RemoveAtSwap(Entry.IndexInCell, 1, false);
+
+	if (CellEntries->IsValidIndex(Entry.IndexInCell))
+	{
+		Entries[(*CellEntries)[Entry.IndexInCell]].IndexInCell = Entry.IndexInCell;
+	}
+	else if (CellEntries->Num() == 0)
+	{
+		Cells.Remove(Entry.Cell);
+	}
+}
+
+void UCharacterSpatialHashSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	UnlinkFromCell(EntryIndex);
+	EntryIndices.Remove(Entries[EntryIndex].Character);
+
+	const int32 LastEntryIndex = Entries.Num() - 1;
+	if (EntryIndex != LastEntryIndex)
+	{
+		// The last entry moves into the freed slot, so point its cell and index map at the new slot
+		const FCharacterEntry& MovedEntry = Entries[LastEntryIndex];
+		Cells.FindChecked(MovedEntry.Cell)[MovedEntry.IndexInCell] = EntryIndex;
+		EntryIndices.Add(MovedEntry.Character, EntryIndex);
+	}
+
+	Entries.RemoveAtSwap(EntryIndex, 1, false);
+}
+
+bool UCharacterSpatialHashSubsystem::PassesFilter(const AGameCharacterBase* Character, ECharacterQueryFilter Filter)
+{
+	if (!Character)
+	{
+		return false;
+	}
+
+	switch (Filter)
+	{
+	case ECharacterQueryFilter::Alive:
+		return Character->bIsAlive;
+
+	case ECharacterQueryFilter::AliveEnemies:
+		return Character->bIsAlive && !Character->IsPlayerControlled();
+
+	case ECharacterQueryFilter::AlivePlayers:
+		return Character->bIsAlive && Character->IsPlayerControlled();
+
+	default:
+		return true;
+	}
+}
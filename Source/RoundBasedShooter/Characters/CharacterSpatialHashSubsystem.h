@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CharacterSpatialHashSubsystem.generated.h"
+
+class AGameCharacterBase;
+
+// Which characters a spatial hash query returns
+UENUM(BlueprintType)
+enum class ECharacterQueryFilter : uint8
+{
+	All UMETA(DisplayName = "All"),
+	Alive UMETA(DisplayName = "Alive"),
+	AliveEnemies UMETA(DisplayName = "Alive Enemies"),
+	AlivePlayers UMETA(DisplayName = "Alive Players")
+};
+
+/**
+	Uniform grid over the XY plane holding every game character in the level, so proximity queries only look at the cells
+	around the query instead of every actor. Characters add themselves on begin play and remove themselves on end play,
+	and the enemy pool takes pooled enemies out while they are inactive. Locations are refreshed every frame but a character
+	only moves between cells when it crosses a cell boundary.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UCharacterSpatialHashSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UCharacterSpatialHashSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	// Adds the character to the hash. Does nothing if it is already in it
+	void AddCharacter(AGameCharacterBase* Character);
+
+	// Removes the character from the hash. Does nothing if it is not in it
+	void RemoveCharacter(AGameCharacterBase* Character);
+
+	// Size of the cells. Roughly the usual query radius works well. Rebuilds the hash
+	void SetCellSize(float NewCellSize);
+
+	/**
+		Finds the characters within the radius of the location.
+		@param Location - Center of the sphere
+		@param Radius - Radius of the sphere
+		@param Filter - Which characters to return
+		@param OutCharacters - Returned characters in no particular order. Emptied first
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void QuerySphere(const FVector& Location, float Radius, ECharacterQueryFilter Filter, TArray<AGameCharacterBase*>& OutCharacters) const;
+
+	/**
+		Finds the characters inside the box.
+		@param Box - Box to search
+		@param Filter - Which characters to return
+		@param OutCharacters - Returned characters in no particular order. Emptied first
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void QueryBox(const FBox& Box, ECharacterQueryFilter Filter, TArray<AGameCharacterBase*>& OutCharacters) const;
+
+	/**
+		Finds the character closest to the location. Searches rings of cells outwards and stops once no closer character can be found.
+		@param Location - Find the character closest to this location
+		@param MaxDistance - Characters further than this are ignored. 0 for no limit
+		@param Filter - Which characters to consider
+		@param IgnoredCharacter - Character to skip, usually the one asking
+		@return The closest character. Null if none were found
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	AGameCharacterBase* FindNearest(const FVector& Location, float MaxDistance, ECharacterQueryFilter Filter, const AGameCharacterBase* IgnoredCharacter = nullptr) const;
+
+	// Counts the characters within the radius of the location. Stops counting at MaxCount if it is above 0
+	UFUNCTION(BlueprintPure, Category = "Spatial Hash")
+	int CountInSphere(const FVector& Location, float Radius, ECharacterQueryFilter Filter, int MaxCount = 0) const;
+
+	// Number of characters in the hash
+	UFUNCTION(BlueprintPure, Category = "Spatial Hash")
+	int GetNumCharacters() const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	struct FCharacterEntry
+	{
+		// Weak, since the hash holds no reference and a character can be collected without removing itself, e.g. when its level streams out
+		TWeakObjectPtr<AGameCharacterBase> Character;
+
+		// Location as of the last update
+		FVector Location;
+
+		FIntPoint Cell;
+
+		// Index of this entry in its cell's entry list
+		int32 IndexInCell;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	// Adds the entry to the cell's entry list and records where
+	void LinkToCell(int32 EntryIndex, const FIntPoint& Cell);
+
+	// Removes the entry from its cell's entry list, fixing up the entry that takes its place
+	void UnlinkFromCell(int32 EntryIndex);
+
+	// Removes the entry, moving the last entry into its place
+	void RemoveEntry(int32 EntryIndex);
+
+	// False for characters that are gone but not yet removed by Tick
+	static bool PassesFilter(const AGameCharacterBase* Character, ECharacterQueryFilter Filter);
+
+	// Calls Visitor with every entry in the cells overlapping the XY range. Stops early if Visitor returns false
+	template<typename VisitorType>
+	void ForEachEntryInCells(const FVector2D& Min, const FVector2D& Max, VisitorType&& Visitor) const;
+
+	bool bIsInitialized;
+
+	float CellSize;
+
+	// Every character in the hash. Dense so the per frame update is a straight walk
+	TArray<FCharacterEntry> Entries;
+
+	// Maps character to its index in Entries
+	TMap<TWeakObjectPtr<AGameCharacterBase>, int32> EntryIndices;
+
+	// Entry indices in each occupied cell. Empty cells are removed
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
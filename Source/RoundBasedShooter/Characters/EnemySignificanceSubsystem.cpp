@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemySignificanceSubsystem.h"
+
+#include "GameCharacterBase.h"
+#include "../Spawning/EnemyRegistrySubsystem.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+
+UEnemySignificanceSubsystem::UEnemySignificanceSubsystem()
+{
+	bIsInitialized = false;
+	TimeUntilUpdate = 0.0f;
+}
+
+void UEnemySignificanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsInitialized = true;
+	TierCounts.Init(0, Settings.Tiers.Num());
+}
+
+void UEnemySignificanceSubsystem::Deinitialize()
+{
+	bIsInitialized = false;
+	EnemyTiers.Empty();
+	PreviousEnemyTiers.Empty();
+
+	Super::Deinitialize();
+}
+
+void UEnemySignificanceSubsystem::SetSignificanceSettings(const FEnemySignificanceSettings& NewSettings)
+{
+	Settings = NewSettings;
+
+	// Forget every enemy's tier so the new tiers are applied to all of them
+	EnemyTiers.Reset();
+	TierCounts.Init(0, Settings.Tiers.Num());
+	TimeUntilUpdate = 0.0f;
+}
+
+void UEnemySignificanceSubsystem::UpdateSignificance()
+{
+	const int32 NumTiers = Settings.Tiers.Num();
+
+	Swap(EnemyTiers, PreviousEnemyTiers);
+	EnemyTiers.Reset();
+	TierCounts.Init(0, NumTiers);
+
+	UEnemyRegistrySubsystem* EnemyRegistry = GetWorld()->GetSubsystem<UEnemyRegistrySubsystem>();
+	if (!EnemyRegistry || NumTiers == 0)
+	{
+		return;
+	}
+
+	PlayerLocations.Reset();
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController && PlayerController->GetPawn())
+		{
+			PlayerLocations.Add(PlayerController->GetPawn()->GetActorLocation());
+		}
+	}
+
+	const TArray<AActor*>& Enemies = EnemyRegistry->GetEnemies();
+	const float OffscreenScaleSquared = FMath::Square(Settings.OffscreenDistanceScale);
+
+	// Nothing is ever rendered on a dedicated server, so every enemy would count as off screen
+	const bool bUseOffscreenScale = GetWorld()->GetNetMode() != NM_DedicatedServer;
+
+	EnemyScores.SetNumUninitialized(Enemies.Num(), false);
+	RankedEnemyIndices.Reset();
+
+	for (int32 EnemyIndex = 0; EnemyIndex < Enemies.Num(); EnemyIndex++)
+	{
+		const AActor* Enemy = Enemies[EnemyIndex];
+		if (!IsValid(Enemy))
+		{
+			continue;
+		}
+
+		// Dead enemies never need more than the lowest tier
+		const AGameCharacterBase* GameCharacter = Cast<AGameCharacterBase>(Enemy);
+		if (GameCharacter && !GameCharacter->bIsAlive)
+		{
+			EnemyScores[EnemyIndex] = MAX_flt;
+			RankedEnemyIndices.Add(EnemyIndex);
+			continue;
+		}
+
+		const FVector EnemyLocation = Enemy->GetActorLocation();
+		float NearestDistanceSquared = MAX_flt;
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			NearestDistanceSquared = FMath::Min(NearestDistanceSquared, FVector::DistSquared(EnemyLocation, PlayerLocation));
+		}
+
+		if (bUseOffscreenScale && NearestDistanceSquared < MAX_flt && !Enemy->WasRecentlyRendered(Settings.UpdateInterval))
+		{
+			NearestDistanceSquared *= OffscreenScaleSquared;
+		}
+
+		EnemyScores[EnemyIndex] = NearestDistanceSquared;
+		RankedEnemyIndices.Add(EnemyIndex);
+	}
+
+	RankedEnemyIndices.Sort([this](int32 A, int32 B)
+	{
+		return EnemyScores[A] < EnemyScores[B];
+	});
+
+	// Scores only go up along the ranking, so once an enemy misses a tier every enemy after it does too
+	int32 Tier = 0;
+	for (int32 EnemyIndex : RankedEnemyIndices)
+	{
+		while (Tier < NumTiers - 1 && !FitsTier(Tier, EnemyScores[EnemyIndex]))
+		{
+			Tier++;
+		}
+
+		AActor* Enemy = Enemies[EnemyIndex];
+		const int32* PreviousTier = PreviousEnemyTiers.Find(Enemy);
+		if (!PreviousTier || *PreviousTier != Tier)
+		{
+			ApplyTier(Enemy, Tier);
+		}
+
+		EnemyTiers.Add(Enemy, Tier);
+		TierCounts[Tier]++;
+	}
+}
+
+int UEnemySignificanceSubsystem::GetNumEnemiesInTier(int Tier) const
+{
+	return TierCounts.IsValidIndex(Tier) ? TierCounts[Tier] : 0;
+}
+
+TArray<int> UEnemySignificanceSubsystem::GetTierCounts() const
+{
+	return TierCounts;
+}
+
+int UEnemySignificanceSubsystem::GetEnemyTier(const AActor* Enemy) const
+{
+	const int32* Tier = EnemyTiers.Find(Enemy);
+	return Tier ? *Tier : INDEX_NONE;
+}
+
+void UEnemySignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.0f)
+	{
+		return;
+	}
+
+	TimeUntilUpdate = Settings.UpdateInterval;
+	UpdateSignificance();
+}
+
+bool UEnemySignificanceSubsystem::IsTickable() const
+{
+	return bIsInitialized && GetWorld() && GetWorld()->IsGameWorld();
+}
+
+ETickableTickType UEnemySignificanceSubsystem::GetTickableTickType() const
+{
+	// The class default object is never initialized and should not be in the tickable list at all
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UEnemySignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UEnemySignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemySignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void UEnemySignificanceSubsystem::ApplyTier(AActor* Enemy, int32 Tier) const
+{
+	const FEnemySignificanceTier& TierSettings = Settings.Tiers[Tier];
+
+	Enemy->SetActorTickInterval(TierSettings.ActorTickInterval);
+
+	ACharacter* EnemyCharacter = Cast<ACharacter>(Enemy);
+	if (!EnemyCharacter)
+	{
+		return;
+	}
+
+	if (EnemyCharacter->GetCharacterMovement())
+	{
+		EnemyCharacter->GetCharacterMovement()->SetComponentTickInterval(TierSettings.MovementTickInterval);
+	}
+
+	if (EnemyCharacter->GetMesh())
+	{
+		EnemyCharacter->GetMesh()->VisibilityBasedAnimTickOption = TierSettings.MeshAnimTickOption;
+		EnemyCharacter->GetMesh()->bEnableUpdateRateOptimizations = TierSettings.bEnableUpdateRateOptimizations;
+	}
+}
+
+bool UEnemySignificanceSubsystem::FitsTier(int32 Tier, float ScoreSquared) const
+{
+	const FEnemySignificanceTier& TierSettings = Settings.Tiers[Tier];
+
+	if (TierSettings.MaxDistance > 0.0f && ScoreSquared > FMath::Square(TierSettings.MaxDistance))
+	{
+		return false;
+	}
+
+	return TierSettings.MaxEnemies <= 0 || TierCounts[Tier] < TierSettings.MaxEnemies;
+}
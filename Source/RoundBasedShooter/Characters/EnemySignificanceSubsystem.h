@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "EnemySignificanceSubsystem.generated.h"
+
+// How often enemies in a significance tier update
+USTRUCT(BlueprintType)
+struct FEnemySignificanceTier
+{
+	GENERATED_BODY()
+
+public:
+
+	// Enemies further than this from every player fall to a lower tier. 0 for no limit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance", meta = (ClampMin = "0.0"))
+	float MaxDistance;
+
+	// Max number of enemies in this tier. The furthest enemies over the limit fall to a lower tier. 0 for no limit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance", meta = (ClampMin = "0"))
+	int MaxEnemies;
+
+	// Seconds between actor ticks. 0 ticks every frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance", meta = (ClampMin = "0.0"))
+	float ActorTickInterval;
+
+	// Seconds between character movement updates. 0 updates every frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance", meta = (ClampMin = "0.0"))
+	float MovementTickInterval;
+
+	// When the skeletal mesh ticks its animation and refreshes its bones
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance")
+	EVisibilityBasedAnimTickOption MeshAnimTickOption;
+
+	// Lets the skeletal mesh skip animation updates based on its screen size
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance")
+	bool bEnableUpdateRateOptimizations;
+
+	FEnemySignificanceTier()
+	{
+		MaxDistance = 0.0f;
+		MaxEnemies = 0;
+		ActorTickInterval = 0.0f;
+		MovementTickInterval = 0.0f;
+		MeshAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		bEnableUpdateRateOptimizations = false;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct FEnemySignificanceSettings
+{
+	GENERATED_BODY()
+
+public:
+
+	// Significance tiers, most significant first. Enemies go in the first tier they fit, the last tier takes everything left over
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance")
+	TArray<FEnemySignificanceTier> Tiers;
+
+	// Seconds between significance updates
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance", meta = (ClampMin = "0.0"))
+	float UpdateInterval;
+
+	// Enemies no player has seen recently are ranked as if they were this many times further away. Not used on dedicated servers, which render nothing
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Significance", meta = (ClampMin = "1.0"))
+	float OffscreenDistanceScale;
+
+	FEnemySignificanceSettings()
+	{
+		UpdateInterval = 0.25f;
+		OffscreenDistanceScale = 2.0f;
+
+		FEnemySignificanceTier& HighTier = Tiers.AddDefaulted_GetRef();
+		HighTier.MaxDistance = 2500.0f;
+		HighTier.MaxEnemies = 16;
+
+		FEnemySignificanceTier& MediumTier = Tiers.AddDefaulted_GetRef();
+		MediumTier.MaxDistance = 6000.0f;
+		MediumTier.ActorTickInterval = 0.1f;
+		MediumTier.MovementTickInterval = 1.0f / 30.0f;
+		MediumTier.MeshAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		MediumTier.bEnableUpdateRateOptimizations = true;
+
+		FEnemySignificanceTier& LowTier = Tiers.AddDefaulted_GetRef();
+		LowTier.ActorTickInterval = 0.5f;
+		LowTier.MovementTickInterval = 0.1f;
+		LowTier.MeshAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+		LowTier.bEnableUpdateRateOptimizations = true;
+	}
+};
+
+/**
+	Ranks the enemies in the enemy registry by distance to the nearest player and if they were recently rendered, and sorts
+	them into significance tiers. Each tier sets how often its enemies tick, update their movement and animate, so distant
+	and offscreen enemies cost a fraction of the ones fighting the players. Tiers are only applied to enemies that changed tier.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UEnemySignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemySignificanceSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	// Replaces the significance settings. Every enemy has its tier applied again on the next update
+	void SetSignificanceSettings(const FEnemySignificanceSettings& NewSettings);
+
+	// Ranks every enemy and applies tiers right away instead of waiting for the next update
+	void UpdateSignificance();
+
+	// Number of enemies in the tier as of the last update
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	int GetNumEnemiesInTier(int Tier) const;
+
+	// Number of enemies in each tier as of the last update, most significant tier first
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	TArray<int> GetTierCounts() const;
+
+	// Tier the enemy was put in on the last update. INDEX_NONE if it has not been ranked yet
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	int GetEnemyTier(const AActor* Enemy) const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	// Sets the tick intervals and mesh update flags of the tier on the enemy
+	void ApplyTier(AActor* Enemy, int32 Tier) const;
+
+	// If an enemy with the given ranking score can go in the tier
+	bool FitsTier(int32 Tier, float ScoreSquared) const;
+
+	FEnemySignificanceSettings Settings;
+
+	bool bIsInitialized;
+
+	float TimeUntilUpdate;
+
+	// Tier of every enemy ranked on the last update. Weak so a new actor at a recycled address never inherits a stale tier
+	TMap<TWeakObjectPtr<const AActor>, int32> EnemyTiers;
+
+	// EnemyTiers of the update before. Swapped with EnemyTiers every update so neither map reallocates
+	TMap<TWeakObjectPtr<const AActor>, int32> PreviousEnemyTiers;
+
+	TArray<int32> TierCounts;
+
+	// Reused every update so ranking does not allocate
+	TArray<FVector> PlayerLocations;
+	TArray<float> EnemyScores;
+	TArray<int32> RankedEnemyIndices;
+};
@@ -1,6 +1,9 @@
 
 #include "GameCharacterBase.h"
 
+#include "CharacterSpatialHashSubsystem.h"
+#include "../Spawning/EnemyRegistrySubsystem.h"
+
 
 AGameCharacterBase::AGameCharacterBase()
 {
@@ -11,7 +14,24 @@ AGameCharacterBase::AGameCharacterBase()
 
 void AGameCharacterBase::BeginPlay()
 {
-	Super::BeginPlay();	
+	Super::BeginPlay();
+
+	UCharacterSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UCharacterSpatialHashSubsystem>();
+	if (SpatialHash)
+	{
+		SpatialHash->AddCharacter(this);
+	}
+}
+
+void AGameCharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UCharacterSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UCharacterSpatialHashSubsystem>();
+	if (SpatialHash)
+	{
+		SpatialHash->RemoveCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AGameCharacterBase::Tick(float DeltaTime)
@@ -19,6 +39,32 @@ void AGameCharacterBase::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
+void AGameCharacterBase::SetIsAlive(bool bNewIsAlive)
+{
+	if (bIsAlive == bNewIsAlive)
+	{
+		return;
+	}
+
+	bIsAlive = bNewIsAlive;
+
+	UEnemyRegistrySubsystem* EnemyRegistry = GetWorld() ? GetWorld()->GetSubsystem<UEnemyRegistrySubsystem>() : nullptr;
+	if (EnemyRegistry)
+	{
+		EnemyRegistry->NotifyAliveStateChanged(this);
+	}
+}
+
+void AGameCharacterBase::OnPoolActivated_Implementation()
+{
+
+}
+
+void AGameCharacterBase::OnPoolDeactivated_Implementation()
+{
+
+}
+
 void AGameCharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
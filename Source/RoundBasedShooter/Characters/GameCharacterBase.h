@@ -18,14 +18,28 @@ public:
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
-	// If the character is alive or not
-	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category = "Character");
+	// If the character is alive or not. Set through SetIsAlive so the enemy registry can keep its alive count up to date
+	UPROPERTY(BlueprintReadWrite, BlueprintSetter = SetIsAlive, EditDefaultsOnly, Category = "Character");
 	bool bIsAlive;
 
+	// Sets if the character is alive or not
+	UFUNCTION(BlueprintSetter)
+	void SetIsAlive(bool bNewIsAlive);
+
+	// Called when the character is taken from the enemy pool and placed back in the level. Reset any per life state here
+	UFUNCTION(BlueprintNativeEvent, Category = "Pooling")
+	void OnPoolActivated();
+
+	// Called when the character is deactivated and returned to the enemy pool
+	UFUNCTION(BlueprintNativeEvent, Category = "Pooling")
+	void OnPoolDeactivated();
+
 protected:
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 		
 
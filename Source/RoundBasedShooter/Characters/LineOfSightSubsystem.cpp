@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LineOfSightSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+
+ULineOfSightSubsystem::ULineOfSightSubsystem()
+{
+	MaxTracesPerFrame = 16;
+	CacheLifetime = 0.25f;
+	ResultLifetime = 2.0f;
+	EyeHeight = 100.0f;
+	TraceChannel = ECC_Visibility;
+	bIsInitialized = false;
+	NextRequestId = 1;
+	TimeUntilPurge = 0.0f;
+}
+
+void ULineOfSightSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &ULineOfSightSubsystem::OnTraceCompleted);
+	bIsInitialized = true;
+}
+
+void ULineOfSightSubsystem::Deinitialize()
+{
+	bIsInitialized = false;
+	TraceDelegate.Unbind();
+	Requests.Empty();
+	QueuedRequestIds.Empty();
+	Cache.Empty();
+	PrefetchPairs.Empty();
+
+	Super::Deinitialize();
+}
+
+FLineOfSightHandle ULineOfSightSubsystem::RequestLineOfSight(const AActor* From, const AActor* To)
+{
+	FLineOfSightHandle Handle;
+	Handle.Id = AddRequest(From, To, FOnLineOfSightResult(), true, false);
+	return Handle;
+}
+
+void ULineOfSightSubsystem::RequestLineOfSightWithCallback(const AActor* From, const AActor* To, FOnLineOfSightResult OnResult)
+{
+	AddRequest(From, To, MoveTemp(OnResult), false, false);
+}
+
+void ULineOfSightSubsystem::PrefetchLineOfSight(const AActor* From, const AActor* To)
+{
+	bool bHasLineOfSight;
+	if (GetCachedLineOfSight(From, To, bHasLineOfSight) || PrefetchPairs.Contains(FActorPair(From, To)))
+	{
+		return;
+	}
+
+	if (AddRequest(From, To, FOnLineOfSightResult(), false, true) != 0)
+	{
+		PrefetchPairs.Add(FActorPair(From, To));
+	}
+}
+
+ELineOfSightStatus ULineOfSightSubsystem::PollLineOfSight(FLineOfSightHandle Handle)
+{
+	const FLineOfSightRequest* Request = Requests.Find(Handle.Id);
+	if (!Request)
+	{
+		return ELineOfSightStatus::Invalid;
+	}
+
+	const ELineOfSightStatus Status = Request->Status;
+	if (Status != ELineOfSightStatus::Pending)
+	{
+		Requests.Remove(Handle.Id);
+	}
+
+	return Status;
+}
+
+bool ULineOfSightSubsystem::GetCachedLineOfSight(const AActor* From, const AActor* To, bool& bOutHasLineOfSight) const
+{
+	const FCachedLineOfSight* CachedLineOfSight = Cache.Find(FActorPair(From, To));
+	if (!CachedLineOfSight || GetWorld()->GetTimeSeconds() - CachedLineOfSight->Time > CacheLifetime)
+	{
+		return false;
+	}
+
+	bOutHasLineOfSight = CachedLineOfSight->bHasLineOfSight;
+	return true;
+}
+
+uint32 ULineOfSightSubsystem::AddRequest(const AActor* From, const AActor* To, FOnLineOfSightResult OnResult, bool bKeepResult, bool bIsPrefetch)
+{
+	if (!IsValid(From) || !IsValid(To))
+	{
+		return 0;
+	}
+
+	const uint32 RequestId = NextRequestId;
+
+	// Skip 0 so it can stay the invalid handle
+	NextRequestId = NextRequestId == MAX_uint32 ? 1 : NextRequestId + 1;
+
+	FLineOfSightRequest& Request = Requests.Add(RequestId);
+	Request.Actors = FActorPair(From, To);
+	Request.Status = ELineOfSightStatus::Pending;
+	Request.OnResult = MoveTemp(OnResult);
+	Request.bKeepResult = bKeepResult;
+	Request.bIsPrefetch = bIsPrefetch;
+	Request.CompletedTime = 0.0f;
+
+	QueuedRequestIds.Add(RequestId);
+
+	return RequestId;
+}
+
+void ULineOfSightSubsystem::SubmitRequest(uint32 RequestId)
+{
+	const FLineOfSightRequest* Request = Requests.Find(RequestId);
+	if (!Request)
+	{
+		return;
+	}
+
+	const AActor* From = Request->Actors.Key.Get();
+	const AActor* To = Request->Actors.Value.Get();
+
+	// An actor that has gone away can not be seen
+	if (!From || !To)
+	{
+		CompleteRequest(RequestId, false);
+		return;
+	}
+
+	bool bHasLineOfSight;
+	if (GetCachedLineOfSight(From, To, bHasLineOfSight))
+	{
+		CompleteRequest(RequestId, bHasLineOfSight);
+		return;
+	}
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LineOfSight), false);
+	QueryParams.AddIgnoredActor(From);
+	QueryParams.AddIgnoredActor(To);
+
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Test, GetLineOfSightLocation(From), GetLineOfSightLocation(To), TraceChannel, QueryParams,
+		FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, RequestId);
+}
+
+void ULineOfSightSubsystem::CompleteRequest(uint32 RequestId, bool bHasLineOfSight)
+{
+	FLineOfSightRequest* Request = Requests.Find(RequestId);
+	if (!Request)
+	{
+		return;
+	}
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	FCachedLineOfSight& CachedLineOfSight = Cache.FindOrAdd(Request->Actors);
+	CachedLineOfSight.bHasLineOfSight = bHasLineOfSight;
+	CachedLineOfSight.Time = CurrentTime;
+
+	if (Request->bIsPrefetch)
+	{
+		PrefetchPairs.Remove(Request->Actors);
+	}
+
+	if (Request->bKeepResult)
+	{
+		Request->Status = bHasLineOfSight ? ELineOfSightStatus::Visible : ELineOfSightStatus::Blocked;
+		Request->CompletedTime = CurrentTime;
+		return;
+	}
+
+	// Take the callback out first as it may add requests, which can move the request in the map
+	FOnLineOfSightResult OnResult = MoveTemp(Request->OnResult);
+	Requests.Remove(RequestId);
+	OnResult.ExecuteIfBound(bHasLineOfSight);
+}
+
+void ULineOfSightSubsystem::OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (!bIsInitialized)
+	{
+		return;
+	}
+
+	// Test traces only report a hit when something blocked the line
+	CompleteRequest(TraceDatum.UserData, TraceDatum.OutHits.Num() == 0);
+}
+
+FVector ULineOfSightSubsystem::GetLineOfSightLocation(const AActor* Actor) const
+{
+	const APawn* Pawn = Cast<APawn>(Actor);
+	if (Pawn)
+	{
+		return Pawn->GetPawnViewLocation();
+	}
+
+	return Actor->GetActorLocation() + FVector(0.0f, 0.0f, EyeHeight);
+}
+
+void ULineOfSightSubsystem::PurgeExpired()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (auto RequestIt = Requests.CreateIterator(); RequestIt; ++RequestIt)
+	{
+		if (RequestIt.Value().Status != ELineOfSightStatus::Pending && CurrentTime - RequestIt.Value().CompletedTime > ResultLifetime)
+		{
+			RequestIt.RemoveCurrent();
+		}
+	}
+
+	for (auto CacheIt = Cache.CreateIterator(); CacheIt; ++CacheIt)
+	{
+		if (CurrentTime - CacheIt.Value().Time > CacheLifetime)
+		{
+			CacheIt.RemoveCurrent();
+		}
+	}
+}
+
+void ULineOfSightSubsystem::Tick(float DeltaTime)
+{
+	const int32 NumToSubmit = FMath::Min(QueuedRequestIds.Num(), FMath::Max(MaxTracesPerFrame, 1));
+
+	// Requests answered from the cache do not trace, but still count towards the cap to keep the frame cost flat
+	for (int32 QueueIndex = 0; QueueIndex < NumToSubmit; QueueIndex++)
+	{
+		SubmitRequest(QueuedRequestIds[QueueIndex]);
+	}
+
+	QueuedRequestIds.RemoveAt(0, NumToSubmit, false);
+
+	TimeUntilPurge -= DeltaTime;
+	if (TimeUntilPurge <= 0.0f)
+	{
+		TimeUntilPurge = FMath::Max(CacheLifetime, 0.1f);
+		PurgeExpired();
+	}
+}
+
+bool ULineOfSightSubsystem::IsTickable() const
+{
+	return bIsInitialized && (QueuedRequestIds.Num() > 0 || Requests.Num() > 0 || Cache.Num() > 0);
+}
+
+ETickableTickType ULineOfSightSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* ULineOfSightSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId ULineOfSightSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULineOfSightSubsystem, STATGROUP_Tickables);
+}
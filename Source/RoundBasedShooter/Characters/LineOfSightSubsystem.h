@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "LineOfSightSubsystem.generated.h"
+
+// Where a line of sight request is at
+UENUM(BlueprintType)
+enum class ELineOfSightStatus : uint8
+{
+	Invalid UMETA(DisplayName = "Invalid"),
+	Pending UMETA(DisplayName = "Pending"),
+	Visible UMETA(DisplayName = "Visible"),
+	Blocked UMETA(DisplayName = "Blocked")
+};
+
+// Identifies a line of sight request so its result can be polled
+USTRUCT(BlueprintType)
+struct FLineOfSightHandle
+{
+	GENERATED_BODY()
+
+public:
+
+	FLineOfSightHandle()
+	{
+		Id = 0;
+	}
+
+	bool IsValid() const
+	{
+		return Id != 0;
+	}
+
+	UPROPERTY()
+	uint32 Id;
+};
+
+// Called with the result of a line of sight request. True if nothing blocked the line
+DECLARE_DELEGATE_OneParam(FOnLineOfSightResult, bool);
+
+/**
+	Answers line of sight questions between two actors without tracing on the game thread. Requests are queued, submitted as
+	async line traces up to a per frame cap, and answered the frame after through a callback or a polled handle.
+	Answers are cached per actor pair for a short time, so repeated questions about the same pair do not trace at all.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API ULineOfSightSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	ULineOfSightSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+		Queues a line of sight check between two actors. Traces from and to the pawns' view locations, or EyeHeight above
+		other actors. Neither actor blocks the trace.
+		@param From - Actor looking
+		@param To - Actor being looked at
+		@return Handle to poll the result with. Results not polled are dropped after ResultLifetime seconds
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Line Of Sight")
+	FLineOfSightHandle RequestLineOfSight(const AActor* From, const AActor* To);
+
+	// Same as RequestLineOfSight, but calls OnResult once the result is in instead of keeping it for polling
+	void RequestLineOfSightWithCallback(const AActor* From, const AActor* To, FOnLineOfSightResult OnResult);
+
+	/**
+		Queues a line of sight check only to fill the cache, for callers that read results with GetCachedLineOfSight.
+		Does nothing if the pair already has a fresh cached result or a prefetch queued.
+	*/
+	void PrefetchLineOfSight(const AActor* From, const AActor* To);
+
+	/**
+		Gets the result of a request. Once a Visible or Blocked result has been returned the handle is released and polls as Invalid.
+		@param Handle - Handle from RequestLineOfSight
+		@return Pending until the trace has run
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Line Of Sight")
+	ELineOfSightStatus PollLineOfSight(FLineOfSightHandle Handle);
+
+	/**
+		Gets a cached result for the pair without queueing anything.
+		@param bOutHasLineOfSight - The cached result
+		@return True if there is a result younger than CacheLifetime
+	*/
+	bool GetCachedLineOfSight(const AActor* From, const AActor* To, bool& bOutHasLineOfSight) const;
+
+	// Max number of async traces submitted per frame. The rest wait in the queue
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line Of Sight")
+	int MaxTracesPerFrame;
+
+	// Seconds a result is reused for the same pair of actors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line Of Sight")
+	float CacheLifetime;
+
+	// Seconds a finished result waits to be polled before it is dropped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line Of Sight")
+	float ResultLifetime;
+
+	// Height above the actor location lines are traced from for actors that are not pawns, e.g. spawn points
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line Of Sight")
+	float EyeHeight;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line Of Sight")
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	typedef TPair<TWeakObjectPtr<const AActor>, TWeakObjectPtr<const AActor>> FActorPair;
+
+	struct FLineOfSightRequest
+	{
+		FActorPair Actors;
+
+		ELineOfSightStatus Status;
+
+		// Called with the result when bound
+		FOnLineOfSightResult OnResult;
+
+		// Keep the result around for polling
+		bool bKeepResult;
+
+		// Queued by PrefetchLineOfSight
+		bool bIsPrefetch;
+
+		// World time the result came in
+		float CompletedTime;
+	};
+
+	struct FCachedLineOfSight
+	{
+		bool bHasLineOfSight;
+
+		// World time the result came in
+		float Time;
+	};
+
+	uint32 AddRequest(const AActor* From, const AActor* To, FOnLineOfSightResult OnResult, bool bKeepResult, bool bIsPrefetch);
+
+	// Submits the request's trace. Answers it straight from the cache instead if it can
+	void SubmitRequest(uint32 RequestId);
+
+	// Caches the result, calls the request's callback and keeps the result for polling if asked to
+	void CompleteRequest(uint32 RequestId, bool bHasLineOfSight);
+
+	// Bound to every submitted trace. The request id travels in the trace's user data
+	void OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	FVector GetLineOfSightLocation(const AActor* Actor) const;
+
+	// Drops unpolled results and stale cache entries
+	void PurgeExpired();
+
+	bool bIsInitialized;
+
+	uint32 NextRequestId;
+
+	TMap<uint32, FLineOfSightRequest> Requests;
+
+	// Requests waiting for a trace, oldest first
+	TArray<uint32> QueuedRequestIds;
+
+	TMap<FActorPair, FCachedLineOfSight> Cache;
+
+	// Pairs with a prefetch queued or in flight
+	TSet<FActorPair> PrefetchPairs;
+
+	FTraceDelegate TraceDelegate;
+
+	float TimeUntilPurge;
+};
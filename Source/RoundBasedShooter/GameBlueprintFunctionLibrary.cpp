@@ -4,28 +4,419 @@
 #include "GameBlueprintFunctionLibrary.h"
 
 #include "Math/NumericLimits.h"
+#include "Math/VectorRegister.h"
+#include "Misc/MemStack.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
 #include "Kismet/GameplayStatics.h"
 
 
-void UGameBlueprintFunctionLibrary::SortActorsByDistanceToTarget(TArray<AActor*> Actors, FVector TargetLocation, AActor*& ClosestActor)
-{	
+namespace
+{
+	// Locations of the valid actors of an actor array as a structure of arrays on the memory stack. Needs an FMemMark in the calling scope
+	struct FActorPositions
+	{
+		TArray<float, TMemStackAllocator<>> PositionsX;
+		TArray<float, TMemStackAllocator<>> PositionsY;
+		TArray<float, TMemStackAllocator<>> PositionsZ;
+
+		// Index in the actor array of every gathered position
+		TArray<int32, TMemStackAllocator<>> ActorIndices;
+
+		explicit FActorPositions(const TArray<AActor*>& Actors)
+		{
+			PositionsX.Reserve(Actors.Num());
+			PositionsY.Reserve(Actors.Num());
+			PositionsZ.Reserve(Actors.Num());
+			ActorIndices.Reserve(Actors.Num());
+
+			for (int32 ActorIndex = 0; ActorIndex < Actors.Num(); ActorIndex++)
+			{
+				const AActor* FoundActor = Actors[ActorIndex];
+				if (!IsValid(FoundActor))
+				{
+					continue;
+				}
+
+				const FVector ActorLocation = FoundActor->GetActorLocation();
+				PositionsX.Add(ActorLocation.X);
+				PositionsY.Add(ActorLocation.Y);
+				PositionsZ.Add(ActorLocation.Z);
+				ActorIndices.Add(ActorIndex);
+			}
+		}
+
+		int32 Num() const
+		{
+			return ActorIndices.Num();
+		}
+
+		// Turns point indices back into actors
+		void GetActors(const TArray<AActor*>& Actors, const TArray<int32>& PointIndices, TArray<AActor*>& OutActors) const
+		{
+			OutActors.Reset(PointIndices.Num());
+			for (int32 PointIndex : PointIndices)
+			{
+				OutActors.Add(Actors[ActorIndices[PointIndex]]);
+			}
+		}
+	};
+
+	// Point indices handed back by the Blueprint queries. Kept around so the queries only allocate when they see more points than ever before
+	TArray<int32>& GetQueryIndexScratch()
+	{
+		check(IsInGameThread());
+		static TArray<int32> QueryIndices;
+		return QueryIndices;
+	}
+}
+
+void UGameBlueprintFunctionLibrary::SortActorsByDistanceToTarget(const TArray<AActor*>& Actors, const FVector& TargetLocation, AActor*& ClosestActor)
+{
 	ClosestActor = nullptr;
-	float ClosestDistance = TNumericLimits<float>::Max();
 
-	for (AActor* FoundActor : Actors)
+	// Gather the valid actor locations into contiguous buffers so the kernel can stream through them
+	FMemMark Mark(FMemStack::Get());
+	const FActorPositions ActorPositions(Actors);
+
+	float ClosestDistanceSquared;
+	const int32 ClosestIndex = FindNearestPoint(ActorPositions.PositionsX.GetData(), ActorPositions.PositionsY.GetData(), ActorPositions.PositionsZ.GetData(), ActorPositions.Num(), TargetLocation, ClosestDistanceSquared);
+
+	if (ClosestIndex != INDEX_NONE)
+	{
+		ClosestActor = Actors[ActorPositions.ActorIndices[ClosestIndex]];
+	}
+}
+
+void UGameBlueprintFunctionLibrary::GetKNearestActors(const TArray<AActor*>& Actors, const FVector& TargetLocation, int K, TArray<AActor*>& OutActors)
+{
+	FMemMark Mark(FMemStack::Get());
+	const FActorPositions ActorPositions(Actors);
+
+	TArray<int32>& PointIndices = GetQueryIndexScratch();
+	FindKNearestPoints(ActorPositions.PositionsX.GetData(), ActorPositions.PositionsY.GetData(), ActorPositions.PositionsZ.GetData(), ActorPositions.Num(), TargetLocation, K, PointIndices);
+	ActorPositions.GetActors(Actors, PointIndices, OutActors);
+}
+
+void UGameBlueprintFunctionLibrary::GetActorsInRadius(const TArray<AActor*>& Actors, const FVector& TargetLocation, float Radius, TArray<AActor*>& OutActors)
+{
+	FMemMark Mark(FMemStack::Get());
+	const FActorPositions ActorPositions(Actors);
+
+	TArray<int32>& PointIndices = GetQueryIndexScratch();
+	FindPointsInRadius(ActorPositions.PositionsX.GetData(), ActorPositions.PositionsY.GetData(), ActorPositions.PositionsZ.GetData(), ActorPositions.Num(), TargetLocation, Radius, PointIndices);
+	ActorPositions.GetActors(Actors, PointIndices, OutActors);
+}
+
+void UGameBlueprintFunctionLibrary::SortActorsByDistance(const TArray<AActor*>& Actors, const FVector& TargetLocation, TArray<AActor*>& OutSortedActors)
+{
+	FMemMark Mark(FMemStack::Get());
+	const FActorPositions ActorPositions(Actors);
+
+	TArray<int32>& PointIndices = GetQueryIndexScratch();
+	SortPointsByDistance(ActorPositions.PositionsX.GetData(), ActorPositions.PositionsY.GetData(), ActorPositions.PositionsZ.GetData(), ActorPositions.Num(), TargetLocation, PointIndices);
+	ActorPositions.GetActors(Actors, PointIndices, OutSortedActors);
+}
+
+AGameCharacterBase* UGameBlueprintFunctionLibrary::GetNearestCharacter(const UObject* WorldContextObject, const FVector& TargetLocation, float MaxDistance, ECharacterQueryFilter Filter)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UCharacterSpatialHashSubsystem* SpatialHash = World ? World->GetSubsystem<UCharacterSpatialHashSubsystem>() : nullptr;
+
+	return SpatialHash ? SpatialHash->FindNearest(TargetLocation, MaxDistance, Filter) : nullptr;
+}
+
+void UGameBlueprintFunctionLibrary::GetCharactersInRadius(const UObject* WorldContextObject, const FVector& TargetLocation, float Radius, ECharacterQueryFilter Filter, TArray<AGameCharacterBase*>& OutCharacters)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UCharacterSpatialHashSubsystem* SpatialHash = World ? World->GetSubsystem<UCharacterSpatialHashSubsystem>() : nullptr;
+
+	if (!SpatialHash)
 	{
-		FVector DistanceVector = FoundActor->GetActorLocation() - TargetLocation;
-		float DistanceToTarget = DistanceVector.Size();
+		OutCharacters.Reset();
+		return;
+	}
+
+	SpatialHash->QuerySphere(TargetLocation, Radius, Filter, OutCharacters);
+}
+
+int32 UGameBlueprintFunctionLibrary::FindNearestPoint(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, float& OutDistanceSquared)
+{
+	OutDistanceSquared = TNumericLimits<float>::Max();
+	int32 ClosestIndex = INDEX_NONE;
+
+	const int32 NumVectorPoints = NumPoints & ~3;
 
-		if (DistanceToTarget < ClosestDistance)
+	if (NumVectorPoints > 0)
+	{
+		const VectorRegister TargetX = VectorSetFloat1(TargetLocation.X);
+		const VectorRegister TargetY = VectorSetFloat1(TargetLocation.Y);
+		const VectorRegister TargetZ = VectorSetFloat1(TargetLocation.Z);
+		const VectorRegister IndexStep = VectorSetFloat1(4.0f);
+
+		// Each lane keeps its own best distance and index. Indices are kept as floats, which is exact well past any actor count
+		VectorRegister BestDistancesSquared = VectorSetFloat1(TNumericLimits<float>::Max());
+		VectorRegister BestIndices = VectorSetFloat1(-1.0f);
+		VectorRegister LaneIndices = MakeVectorRegister(0.0f, 1.0f, 2.0f, 3.0f);
+
+		for (int32 PointIndex = 0; PointIndex < NumVectorPoints; PointIndex += 4)
 		{
-			ClosestDistance = DistanceToTarget;
-			ClosestActor = FoundActor;
+			const VectorRegister DeltaX = VectorSubtract(VectorLoad(PositionsX + PointIndex), TargetX);
+			const VectorRegister DeltaY = VectorSubtract(VectorLoad(PositionsY + PointIndex), TargetY);
+			const VectorRegister DeltaZ = VectorSubtract(VectorLoad(PositionsZ + PointIndex), TargetZ);
+
+			const VectorRegister DistancesSquared = VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaZ, DeltaZ)));
+
+			const VectorRegister IsCloser = VectorCompareLT(DistancesSquared, BestDistancesSquared);
+			BestDistancesSquared = VectorSelect(IsCloser, DistancesSquared, BestDistancesSquared);
+			BestIndices = VectorSelect(IsCloser, LaneIndices, BestIndices);
+
+			LaneIndices = VectorAdd(LaneIndices, IndexStep);
+		}
+
+		float LaneDistancesSquared[4];
+		float LaneIndexValues[4];
+		VectorStore(BestDistancesSquared, LaneDistancesSquared);
+		VectorStore(BestIndices, LaneIndexValues);
+
+		// Pick the best lane. Ties go to the lowest index, which matches a plain front to back scan
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			const int32 LaneIndex = (int32)LaneIndexValues[Lane];
+			if (LaneIndex == INDEX_NONE)
+			{
+				continue;
+			}
+
+			if (LaneDistancesSquared[Lane] < OutDistanceSquared || (LaneDistancesSquared[Lane] == OutDistanceSquared && LaneIndex < ClosestIndex))
+			{
+				OutDistanceSquared = LaneDistancesSquared[Lane];
+				ClosestIndex = LaneIndex;
+			}
+		}
+	}
+
+	// Up to three points left over that do not fill a vector
+	for (int32 PointIndex = NumVectorPoints; PointIndex < NumPoints; PointIndex++)
+	{
+		const float DistanceSquared = FVector::DistSquared(FVector(PositionsX[PointIndex], PositionsY[PointIndex], PositionsZ[PointIndex]), TargetLocation);
+		if (DistanceSquared < OutDistanceSquared)
+		{
+			OutDistanceSquared = DistanceSquared;
+			ClosestIndex = PointIndex;
 		}
 	}
 
-	return;
+	return ClosestIndex;
 }
 
+void UGameBlueprintFunctionLibrary::FindKNearestPoints(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, int32 K, TArray<int32>& OutIndices)
+{
+	OutIndices.Reset();
 
+	K = FMath::Min(K, NumPoints);
+	if (K <= 0)
+	{
+		return;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+	float* DistancesSquared = New<float>(FMemStack::Get(), NumPoints);
+	ComputeDistancesSquared(PositionsX, PositionsY, PositionsZ, NumPoints, TargetLocation, DistancesSquared);
+
+	// Ties go to the lower index so results match a stable sort
+	auto IsCloser = [DistancesSquared](int32 A, int32 B)
+	{
+		return DistancesSquared[A] < DistancesSquared[B] || (DistancesSquared[A] == DistancesSquared[B] && A < B);
+	};
+
+	auto IsFurther = [&IsCloser](int32 A, int32 B)
+	{
+		return IsCloser(B, A);
+	};
 
+	// Keep the K closest points so far in a heap with the furthest of them on top, so each point costs at most O(log K)
+	for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+	{
+		if (OutIndices.Num() < K)
+		{
+			OutIndices.HeapPush(PointIndex, IsFurther);
+		}
+		else if (IsCloser(PointIndex, OutIndices.HeapTop()))
+		{
+			OutIndices.HeapPopDiscard(IsFurther, false);
+			OutIndices.HeapPush(PointIndex, IsFurther);
+		}
+	}
+
+	OutIndices.Sort(IsCloser);
+}
+
+void UGameBlueprintFunctionLibrary::FindPointsInRadius(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, float Radius, TArray<int32>& OutIndices)
+{
+	OutIndices.Reset();
+
+	if (NumPoints <= 0 || Radius < 0.0f)
+	{
+		return;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+	float* DistancesSquared = New<float>(FMemStack::Get(), NumPoints);
+	ComputeDistancesSquared(PositionsX, PositionsY, PositionsZ, NumPoints, TargetLocation, DistancesSquared);
+
+	const float RadiusSquared = FMath::Square(Radius);
+	for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+	{
+		if (DistancesSquared[PointIndex] <= RadiusSquared)
+		{
+			OutIndices.Add(PointIndex);
+		}
+	}
+}
+
+void UGameBlueprintFunctionLibrary::SortPointsByDistance(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, TArray<int32>& OutIndices)
+{
+	OutIndices.Reset();
+
+	if (NumPoints <= 0)
+	{
+		return;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+	float* DistancesSquared = New<float>(FMemStack::Get(), NumPoints);
+	ComputeDistancesSquared(PositionsX, PositionsY, PositionsZ, NumPoints, TargetLocation, DistancesSquared);
+
+	OutIndices.SetNumUninitialized(NumPoints, false);
+	for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+	{
+		OutIndices[PointIndex] = PointIndex;
+	}
+
+	// Distances are worked out once up front so the sort only compares floats
+	OutIndices.Sort([DistancesSquared](int32 A, int32 B)
+	{
+		return DistancesSquared[A] < DistancesSquared[B] || (DistancesSquared[A] == DistancesSquared[B] && A < B);
+	});
+}
+
+void UGameBlueprintFunctionLibrary::ComputeDistancesSquared(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, float* OutDistancesSquared)
+{
+	auto ComputeRange = [=](int32 FirstPoint, int32 EndPoint)
+	{
+		const VectorRegister TargetX = VectorSetFloat1(TargetLocation.X);
+		const VectorRegister TargetY = VectorSetFloat1(TargetLocation.Y);
+		const VectorRegister TargetZ = VectorSetFloat1(TargetLocation.Z);
+
+		int32 PointIndex = FirstPoint;
+		for (; PointIndex + 4 <= EndPoint; PointIndex += 4)
+		{
+			const VectorRegister DeltaX = VectorSubtract(VectorLoad(PositionsX + PointIndex), TargetX);
+			const VectorRegister DeltaY = VectorSubtract(VectorLoad(PositionsY + PointIndex), TargetY);
+			const VectorRegister DeltaZ = VectorSubtract(VectorLoad(PositionsZ + PointIndex), TargetZ);
+
+			VectorStore(VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaZ, DeltaZ))), OutDistancesSquared + PointIndex);
+		}
+
+		for (; PointIndex < EndPoint; PointIndex++)
+		{
+			OutDistancesSquared[PointIndex] = FVector::DistSquared(FVector(PositionsX[PointIndex], PositionsY[PointIndex], PositionsZ[PointIndex]), TargetLocation);
+		}
+	};
+
+	if (NumPoints < ParallelQueryMinPoints)
+	{
+		ComputeRange(0, NumPoints);
+		return;
+	}
+
+	// Chunks are a multiple of four points so every chunk but the last stays on the SIMD path
+	const int32 PointsPerChunk = 4096;
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumPoints, PointsPerChunk);
+
+	ParallelFor(NumChunks, [&ComputeRange, NumPoints, PointsPerChunk](int32 ChunkIndex)
+	{
+		const int32 FirstPoint = ChunkIndex * PointsPerChunk;
+		ComputeRange(FirstPoint, FMath::Min(FirstPoint + PointsPerChunk, NumPoints));
+	});
+}
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// The loop SortActorsByDistanceToTarget used before, minus the actor lookups
+	int32 FindNearestPointScalar(const TArray<FVector>& Positions, const FVector& TargetLocation)
+	{
+		int32 ClosestIndex = INDEX_NONE;
+		float ClosestDistance = TNumericLimits<float>::Max();
+
+		for (int32 PointIndex = 0; PointIndex < Positions.Num(); PointIndex++)
+		{
+			const float DistanceToTarget = (Positions[PointIndex] - TargetLocation).Size();
+			if (DistanceToTarget < ClosestDistance)
+			{
+				ClosestDistance = DistanceToTarget;
+				ClosestIndex = PointIndex;
+			}
+		}
+
+		return ClosestIndex;
+	}
+
+	void BenchmarkNearestPoint(const TArray<FString>& Args)
+	{
+		const int32 NumIterations = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+		const FRandomStream RandomStream(1234);
+
+		for (int32 NumPoints : { 100, 1000, 10000 })
+		{
+			TArray<FVector> Positions;
+			TArray<float> PositionsX;
+			TArray<float> PositionsY;
+			TArray<float> PositionsZ;
+
+			for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+			{
+				const FVector Position = RandomStream.VRand() * RandomStream.FRandRange(0.0f, 10000.0f);
+				Positions.Add(Position);
+				PositionsX.Add(Position.X);
+				PositionsY.Add(Position.Y);
+				PositionsZ.Add(Position.Z);
+			}
+
+			// Summed so the compiler cannot drop the queries, and compared so a wrong kernel shows up here too
+			int64 ScalarChecksum = 0;
+			int64 SimdChecksum = 0;
+
+			const double ScalarStartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+			{
+				ScalarChecksum += FindNearestPointScalar(Positions, Positions[Iteration % NumPoints] + FVector(1.0f));
+			}
+			const double ScalarSeconds = FPlatformTime::Seconds() - ScalarStartTime;
+
+			const double SimdStartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+			{
+				float DistanceSquared;
+				SimdChecksum += UGameBlueprintFunctionLibrary::FindNearestPoint(PositionsX.GetData(), PositionsY.GetData(), PositionsZ.GetData(), NumPoints, Positions[Iteration % NumPoints] + FVector(1.0f), DistanceSquared);
+			}
+			const double SimdSeconds = FPlatformTime::Seconds() - SimdStartTime;
+
+			UE_LOG(LogTemp, Display, TEXT("FindNearestPoint %5d points: scalar %8.3f us, SIMD %8.3f us, %.1fx%s"),
+				NumPoints,
+				ScalarSeconds * 1000000.0 / NumIterations,
+				SimdSeconds * 1000000.0 / NumIterations,
+				SimdSeconds > 0.0 ? ScalarSeconds / SimdSeconds : 0.0,
+				ScalarChecksum == SimdChecksum ? TEXT("") : TEXT(" (results differ!)"));
+		}
+	}
+
+	FAutoConsoleCommand BenchmarkNearestPointCommand(
+		TEXT("Game.BenchmarkNearestPoint"),
+		TEXT("Times FindNearestPoint against the old scalar closest actor loop at 100, 1k and 10k points. Optional argument: number of queries"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkNearestPoint));
+}
+#endif
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Characters/CharacterSpatialHashSubsystem.h"
 
 
 #include "GameBlueprintFunctionLibrary.generated.h"
@@ -12,14 +13,101 @@ UCLASS()
 class ROUNDBASEDSHOOTER_API UGameBlueprintFunctionLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_BODY()
+
+public:
+
 	/**
 		Finds the actor that is closest to the target location. Does not change the order of the input array of actors!
+		Null and pending kill actors are skipped.
 		@param Actors - The TArray of actors that will be checked
 		@param TargetLocation - Find the actor closest to this target location
-		@param MaxDistance - The starting distance for the sort algorithm. Strongly advise this to be a high number!
-		@param ClosestActor - Returned actor that is closest to the target location
+		@param ClosestActor - Returned actor that is closest to the target location. Null if there were no valid actors
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Sorting")
+	static void SortActorsByDistanceToTarget(const TArray<AActor*>& Actors, const FVector& TargetLocation, AActor* &ClosestActor);
+
+	/**
+		Finds the point closest to the target location in a structure of arrays position buffer. Compares squared distances four points at a time with SIMD.
+		The buffers do not need any alignment or padding.
+		@param PositionsX - X of every point
+		@param PositionsY - Y of every point
+		@param PositionsZ - Z of every point
+		@param NumPoints - Number of points in each buffer
+		@param TargetLocation - Find the point closest to this target location
+		@param OutDistanceSquared - Squared distance of the closest point
+		@return Index of the closest point. INDEX_NONE if there are no points
+	*/
+	static int32 FindNearestPoint(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, float& OutDistanceSquared);
+
+	/**
+		Finds the K actors closest to the target location, closest first. Null and pending kill actors are skipped.
+		@param Actors - The TArray of actors that will be checked
+		@param TargetLocation - Find the actors closest to this target location
+		@param K - Max number of actors returned
+		@param OutActors - Returned closest actors. Emptied first
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Sorting")
+	static void GetKNearestActors(const TArray<AActor*>& Actors, const FVector& TargetLocation, int K, TArray<AActor*>& OutActors);
+
+	/**
+		Finds every actor within the radius of the target location. Keeps the order of the input array. Null and pending kill actors are skipped.
+		@param Actors - The TArray of actors that will be checked
+		@param TargetLocation - Center of the radius
+		@param Radius - Actors further than this from the target location are left out
+		@param OutActors - Returned actors in the radius. Emptied first
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Sorting")
+	static void GetActorsInRadius(const TArray<AActor*>& Actors, const FVector& TargetLocation, float Radius, TArray<AActor*>& OutActors);
+
+	/**
+		Sorts the actors by distance to the target location, closest first. Does not change the order of the input array of actors!
+		Null and pending kill actors are skipped.
+		@param Actors - The TArray of actors that will be sorted
+		@param TargetLocation - Sort by distance to this target location
+		@param OutSortedActors - Returned sorted actors. Emptied first
 	*/
 	UFUNCTION(BlueprintCallable, Category = "Sorting")
-	static void SortActorsByDistanceToTarget(const TArray<AActor*> Actors,const FVector TargetLocation, AActor* &ClosestActor);
+	static void SortActorsByDistance(const TArray<AActor*>& Actors, const FVector& TargetLocation, TArray<AActor*>& OutSortedActors);
+
+	/**
+		Finds the character closest to the target location using the character spatial hash, without looking at any other characters.
+		@param TargetLocation - Find the character closest to this target location
+		@param MaxDistance - Characters further than this are ignored. 0 for no limit
+		@param Filter - Which characters to consider
+		@return The closest character. Null if none were found
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Sorting", meta = (WorldContext = "WorldContextObject"))
+	static AGameCharacterBase* GetNearestCharacter(const UObject* WorldContextObject, const FVector& TargetLocation, float MaxDistance, ECharacterQueryFilter Filter);
+
+	/**
+		Finds every character within the radius of the target location using the character spatial hash.
+		@param TargetLocation - Center of the radius
+		@param Radius - Characters further than this from the target location are left out
+		@param Filter - Which characters to return
+		@param OutCharacters - Returned characters in no particular order. Emptied first
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Sorting", meta = (WorldContext = "WorldContextObject"))
+	static void GetCharactersInRadius(const UObject* WorldContextObject, const FVector& TargetLocation, float Radius, ECharacterQueryFilter Filter, TArray<AGameCharacterBase*>& OutCharacters);
+
+	// Point queries with at least this many points work out distances with ParallelFor
+	static constexpr int32 ParallelQueryMinPoints = 8192;
+
+	/**
+		Finds the indices of the K points closest to the target location, closest first. Uses a bounded heap, so only the K closest
+		points are ever sorted. Scratch memory comes from the memory stack and OutIndices keeps its allocation, so repeated calls do not allocate.
+	*/
+	static void FindKNearestPoints(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, int32 K, TArray<int32>& OutIndices);
+
+	// Finds the indices of the points within the radius of the target location, in point order. Repeated calls do not allocate
+	static void FindPointsInRadius(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, float Radius, TArray<int32>& OutIndices);
+
+	// Sorts the indices of all points by distance to the target location, closest first. Repeated calls do not allocate
+	static void SortPointsByDistance(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, TArray<int32>& OutIndices);
+
+	/**
+		Writes the squared distance of every point to the target location into OutDistancesSquared, four points at a time with SIMD.
+		Splits the work with ParallelFor from ParallelQueryMinPoints points.
+	*/
+	static void ComputeDistancesSquared(const float* PositionsX, const float* PositionsY, const float* PositionsZ, int32 NumPoints, const FVector& TargetLocation, float* OutDistancesSquared);
 
 };
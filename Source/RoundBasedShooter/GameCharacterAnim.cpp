@@ -7,10 +7,20 @@
 
 UGameCharacterAnim::UGameCharacterAnim()
 {
-	
+	FallbackIdleAnimation = nullptr;
+}
+
+void UGameCharacterAnim::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	if (!FallbackIdleAnimation)
+	{
+		FallbackIdleAnimation = IdleAnimation;
+	}
 }
 
 void UGameCharacterAnim::UpdateIdleAnimation_Implementation(UAnimSequence* NewIdleAnim)
 {
-	IdleAnimation = NewIdleAnim;
+	IdleAnimation = NewIdleAnim ? NewIdleAnim : FallbackIdleAnimation;
 }
@@ -22,7 +22,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animations")
 	UAnimSequence* IdleAnimation;
 
-	// The new idle animation pose to use on the character
+	// Pose used while an item's idle animation is still streaming in. Defaults to the IdleAnimation the blueprint starts with
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animations")
+	UAnimSequence* FallbackIdleAnimation;
+
+	virtual void NativeInitializeAnimation() override;
+
+	// The new idle animation pose to use on the character. Null for the fallback pose
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Animations")
 	void UpdateIdleAnimation(UAnimSequence* NewIdleAnim);
 
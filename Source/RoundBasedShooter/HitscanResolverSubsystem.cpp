@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanResolverSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/DamageType.h"
+#include "GameFramework/Pawn.h"
+#include "InventoryItemBase.h"
+#include "Kismet/GameplayStatics.h"
+
+UHitscanResolverSubsystem::UHitscanResolverSubsystem()
+{
+	TraceChannel = ECC_Visibility;
+	MinPelletsForParallelTrace = 32;
+	bIsInitialized = false;
+	bIsResolving = false;
+	NextShotId = 1;
+}
+
+void UHitscanResolverSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsInitialized = true;
+}
+
+void UHitscanResolverSubsystem::Deinitialize()
+{
+	bIsInitialized = false;
+	QueuedShots.Empty();
+	Pellets.Empty();
+
+	Super::Deinitialize();
+}
+
+int UHitscanResolverSubsystem::SubmitShot(AInventoryItemBase* Item, const FHitscanShot& Shot)
+{
+	if (!IsValid(Item) || Shot.NumPellets <= 0 || Shot.Range <= 0.0f || Shot.Direction.IsNearlyZero())
+	{
+		return 0;
+	}
+
+	FQueuedShot& QueuedShot = QueuedShots.AddDefaulted_GetRef();
+	QueuedShot.Item = Item;
+	QueuedShot.Shot = Shot;
+	QueuedShot.ShotId = NextShotId;
+
+	// Skip 0 so it can stay the invalid id
+	NextShotId = NextShotId == MAX_int32 ? 1 : NextShotId + 1;
+
+	return QueuedShot.ShotId;
+}
+
+void UHitscanResolverSubsystem::ResolveShots()
+{
+	if (QueuedShots.Num() == 0 || bIsResolving)
+	{
+		return;
+	}
+
+	TGuardValue<bool> ResolvingGuard(bIsResolving, true);
+
+	UWorld* World = GetWorld();
+
+	// Take the shots out first, as items may fire again from their result events
+	TArray<FQueuedShot> Shots = MoveTemp(QueuedShots);
+	QueuedShots.Reset();
+
+	// Expand the shots into pellets. Spread uses the global random stream, which is only safe here on the game thread
+	Pellets.Reset();
+	for (int32 ShotIndex = 0; ShotIndex < Shots.Num(); ShotIndex++)
+	{
+		const FHitscanShot& Shot = Shots[ShotIndex].Shot;
+		const FVector Direction = Shot.Direction.GetSafeNormal();
+		const float SpreadRadians = FMath::DegreesToRadians(Shot.SpreadAngle);
+
+		for (int32 PelletIndex = 0; PelletIndex < Shot.NumPellets; PelletIndex++)
+		{
+			const FVector PelletDirection = SpreadRadians > 0.0f ? FMath::VRandCone(Direction, SpreadRadians) : Direction;
+
+			FPellet& Pellet = Pellets.AddDefaulted_GetRef();
+			Pellet.Start = Shot.Origin;
+			Pellet.End = Shot.Origin + PelletDirection * Shot.Range;
+			Pellet.ShotIndex = ShotIndex;
+			Pellet.bHit = false;
+		}
+	}
+
+	// Query params are built once per shot and shared by its pellets
+	TArray<FCollisionQueryParams> ShotQueryParams;
+	ShotQueryParams.Reserve(Shots.Num());
+
+	for (const FQueuedShot& QueuedShot : Shots)
+	{
+		FCollisionQueryParams& QueryParams = ShotQueryParams.Emplace_GetRef(SCENE_QUERY_STAT(HitscanShot), false);
+		const AInventoryItemBase* Item = QueuedShot.Item.Get();
+		if (Item)
+		{
+			QueryParams.AddIgnoredActor(Item);
+			QueryParams.AddIgnoredActor(Item->GetOwner());
+		}
+	}
+
+	// The tickable objects tick after the world has fetched physics results, so the scene is only being read here
+	const ECollisionChannel Channel = TraceChannel;
+	ParallelFor(Pellets.Num(), [this, World, Channel, &ShotQueryParams](int32 PelletIndex)
+	{
+		FPellet& Pellet = Pellets[PelletIndex];
+		Pellet.bHit = World->LineTraceSingleByChannel(Pellet.Hit, Pellet.Start, Pellet.End, Channel, ShotQueryParams[Pellet.ShotIndex]);
+	}, Pellets.Num() < MinPelletsForParallelTrace);
+
+	// Pellets are in shot order, so each shot's pellets are a contiguous run
+	int32 FirstPelletIndex = 0;
+	for (int32 ShotIndex = 0; ShotIndex < Shots.Num(); ShotIndex++)
+	{
+		const FQueuedShot& QueuedShot = Shots[ShotIndex];
+		const int32 EndPelletIndex = FirstPelletIndex + QueuedShot.Shot.NumPellets;
+
+		FHitscanResult Result;
+		Result.ShotId = QueuedShot.ShotId;
+
+		// First pellet hit on each actor, used as the hit info of the one damage event it gets
+		TArray<const FHitResult*, TInlineAllocator<8>> ActorFirstHits;
+
+		for (int32 PelletIndex = FirstPelletIndex; PelletIndex < EndPelletIndex; PelletIndex++)
+		{
+			const FPellet& Pellet = Pellets[PelletIndex];
+			if (!Pellet.bHit)
+			{
+				continue;
+			}
+
+			Result.NumPelletsHit++;
+			Result.ImpactPoints.Add(Pellet.Hit.ImpactPoint);
+			Result.ImpactNormals.Add(Pellet.Hit.ImpactNormal);
+
+			AActor* HitActor = Pellet.Hit.GetActor();
+			if (!HitActor)
+			{
+				continue;
+			}
+
+			int32 ActorHitIndex = Result.ActorHits.IndexOfByPredicate([HitActor](const FHitscanActorHit& ActorHit) { return ActorHit.Actor == HitActor; });
+			if (ActorHitIndex == INDEX_NONE)
+			{
+				ActorHitIndex = Result.ActorHits.AddDefaulted();
+				Result.ActorHits[ActorHitIndex].Actor = HitActor;
+				ActorFirstHits.Add(&Pellet.Hit);
+			}
+
+			Result.ActorHits[ActorHitIndex].NumPellets++;
+			Result.ActorHits[ActorHitIndex].Damage += QueuedShot.Shot.DamagePerPellet;
+		}
+
+		FirstPelletIndex = EndPelletIndex;
+
+		AInventoryItemBase* Item = QueuedShot.Item.Get();
+		if (!IsValid(Item))
+		{
+			continue;
+		}
+
+		const APawn* OwnerPawn = Cast<APawn>(Item->GetOwner());
+		AController* InstigatorController = OwnerPawn ? OwnerPawn->GetController() : nullptr;
+		const TSubclassOf<UDamageType> DamageType = QueuedShot.Shot.DamageType ? QueuedShot.Shot.DamageType : TSubclassOf<UDamageType>(UDamageType::StaticClass());
+
+		for (int32 ActorHitIndex = 0; ActorHitIndex < Result.ActorHits.Num(); ActorHitIndex++)
+		{
+			const FHitscanActorHit& ActorHit = Result.ActorHits[ActorHitIndex];
+			if (IsValid(ActorHit.Actor) && ActorHit.Damage > 0.0f)
+			{
+				UGameplayStatics::ApplyPointDamage(ActorHit.Actor, ActorHit.Damage, QueuedShot.Shot.Direction.GetSafeNormal(), *ActorFirstHits[ActorHitIndex],
+					InstigatorController, Item, DamageType);
+			}
+		}
+
+		Item->OnHitscanResolved(Result);
+	}
+}
+
+void UHitscanResolverSubsystem::Tick(float DeltaTime)
+{
+	ResolveShots();
+}
+
+bool UHitscanResolverSubsystem::IsTickable() const
+{
+	return bIsInitialized && QueuedShots.Num() > 0;
+}
+
+ETickableTickType UHitscanResolverSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UHitscanResolverSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UHitscanResolverSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanResolverSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HitscanResolverSubsystem.generated.h"
+
+class AInventoryItemBase;
+class UDamageType;
+
+// A hitscan shot waiting to be resolved. One shot can be many pellets, e.g. a shotgun blast
+USTRUCT(BlueprintType)
+struct FHitscanShot
+{
+	GENERATED_BODY()
+
+public:
+
+	// Where the pellets start
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan")
+	FVector Origin;
+
+	// Center of the spread cone. Does not need to be normalized
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan")
+	FVector Direction;
+
+	// Half angle of the spread cone in degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan", meta = (ClampMin = "0.0", ClampMax = "90.0"))
+	float SpreadAngle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan", meta = (ClampMin = "1"))
+	int NumPellets;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan", meta = (ClampMin = "0.0"))
+	float DamagePerPellet;
+
+	// Max distance a pellet travels
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan", meta = (ClampMin = "0.0"))
+	float Range;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan")
+	TSubclassOf<UDamageType> DamageType;
+
+	FHitscanShot()
+	{
+		Origin = FVector::ZeroVector;
+		Direction = FVector::ForwardVector;
+		SpreadAngle = 0.0f;
+		NumPellets = 1;
+		DamagePerPellet = 10.0f;
+		Range = 10000.0f;
+	}
+};
+
+// Every pellet of a shot that hit the same actor, added up
+USTRUCT(BlueprintType)
+struct FHitscanActorHit
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	AActor* Actor;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	int NumPellets;
+
+	// Damage applied to the actor, in one ApplyPointDamage call
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	float Damage;
+
+	FHitscanActorHit()
+	{
+		Actor = nullptr;
+		NumPellets = 0;
+		Damage = 0.0f;
+	}
+};
+
+// What a shot hit, delivered back to the item that fired it
+USTRUCT(BlueprintType)
+struct FHitscanResult
+{
+	GENERATED_BODY()
+
+public:
+
+	// Id returned when the shot was submitted
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	int ShotId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	int NumPelletsHit;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	TArray<FHitscanActorHit> ActorHits;
+
+	// Where each pellet that hit something stopped, for impact effects
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	TArray<FVector> ImpactPoints;
+
+	// Surface normal at each impact point
+	UPROPERTY(BlueprintReadOnly, Category = "Hitscan")
+	TArray<FVector> ImpactNormals;
+
+	FHitscanResult()
+	{
+		ShotId = 0;
+		NumPelletsHit = 0;
+	}
+};
+
+/**
+	Resolves every hitscan shot fired in a frame in one batched pass instead of each weapon tracing on its own.
+	Items submit compact shot records. At the end of the frame the shots are expanded into pellets, the pellets are traced
+	in parallel on task graph workers, damage is added up per shot and hit actor and applied once, and each item gets
+	a single result through AInventoryItemBase::OnHitscanResolved.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UHitscanResolverSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UHitscanResolverSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+		Queues a shot to be resolved this frame. The item's owner and the item itself never block the pellets.
+		@param Item - Item firing the shot. Gets the result and is the damage causer
+		@param Shot - The shot
+		@return Id of the shot, found again in the result. 0 if the shot was not queued
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Hitscan")
+	int SubmitShot(AInventoryItemBase* Item, const FHitscanShot& Shot);
+
+	// Resolves every queued shot now instead of waiting for the subsystem tick
+	UFUNCTION(BlueprintCallable, Category = "Hitscan")
+	void ResolveShots();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan")
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	// Pellets in a pass before the traces are spread over worker threads. Below this the thread hand off costs more than it saves
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitscan", meta = (ClampMin = "1"))
+	int MinPelletsForParallelTrace;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	struct FQueuedShot
+	{
+		TWeakObjectPtr<AInventoryItemBase> Item;
+
+		FHitscanShot Shot;
+
+		int32 ShotId;
+	};
+
+	struct FPellet
+	{
+		FVector Start;
+		FVector End;
+
+		// Index into the shots being resolved
+		int32 ShotIndex;
+
+		bool bHit;
+
+		FHitResult Hit;
+	};
+
+	bool bIsInitialized;
+
+	// Set while results are handed out, so a result event resolving again can not pull the pellets out from under the pass
+	bool bIsResolving;
+
+	int32 NextShotId;
+
+	TArray<FQueuedShot> QueuedShots;
+
+	// Kept between passes so expanding the pellets does not allocate
+	TArray<FPellet> Pellets;
+};
@@ -4,23 +4,81 @@
 #include "InventoryComponentBase.h"
 
 #include "InventoryItemBase.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/Character.h"
+#include "TimerManager.h"
+
+namespace
+{
+	// Paths of the animations and sounds of the item
+	void GetItemAssetPaths(TSubclassOf<AInventoryItemBase> ItemClass, TArray<FSoftObjectPath>& OutPaths)
+	{
+		if (ItemClass)
+		{
+			ItemClass->GetDefaultObject<AInventoryItemBase>()->GetEquippedAssetPaths(OutPaths);
+		}
+	}
+}
 
 // Sets default values for this component's properties
 UInventoryComponentBase::UInventoryComponentBase()
 {
 	PrimaryComponentTick.bCanEverTick = false;
 
-	LoadoutActors.AddDefaulted(5);
+	for (AInventoryItemBase*& LoadoutActor : LoadoutActors)
+	{
+		LoadoutActor = nullptr;
+	}
+
+	SlotLayout = EInventoryLayout::Standard;
+	HolsteredItemReleaseDelay = 10.0f;
+	OccupiedSlots = 0;
 
-	LastEquippedWeapon = ESlotOption::PrimaryMainWeapon;
-	LastEquippedGadget = ESlotOption::PrimaryGadget;
+	CurrentEquippedSlot = ESlotOption::PrimaryMainWeapon;
+	ResetLastEquippedSlots();
 
 }
 
+void UInventoryComponentBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The layout may have been changed from the default in the editor
+	ResetLastEquippedSlots();
+	CurrentEquippedSlot = GetSlotLayoutTable().FirstSlotOfType[ESlotType::WeaponType];
+}
+
 void UInventoryComponentBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	DestroyItems();
+
+	for (TSharedPtr<FStreamableHandle>& SlotAssetHandle : SlotAssetHandles)
+	{
+		if (SlotAssetHandle.IsValid())
+		{
+			SlotAssetHandle->ReleaseHandle();
+			SlotAssetHandle.Reset();
+		}
+	}
+
+	for (TPair<const UClass*, TSharedPtr<FStreamableHandle>>& PreloadHandle : PreloadHandles)
+	{
+		if (PreloadHandle.Value.IsValid())
+		{
+			PreloadHandle.Value->ReleaseHandle();
+		}
+	}
+
+	PreloadHandles.Empty();
+
+	if (PendingEquipHandle.IsValid())
+	{
+		PendingEquipHandle->CancelHandle();
+		PendingEquipHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 bool UInventoryComponentBase::AddItem(ESlotOption SlotOption, TSubclassOf<AInventoryItemBase> ItemClass)
@@ -31,29 +89,45 @@ bool UInventoryComponentBase::AddItem(ESlotOption SlotOption, TSubclassOf<AInven
 		return false;
 	}
 
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-	SpawnParams.Owner = GetOwner();
-
-	AInventoryItemBase* SpawnedItem = GetWorld()->SpawnActor<AInventoryItemBase>(ItemClass, SpawnParams);
-
 	int SlotOptionIndex = SlotOption;
+	if (SlotOptionIndex < 0 || SlotOptionIndex >= GetNumSlots())
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "AddItem: SlotOptionIndex invalid index!");
+		return false;
+	}
+
 	AInventoryItemBase* InvItem = GetLoadoutActor(SlotOptionIndex);
 
 	if (InvItem)
 	{
 		InvItem->Destroy();
+		LoadoutActors[SlotOptionIndex] = nullptr;
 	}
 
-	if (LoadoutActors.IsValidIndex(SlotOptionIndex))
+	GetWorld()->GetTimerManager().ClearTimer(HolsteredReleaseTimers[SlotOptionIndex]);
+
+	// Only the record is stored. The actor is spawned the first time the item is needed
+	SlotRecords[SlotOptionIndex].ItemClass = ItemClass;
+	SlotRecords[SlotOptionIndex].AmmoInfo = ItemClass->GetDefaultObject<AInventoryItemBase>()->GetDefaultAmmoInfo();
+	OccupiedSlots |= 1u << SlotOptionIndex;
+
+	// Start streaming the item's animations and sounds now, so they are usually in by the time it is equipped
+	if (SlotAssetHandles[SlotOptionIndex].IsValid())
 	{
-		LoadoutActors[SlotOptionIndex] = SpawnedItem;
+		SlotAssetHandles[SlotOptionIndex]->ReleaseHandle();
+		SlotAssetHandles[SlotOptionIndex].Reset();
 	}
-	else
+
+	TArray<FSoftObjectPath> AssetPaths;
+	GetItemAssetPaths(ItemClass, AssetPaths);
+
+	if (AssetPaths.Num() > 0)
 	{
-		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "AddItem: SlotOptionIndex invalid index!");
+		SlotAssetHandles[SlotOptionIndex] = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths);
 	}
-	
+
+	// The slot keeps the assets loaded from here on
+	ReleaseItemAssetPreload(ItemClass);
 
 	return true;
 }
@@ -62,12 +136,22 @@ void UInventoryComponentBase::DestroyItems()
 {
 	UnEquipAll();
 
-	for (int i = LoadoutActors.Num() - 1; i >= 0; i--)
+	for (int i = MaxInventorySlots - 1; i >= 0; i--)
 	{
 		if (IsValid(GetLoadoutActor(i)))
 		{
 			GetLoadoutActor(i)->Destroy();
 		}
+
+		LoadoutActors[i] = nullptr;
+	}
+
+	if (GetWorld())
+	{
+		for (FTimerHandle& ReleaseTimer : HolsteredReleaseTimers)
+		{
+			GetWorld()->GetTimerManager().ClearTimer(ReleaseTimer);
+		}
 	}
 }
 
@@ -82,72 +166,176 @@ void UInventoryComponentBase::UnEquipAll()
 	}
 }
 
-AInventoryItemBase* UInventoryComponentBase::GetLoadoutActor(int ActorIndex) const
+AInventoryItemBase* UInventoryComponentBase::GetLoadoutActor(int SlotIndex) const
 {
-	if (!LoadoutActors.IsValidIndex(ActorIndex))
-	{
-		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "GetLoadoutActor InvalidIndex!");
-		return nullptr;
-	}
-	else
+	return LoadoutActors[MaskInventorySlot(SlotIndex)];
+}
+
+TArray<AInventoryItemBase*> UInventoryComponentBase::GetLoadoutActors() const
+{
+	return TArray<AInventoryItemBase*>(LoadoutActors, GetNumSlots());
+}
+
+TSubclassOf<AInventoryItemBase> UInventoryComponentBase::GetSlotItemClass(ESlotOption SlotOption) const
+{
+	return SlotRecords[MaskInventorySlot(SlotOption)].ItemClass;
+}
+
+FAmmoInfo UInventoryComponentBase::GetSlotAmmoInfo(ESlotOption SlotOption) const
+{
+	AInventoryItemBase* SlotItem = GetLoadoutActor(SlotOption);
+	if (IsValid(SlotItem))
 	{
-		return LoadoutActors[ActorIndex];
+		return SlotItem->GetAmmoInfo();
 	}
+
+	return SlotRecords[MaskInventorySlot(SlotOption)].AmmoInfo;
 }
 
-TArray<AInventoryItemBase*> UInventoryComponentBase::GetLoadoutActors() const
+AInventoryItemBase* UInventoryComponentBase::GetOrCreateSlotItem(ESlotOption SlotOption)
 {
-	return LoadoutActors;
+	return MaterializeSlotItem(SlotOption);
 }
 
-TEnumAsByte<ESlotOption> UInventoryComponentBase::GetEquippedSlot() const
+bool UInventoryComponentBase::IsSlotOccupied(int SlotIndex) const
 {
-	return CurrentEquippedSlot;
+	return (OccupiedSlots >> MaskInventorySlot(SlotIndex)) & 1u;
 }
 
-ESlotOption UInventoryComponentBase::PickEmptyWeaponSlot() const
+AInventoryItemBase* UInventoryComponentBase::MaterializeSlotItem(int SlotIndex)
 {
-	AInventoryItemBase* TempItem = GetLoadoutActor(ESlotOption::PrimaryMainWeapon);
+	SlotIndex = MaskInventorySlot(SlotIndex);
 
-	// If primary slot is empty, return primary weapon slot	
-	if (!TempItem)
+	if (!IsSlotOccupied(SlotIndex))
 	{
-		return ESlotOption::PrimaryMainWeapon;
-	}	
+		return nullptr;
+	}
 
-	// If secondary slot is empty, return secondary weapon slot
-	TempItem = GetLoadoutActor(ESlotOption::SecondaryMainWeapon);
-	if (!TempItem)
+	if (IsValid(LoadoutActors[SlotIndex]))
 	{
-		return ESlotOption::SecondaryMainWeapon;
+		return LoadoutActors[SlotIndex];
 	}
 
-	// If both slots have items, then return the last equipped weapon
-	else
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	SpawnParams.Owner = GetOwner();
+
+	AInventoryItemBase* SpawnedItem = GetWorld()->SpawnActor<AInventoryItemBase>(SlotRecords[SlotIndex].ItemClass, SpawnParams);
+	if (SpawnedItem)
 	{
-		return LastEquippedWeapon;
+		SpawnedItem->SetAmmoInfo(SlotRecords[SlotIndex].AmmoInfo);
 	}
+
+	LoadoutActors[SlotIndex] = SpawnedItem;
+	return SpawnedItem;
 }
 
-ESlotOption UInventoryComponentBase::PickEmptyGadgetSlot() const
+void UInventoryComponentBase::ReleaseSlotItem(int SlotIndex)
 {
-	// If primary slot is empty, return primary gadget slot
-	if (!GetLoadoutActor(ESlotOption::PrimaryGadget))
+	SlotIndex = MaskInventorySlot(SlotIndex);
+
+	AInventoryItemBase* SlotItem = GetLoadoutActor(SlotIndex);
+
+	// Never release the item in hand
+	if (!IsValid(SlotItem) || SlotItem->GetIsEquipped())
 	{
-		return ESlotOption::PrimaryGadget;
+		return;
 	}
 
-	// If secondary slot is empty, return secondary gadget slot
-	if (!GetLoadoutActor(ESlotOption::SecondaryGadget))
+	SlotItem->OnCancelReloadEvent();
+	SlotRecords[SlotIndex].AmmoInfo = SlotItem->GetAmmoInfo();
+	SlotItem->Destroy();
+	LoadoutActors[SlotIndex] = nullptr;
+}
+
+void UInventoryComponentBase::UpdateHolsteredReleaseTimers()
+{
+	if (HolsteredItemReleaseDelay <= 0.0f)
 	{
-		return ESlotOption::SecondaryGadget;
+		return;
 	}
 
-	// If both slots have items, then return the last equipped gadget
-	else
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+	for (int SlotIndex = 0; SlotIndex < GetNumSlots(); SlotIndex++)
+	{
+		if (!IsValid(LoadoutActors[SlotIndex]) || SlotIndex == CurrentEquippedSlot)
+		{
+			TimerManager.ClearTimer(HolsteredReleaseTimers[SlotIndex]);
+		}
+		else if (!TimerManager.IsTimerActive(HolsteredReleaseTimers[SlotIndex]))
+		{
+			TimerManager.SetTimer(HolsteredReleaseTimers[SlotIndex], FTimerDelegate::CreateUObject(this, &UInventoryComponentBase::ReleaseSlotItem, SlotIndex), HolsteredItemReleaseDelay, false);
+		}
+	}
+}
+
+TEnumAsByte<ESlotOption> UInventoryComponentBase::GetEquippedSlot() const
+{
+	return (ESlotOption)CurrentEquippedSlot;
+}
+
+int UInventoryComponentBase::GetNumSlots() const
+{
+	return GetSlotLayoutTable().NumSlots;
+}
+
+bool UInventoryComponentBase::GetSlotType(ESlotOption SlotOption, TEnumAsByte<ESlotType>& OutSlotType) const
+{
+	// Slot types past the layout's slots are zero filled and would read as weapon slots
+	int SlotOptionIndex = SlotOption;
+	if (SlotOptionIndex < 0 || SlotOptionIndex >= GetNumSlots())
 	{
-		return LastEquippedGadget;
+		return false;
 	}
+
+	OutSlotType = GetSlotLayoutTable().SlotTypes[SlotOptionIndex];
+	return true;
+}
+
+const FInventorySlotLayout& UInventoryComponentBase::GetSlotLayoutTable() const
+{
+	return GetInventorySlotLayout(SlotLayout);
+}
+
+void UInventoryComponentBase::SetSlotLayout(EInventoryLayout NewSlotLayout)
+{
+	DestroyItems();
+
+	for (int SlotIndex = 0; SlotIndex < MaxInventorySlots; SlotIndex++)
+	{
+		SlotRecords[SlotIndex] = FInventorySlotRecord();
+
+		if (SlotAssetHandles[SlotIndex].IsValid())
+		{
+			SlotAssetHandles[SlotIndex]->ReleaseHandle();
+			SlotAssetHandles[SlotIndex].Reset();
+		}
+	}
+
+	OccupiedSlots = 0;
+	SlotLayout = NewSlotLayout;
+
+	ResetLastEquippedSlots();
+	CurrentEquippedSlot = GetSlotLayoutTable().FirstSlotOfType[ESlotType::WeaponType];
+}
+
+void UInventoryComponentBase::ResetLastEquippedSlots()
+{
+	const FInventorySlotLayout& SlotLayoutTable = GetSlotLayoutTable();
+
+	for (int SlotType = 0; SlotType < NumInventorySlotTypes; SlotType++)
+	{
+		LastEquippedSlots[SlotType] = SlotLayoutTable.FirstSlotOfType[SlotType];
+	}
+}
+
+int UInventoryComponentBase::PickSlotForType(ESlotType SlotType) const
+{
+	const uint32 EmptySlotsOfType = GetSlotLayoutTable().SlotTypeMasks[SlotType] & ~OccupiedSlots;
+
+	// Lowest empty slot of the type, or the last equipped one if they are all taken
+	return EmptySlotsOfType ? (int)FMath::CountTrailingZeros(EmptySlotsOfType) : LastEquippedSlots[SlotType];
 }
 
 bool UInventoryComponentBase::IsItemInInventory(TSubclassOf<AInventoryItemBase> CheckClass) const
@@ -158,15 +346,12 @@ bool UInventoryComponentBase::IsItemInInventory(TSubclassOf<AInventoryItemBase>
 		return false;
 	}
 
-	for (AInventoryItemBase* ItemActor : LoadoutActors)
+	for (const FInventorySlotRecord& SlotRecord : SlotRecords)
 	{
-		if (ItemActor)
+		if (SlotRecord.ItemClass == CheckClass)
 		{
-			if (ItemActor->GetClass() == CheckClass)
-			{
-				return true;
-			}
-		}		
+			return true;
+		}
 	}
 
 	return false;
@@ -193,18 +378,59 @@ bool UInventoryComponentBase::PlayEquipAnimation(AInventoryItemBase* CurrentItem
 	return false;
 }
 
-void UInventoryComponentBase::SendFirePressed(TEnumAsByte<ESlotOption> SlotOption)
+void UInventoryComponentBase::DeferEquipAnimation(AInventoryItemBase* CurrentItem, FName SlotName)
+{
+	if (PendingEquipHandle.IsValid())
+	{
+		PendingEquipHandle->CancelHandle();
+		PendingEquipHandle.Reset();
+	}
+
+	PendingEquipItem = CurrentItem;
+
+	TArray<FSoftObjectPath> AssetPaths;
+	GetItemAssetPaths(CurrentItem->GetClass(), AssetPaths);
+
+	// Joins the loads already started by the slot or a preload, and moves them up the queue
+	PendingEquipHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths,
+		FStreamableDelegate::CreateUObject(this, &UInventoryComponentBase::OnEquipAssetsLoaded, TWeakObjectPtr<AInventoryItemBase>(CurrentItem), SlotName),
+		FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UInventoryComponentBase::OnEquipAssetsLoaded(TWeakObjectPtr<AInventoryItemBase> Item, FName SlotName)
+{
+	AInventoryItemBase* LoadedItem = Item.Get();
+
+	// Something else was equipped while the assets were loading
+	if (!LoadedItem || LoadedItem != PendingEquipItem.Get() || !LoadedItem->GetIsEquipped())
+	{
+		return;
+	}
+
+	PendingEquipItem.Reset();
+	LoadedItem->OnAssetsLoaded();
+	PlayEquipAnimation(LoadedItem, SlotName);
+}
+
+void UInventoryComponentBase::SendFirePressed(int SlotIndex)
 {
-	AInventoryItemBase* SelectedItem = GetLoadoutActor(SlotOption);
+	SlotIndex = MaskInventorySlot(SlotIndex);
+
+	// Throwables fire without being equipped, so their actor may not exist yet
+	AInventoryItemBase* SelectedItem = MaterializeSlotItem(SlotIndex);
 	if (IsValid(SelectedItem))
 	{
 		SelectedItem->OnFirePressed();
+
+		// Restart the release timer so a throwable in use is not released
+		GetWorld()->GetTimerManager().ClearTimer(HolsteredReleaseTimers[SlotIndex]);
+		UpdateHolsteredReleaseTimers();
 	}
 }
 
-void UInventoryComponentBase::SendFireReleased(TEnumAsByte<ESlotOption> SlotOption)
+void UInventoryComponentBase::SendFireReleased(int SlotIndex)
 {
-	AInventoryItemBase* SelectedItem = GetLoadoutActor(SlotOption);
+	AInventoryItemBase* SelectedItem = GetLoadoutActor(SlotIndex);
 	if (IsValid(SelectedItem))
 	{
 		SelectedItem->OnFireReleased();
@@ -214,33 +440,39 @@ void UInventoryComponentBase::SendFireReleased(TEnumAsByte<ESlotOption> SlotOpti
 void UInventoryComponentBase::EquipItem(TEnumAsByte<ESlotOption> SlotOption, FName SlotName)
 {
 	// Cancel operation if the item is the same as current item and is equipped OR check if the item trying to be equipped is invalid
-	if (SlotOption == CurrentEquippedSlot && GetLoadoutActor(CurrentEquippedSlot)->GetIsEquipped() || !IsValid(GetLoadoutActor(SlotOption)))
+	const int SlotIndex = MaskInventorySlot(SlotOption);
+
+	if (SlotIndex == CurrentEquippedSlot && IsValid(GetLoadoutActor(CurrentEquippedSlot)) && GetLoadoutActor(CurrentEquippedSlot)->GetIsEquipped() || !IsSlotOccupied(SlotIndex))
 	{
 		return;
 	}
 
-	CurrentEquippedSlot = SlotOption;
+	CurrentEquippedSlot = SlotIndex;
 	CancelReload();
 	UnEquipAll();
 
-	// Set last equipped depending on whether the newly equipped item is a weapon or a gadget
-	if (CurrentEquippedSlot == ESlotOption::PrimaryMainWeapon || CurrentEquippedSlot == ESlotOption::SecondaryMainWeapon)
-	{
-		LastEquippedWeapon = CurrentEquippedSlot;
-	}
-	else if (CurrentEquippedSlot == ESlotOption::PrimaryGadget || CurrentEquippedSlot == ESlotOption::SecondaryGadget)
-	{
-		LastEquippedGadget = CurrentEquippedSlot;
-	}
+	// Remember the slot as the last equipped of its type, where swaps of that type go once its slots are full
+	LastEquippedSlots[GetSlotLayoutTable().SlotTypes[CurrentEquippedSlot]] = CurrentEquippedSlot;
 	
 	// Go ahead and actually equip the item
-	AInventoryItemBase* CurrentItem = GetLoadoutActor(CurrentEquippedSlot);
+	AInventoryItemBase* CurrentItem = MaterializeSlotItem(CurrentEquippedSlot);
 
 	if (IsValid(CurrentItem))
 	{
 		CurrentItem->OnEquip(this);
-		PlayEquipAnimation(CurrentItem, SlotName);
+
+		if (CurrentItem->AreAssetsResident())
+		{
+			PendingEquipItem.Reset();
+			PlayEquipAnimation(CurrentItem, SlotName);
+		}
+		else
+		{
+			DeferEquipAnimation(CurrentItem, SlotName);
+		}
 	}
+
+	UpdateHolsteredReleaseTimers();
 }
 
 bool UInventoryComponentBase::SwapItem(TSubclassOf<AInventoryItemBase> NewItemClass, bool bShouldEquip)
@@ -251,44 +483,72 @@ bool UInventoryComponentBase::SwapItem(TSubclassOf<AInventoryItemBase> NewItemCl
 		return false;
 	}
 
-	ESlotOption NewSlotOption;
 	AInventoryItemBase* DefaultItem = Cast<AInventoryItemBase>(NewItemClass->GetDefaultObject(true));
-	
-	// Choose which slot the new item will go in to
-	if (DefaultItem->InventorySlotType == ESlotType::WeaponType)
+	const ESlotType NewSlotType = DefaultItem->GetInventorySlotType();
+
+	// The layout may have no slot for this type of item
+	if (GetSlotLayoutTable().SlotTypeMasks[NewSlotType] == 0)
 	{
-		NewSlotOption = PickEmptyWeaponSlot();
+		return false;
 	}
-	else if (DefaultItem->InventorySlotType == ESlotType::GadgetType)
+
+	// Choose which slot the new item will go in to
+	const ESlotOption NewSlotOption = (ESlotOption)PickSlotForType(NewSlotType);
+
+	AddItem(NewSlotOption, NewItemClass);
+
+	if (bShouldEquip && NewSlotType != ESlotType::ThrowableType)
 	{
-		NewSlotOption = PickEmptyGadgetSlot();
+		EquipItem(NewSlotOption, "UpperBodySlot");
 	}
 	else
 	{
-		NewSlotOption = ESlotOption::Throwable;
+		EquipItem((ESlotOption)CurrentEquippedSlot, "UpperBodySlot");
 	}
 
-	AddItem(NewSlotOption, NewItemClass);
+	return true;
+}
 
-	if (bShouldEquip && NewSlotOption != ESlotOption::Throwable)
+void UInventoryComponentBase::PreloadItemAssets(TSubclassOf<AInventoryItemBase> ItemClass)
+{
+	if (!ItemClass || PreloadHandles.Contains(ItemClass) || IsItemInInventory(ItemClass))
 	{
-		EquipItem(NewSlotOption, "UpperBodySlot");
+		return;
 	}
-	else
+
+	TArray<FSoftObjectPath> AssetPaths;
+	GetItemAssetPaths(ItemClass, AssetPaths);
+
+	if (AssetPaths.Num() > 0)
 	{
-		EquipItem(CurrentEquippedSlot, "UpperBodySlot");
+		PreloadHandles.Add(ItemClass, UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths));
 	}
+}
 
-	return true;
+void UInventoryComponentBase::ReleaseItemAssetPreload(TSubclassOf<AInventoryItemBase> ItemClass)
+{
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+	if (PreloadHandles.RemoveAndCopyValue(ItemClass, PreloadHandle) && PreloadHandle.IsValid())
+	{
+		PreloadHandle->ReleaseHandle();
+	}
 }
 
 void UInventoryComponentBase::ReplenishAllAmmo()
 {
-	for (AInventoryItemBase* ItemActor : LoadoutActors)
+	for (int SlotIndex = 0; SlotIndex < GetNumSlots(); SlotIndex++)
 	{
-		if (IsValid(ItemActor))
+		if (IsValid(LoadoutActors[SlotIndex]))
+		{
+			LoadoutActors[SlotIndex]->OnReplenish();
+		}
+
+		// Items without an actor get the default replenish straight on their record
+		else if (IsSlotOccupied(SlotIndex))
 		{
-			ItemActor->OnReplenish();
+			FAmmoInfo& AmmoInfo = SlotRecords[SlotIndex].AmmoInfo;
+			AmmoInfo.NumMagazines = AmmoInfo.MaxMagazines;
+			AmmoInfo.NumRounds = AmmoInfo.MaxRounds;
 		}
 	}
 }
@@ -305,12 +565,12 @@ void UInventoryComponentBase::OnFireReleased()
 
 void UInventoryComponentBase::OnThrowPressed()
 {
-	SendFirePressed(Throwable);
+	SendFirePressed(GetSlotLayoutTable().FirstSlotOfType[ESlotType::ThrowableType]);
 }
 
 void UInventoryComponentBase::OnThrowReleased()
 {
-	SendFireReleased(Throwable);
+	SendFireReleased(GetSlotLayoutTable().FirstSlotOfType[ESlotType::ThrowableType]);
 }
 
 void UInventoryComponentBase::ReloadSelected()
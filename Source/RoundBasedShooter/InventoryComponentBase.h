@@ -4,26 +4,57 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "InventorySlotLayout.h"
 #include "InventoryComponentBase.generated.h"
 
 class AInventoryItemBase;
+struct FStreamableHandle;
 
-UENUM(Blueprintable)
-enum ESlotOption
+USTRUCT(BlueprintType)
+struct FAmmoInfo
 {
-	PrimaryMainWeapon UMETA(DisplayName = "PrimaryMainWeapon"),
-	SecondaryMainWeapon UMETA(DisplayName = "SecondaryMainWeapon"),
-	Throwable UMETA(DisplayName = "Throwable"),
-	PrimaryGadget UMETA(DisplayName = "PrimaryGadget"),
-	SecondaryGadget UMETA(DisplayName = "SecondaryGadget")
+
+public:
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
+	int MaxMagazines;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
+	int NumMagazines;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
+	int MaxRounds;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
+	int NumRounds;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
+	bool UsesMagazines;
+
+	FAmmoInfo()
+	{
+		NumMagazines = MaxMagazines = 10;
+		NumRounds = MaxRounds = 10;
+		UsesMagazines = true;
+	}
 };
 
-UENUM(Blueprintable)
-enum ESlotType
+// What a slot holds while its item actor does not exist. Enough to create the actor again with the same ammo
+USTRUCT(BlueprintType)
+struct FInventorySlotRecord
 {
-	WeaponType UMETA(DisplayName = "Weapon"),
-	GadgetType UMETA(DisplayName = "Gadget"),
-	ThrowableType UMETA(DisplayName = "Throwable")
+	GENERATED_BODY()
+
+public:
+
+	// Class of the item in the slot. Null if the slot is empty
+	UPROPERTY(BlueprintReadOnly, Category = "Loadout")
+	TSubclassOf<AInventoryItemBase> ItemClass;
+
+	// Ammo state of the item as of when its actor was last released
+	UPROPERTY(BlueprintReadOnly, Category = "Loadout")
+	FAmmoInfo AmmoInfo;
 };
 
 
@@ -34,13 +65,45 @@ class ROUNDBASEDSHOOTER_API UInventoryComponentBase : public UActorComponent
 
 public:	
 
+	/**
+		Item actors of every slot. Slots whose item has not been equipped yet, or was released after being holstered, are null
+		even though they hold an item. Use GetSlotItemClass and GetSlotAmmoInfo to look at those, or GetOrCreateSlotItem for the actor
+	*/
 	UFUNCTION(BlueprintPure, Category = "Loadout")
 	TArray<AInventoryItemBase*> GetLoadoutActors() const;
 
+	// Class of the item in the slot, whether or not its actor exists. Null if the slot is empty
+	UFUNCTION(BlueprintPure, Category = "Loadout")
+	TSubclassOf<AInventoryItemBase> GetSlotItemClass(ESlotOption SlotOption) const;
+
+	// Ammo state of the item in the slot, whether or not its actor exists
+	UFUNCTION(BlueprintPure, Category = "Ammo")
+	FAmmoInfo GetSlotAmmoInfo(ESlotOption SlotOption) const;
+
+	// Returns the item actor of the slot, creating it first if the slot only holds a record. Null if the slot is empty
+	UFUNCTION(BlueprintCallable, Category = "Loadout")
+	AInventoryItemBase* GetOrCreateSlotItem(ESlotOption SlotOption);
+
 	// Get the current equipped slot
 	UFUNCTION(Blueprintpure, Category = "Loadout")
 	TEnumAsByte<ESlotOption> GetEquippedSlot() const;
 
+	// Number of slots in the inventory's layout
+	UFUNCTION(BlueprintPure, Category = "Loadout")
+	int GetNumSlots() const;
+
+	// Type of the slot in the inventory's layout. Returns false if the layout has no such slot
+	UFUNCTION(BlueprintPure, Category = "Loadout")
+	bool GetSlotType(ESlotOption SlotOption, TEnumAsByte<ESlotType>& OutSlotType) const;
+
+	/**
+		Switches the inventory to another loadout layout, e.g. from the game mode before the match starts. Every item is
+		removed first.
+		@param NewSlotLayout - Layout to switch to
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Loadout")
+	void SetSlotLayout(EInventoryLayout NewSlotLayout);
+
 	UInventoryComponentBase();
 
 	// Equip the item in the given SlotOption. 
@@ -55,7 +118,22 @@ public:
 	UFUNCTION (BlueprintCallable, Category = "Loadout")
 	bool SwapItem(TSubclassOf<AInventoryItemBase> NewItemClass, bool bShouldEquip = false);
 		
-	// Goes through all items and calls their OnReplenish event
+	/**
+		Starts streaming in the animations and sounds of an item that may be picked up soon, e.g. when its pickup comes into
+		range, so equipping it does not wait on them. Kept loaded until ReleaseItemAssetPreload or until it is added.
+		@param ItemClass - Item whose assets to stream in
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Loadout")
+	void PreloadItemAssets(TSubclassOf<AInventoryItemBase> ItemClass);
+
+	// Lets go of the assets PreloadItemAssets kept loaded, e.g. when the pickup goes out of range
+	UFUNCTION(BlueprintCallable, Category = "Loadout")
+	void ReleaseItemAssetPreload(TSubclassOf<AInventoryItemBase> ItemClass);
+
+	/**
+		Goes through all item actors and calls their OnReplenish event.
+		Items without an actor do not get the event. Their slot's ammo is refilled to its max magazines and rounds instead
+	*/
 	UFUNCTION(BlueprintCallable, Category = "Ammo")
 	void ReplenishAllAmmo();
 
@@ -89,6 +167,8 @@ public:
 
 protected:
 
+	virtual void BeginPlay() override;
+
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	/**
@@ -105,26 +185,43 @@ protected:
 	UFUNCTION(BlueprintPure, Category = "Loadout")
 	bool IsItemInInventory(TSubclassOf<AInventoryItemBase> CheckClass) const;
 
+	// Slots of the inventory and the type of each. Change at runtime with SetSlotLayout
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Loadout")
+	EInventoryLayout SlotLayout;
+
 	// If this inventory can have infinite ammo
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Ammo")
 	bool bInfiniteAmmo;
 
+	// Seconds an item stays holstered before its actor is released back to a slot record. 0 or less to keep item actors around
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Loadout")
+	float HolsteredItemReleaseDelay;
+
 private:
 
 	// Plays the equip animation using the given animation slot
 	bool PlayEquipAnimation(AInventoryItemBase* CurrentItem, FName SlotName);
 
+	// Streams in the item's assets and plays its equip animation once they are in. The character holds its fallback pose until then
+	void DeferEquipAnimation(AInventoryItemBase* CurrentItem, FName SlotName);
+
+	// Plays the deferred equip animation if the item is still the one being equipped
+	void OnEquipAssetsLoaded(TWeakObjectPtr<AInventoryItemBase> Item, FName SlotName);
+
 	// Calls the OnFirePressed function on the item passed
-	void SendFirePressed(TEnumAsByte<ESlotOption> SlotOption);
+	void SendFirePressed(int SlotIndex);
 
 	// Calls the OnFireReleased function on the item passed
-	void SendFireReleased(TEnumAsByte<ESlotOption> SlotOption);
+	void SendFireReleased(int SlotIndex);
+
+	// Picks the lowest empty slot of the type to swap a new item in to. Returns the last equipped slot of the type if none are empty
+	int PickSlotForType(ESlotType SlotType) const;
 
-	// Tries to pick the best weapon slot to swap a new weapon in to. Returns the current selected weapon slot if neither is empty
-	ESlotOption PickEmptyWeaponSlot() const;
+	// Points the last equipped slot of every slot type at the type's first slot
+	void ResetLastEquippedSlots();
 
-	// Tries to pick the best slot to swap a new gadget in to. Returns the last selected gadget slot if neither is empty
-	ESlotOption PickEmptyGadgetSlot() const;
+	// The layout's slot table
+	const FInventorySlotLayout& GetSlotLayoutTable() const;
 
 	// Calls UnEquipAll and then destroys all the item actors
 	void DestroyItems();
@@ -132,10 +229,48 @@ private:
 	// Goes through all the items and calls their UnEquip method
 	void UnEquipAll();
 
-	AInventoryItemBase* GetLoadoutActor(int ActorIndex) const;
+	// Item actor of the slot. Slot indices are masked into the storage instead of checked, slots outside the layout are always null
+	AInventoryItemBase* GetLoadoutActor(int SlotIndex) const;
+
+	// If the slot has an item, whether or not its actor exists
+	bool IsSlotOccupied(int SlotIndex) const;
+
+	// Spawns the actor of the slot's item from its record if it does not exist yet
+	AInventoryItemBase* MaterializeSlotItem(int SlotIndex);
+
+	// Copies the item's ammo back into the slot record and destroys the actor
+	void ReleaseSlotItem(int SlotIndex);
+
+	// Starts the release timer of every item actor that is not equipped, and stops the equipped item's
+	void UpdateHolsteredReleaseTimers();
+
+	int CurrentEquippedSlot;
+
+	// Last equipped slot of each slot type, where swaps go once every slot of the type is taken
+	int LastEquippedSlots[NumInventorySlotTypes];
+
+	// Bit per slot holding an item
+	uint32 OccupiedSlots;
+
+	// Slot storage is sized for the largest layout so it never allocates. Everything past the layout's slots stays empty
+	UPROPERTY()
+	AInventoryItemBase* LoadoutActors[MaxInventorySlots];
+
+	// What each slot holds. Kept in step with LoadoutActors by index
+	UPROPERTY()
+	FInventorySlotRecord SlotRecords[MaxInventorySlots];
+
+	// Release timer of each slot's holstered item actor
+	FTimerHandle HolsteredReleaseTimers[MaxInventorySlots];
+
+	// Keeps the animations and sounds of each slot's item loaded
+	TSharedPtr<FStreamableHandle> SlotAssetHandles[MaxInventorySlots];
+
+	// Keeps the animations and sounds of items from PreloadItemAssets loaded
+	TMap<const UClass*, TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	// Item waiting on its assets to play its equip animation
+	TWeakObjectPtr<AInventoryItemBase> PendingEquipItem;
 
-	TEnumAsByte<ESlotOption> CurrentEquippedSlot;
-	TEnumAsByte<ESlotOption> LastEquippedWeapon;
-	TEnumAsByte<ESlotOption> LastEquippedGadget;
-	TArray<AInventoryItemBase*> LoadoutActors;
+	TSharedPtr<FStreamableHandle> PendingEquipHandle;
 };
@@ -8,7 +8,32 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Math/UnrealMathUtility.h"
 #include "GameCharacterAnim.h"
+#include "TimerManager.h"
+#include "Serialization/CustomVersion.h"
 
+namespace
+{
+	// Versions of the data inventory items save
+	struct FInventoryItemVersion
+	{
+		enum Type
+		{
+			BeforeCustomVersionWasAdded = 0,
+
+			// Socket, slot type, animations, sounds and default ammo moved into UInventoryItemDefinition
+			MovedToItemDefinitions,
+
+			VersionPlusOne,
+			LatestVersion = VersionPlusOne - 1
+		};
+
+		static const FGuid GUID;
+	};
+
+	const FGuid FInventoryItemVersion::GUID(0xEE49475E, 0xFF4C4FB2, 0xAC669AB3, 0x553F1C7B);
+
+	FCustomVersionRegistration GRegisterInventoryItemVersion(FInventoryItemVersion::GUID, FInventoryItemVersion::LatestVersion, TEXT("InventoryItemVersion"));
+}
 
 void AInventoryItemBase::DepleteRounds(int NumRounds)
 {
@@ -47,26 +72,154 @@ bool AInventoryItemBase::GetIsEquipped() const
 	return IsEquipped;
 }
 
+UInventoryItemDefinition* AInventoryItemBase::GetItemDefinition() const
+{
+	return ItemDefinition;
+}
+
+// Without a definition the item falls back on the settings it had before definitions, which keep their old defaults
+TEnumAsByte<ESlotType> AInventoryItemBase::GetInventorySlotType() const
+{
+	if (!ItemDefinition)
+	{
+		WarnMissingDefinition();
+		return InventorySlotType_DEPRECATED;
+	}
+
+	return ItemDefinition->InventorySlotType;
+}
+
+FName AInventoryItemBase::GetEquipSocketName() const
+{
+	if (!ItemDefinition)
+	{
+		WarnMissingDefinition();
+		return EquipSocketName_DEPRECATED;
+	}
+
+	return ItemDefinition->EquipSocketName;
+}
+
+FAmmoInfo AInventoryItemBase::GetDefaultAmmoInfo() const
+{
+	if (!ItemDefinition)
+	{
+		WarnMissingDefinition();
+		return GetClass()->GetDefaultObject<AInventoryItemBase>()->ItemAmmoInfo;
+	}
+
+	return ItemDefinition->DefaultAmmoInfo;
+}
+
+const FAnimationData& AInventoryItemBase::GetItemAnimations() const
+{
+	if (!ItemDefinition)
+	{
+		WarnMissingDefinition();
+		return ItemAnimations_DEPRECATED;
+	}
+
+	return ItemDefinition->Animations;
+}
+
+const FSoundData& AInventoryItemBase::GetItemSounds() const
+{
+	if (!ItemDefinition)
+	{
+		WarnMissingDefinition();
+		return ItemSounds_DEPRECATED;
+	}
+
+	return ItemDefinition->Sounds;
+}
+
+void AInventoryItemBase::GetEquippedAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	GetItemAnimations().GetAssetPaths(OutPaths);
+	GetItemSounds().GetAssetPaths(OutPaths);
+}
+
+void AInventoryItemBase::WarnMissingDefinition() const
+{
+	static TSet<FString> WarnedClassPaths;
+
+	bool bAlreadyWarned = false;
+	WarnedClassPaths.Add(GetClass()->GetPathName(), &bAlreadyWarned);
+
+	if (!bAlreadyWarned)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s has no item definition and uses its deprecated per actor settings. Give it an InventoryItemDefinition asset"), *GetClass()->GetName());
+	}
+}
+
 UAnimSequence* AInventoryItemBase::GetCharacterEquipAnim() const
 {
-	return ItemAnimations.Character_EquipAnim;
+	return GetItemAnimations().Character_EquipAnim.Get();
 }
 
 UAnimSequence* AInventoryItemBase::GetItemEquipAnim() const
 {
-	return ItemAnimations.Item_EquipAnim;
+	return GetItemAnimations().Item_EquipAnim.Get();
+}
+
+bool AInventoryItemBase::AreAssetsResident() const
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	GetEquippedAssetPaths(AssetPaths);
+
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (!AssetPath.ResolveObject())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AInventoryItemBase::OnAssetsLoaded()
+{
+	if (IsEquipped)
+	{
+		UpdateIdleAnimation(StoredInventoryComponent);
+	}
+}
+
+FAmmoInfo AInventoryItemBase::GetAmmoInfo() const
+{
+	return ItemAmmoInfo;
+}
+
+void AInventoryItemBase::SetAmmoInfo(const FAmmoInfo& NewAmmoInfo)
+{
+	ItemAmmoInfo = NewAmmoInfo;
 }
 
 // Sets default values
 AInventoryItemBase::AInventoryItemBase()
 {
 	
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Automatic fire runs on the fire scheduler's timer, so items do not need to tick. Blueprints that implement Tick still get it
+	PrimaryActorTick.bCanEverTick = false;
 
-	EquipSocketName = "S_GripPoint";
+	ItemDefinition = nullptr;
+	bCreatedLegacyDefinition = false;
+	EquipSocketName_DEPRECATED = "S_GripPoint";
+	InventorySlotType_DEPRECATED = ESlotType::WeaponType;
 	IsEquipped = false;
 
+	FireMode = EItemFireMode::SemiAuto;
+	RoundsPerMinute = 600.0f;
+	BurstCount = 3;
+	RoundsPerShot = 1;
+	HitscanPellets = 1;
+	HitscanSpreadAngle = 0.0f;
+	HitscanDamagePerPellet = 10.0f;
+	HitscanRange = 10000.0f;
+	NextShotTime = 0.0f;
+	ShotsLeft = 0;
+
 	ItemMesh = CreateDefaultSubobject<USkeletalMeshComponent>("ItemMesh");
 	if (ItemMesh)
 	{
@@ -75,6 +228,180 @@ AInventoryItemBase::AInventoryItemBase()
 
 }
 
+void AInventoryItemBase::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	Ar.UsingCustomVersion(FInventoryItemVersion::GUID);
+}
+
+void AInventoryItemBase::PostLoad()
+{
+	Super::PostLoad();
+
+	// Only class defaults saved before definitions existed carry settings to move. Once resaved, the definition built here is saved with them
+	if (!HasAnyFlags(RF_ClassDefaultObject) || GetLinkerCustomVersion(FInventoryItemVersion::GUID) >= FInventoryItemVersion::MovedToItemDefinitions)
+	{
+		return;
+	}
+
+	// A child blueprint starts out with the definition its parent's migration built, but may have overridden the settings it was built from
+	const AInventoryItemBase* Archetype = Cast<AInventoryItemBase>(GetArchetype());
+	const bool bInheritedLegacyDefinition = Archetype && Archetype->bCreatedLegacyDefinition && ItemDefinition == Archetype->ItemDefinition;
+	if (ItemDefinition && !bInheritedLegacyDefinition)
+	{
+		return;
+	}
+
+	// Move the settings into a definition kept in the item's own package, so they survive a resave
+	const FName DefinitionName = MakeUniqueObjectName(GetOutermost(), UInventoryItemDefinition::StaticClass(), *FString::Printf(TEXT("%s_LegacyDefinition"), *GetClass()->GetName()));
+
+	UInventoryItemDefinition* LegacyDefinition = NewObject<UInventoryItemDefinition>(GetOutermost(), DefinitionName);
+	LegacyDefinition->InventorySlotType = InventorySlotType_DEPRECATED;
+	LegacyDefinition->EquipSocketName = EquipSocketName_DEPRECATED;
+	LegacyDefinition->DefaultAmmoInfo = ItemAmmoInfo;
+	LegacyDefinition->Animations = ItemAnimations_DEPRECATED;
+	LegacyDefinition->Sounds = ItemSounds_DEPRECATED;
+
+	ItemDefinition = LegacyDefinition;
+	bCreatedLegacyDefinition = true;
+
+	UE_LOG(LogTemp, Warning, TEXT("%s had no item definition, its deprecated settings were moved into %s. Move them into an InventoryItemDefinition asset"), *GetClass()->GetName(), *DefinitionName.ToString());
+}
+
+void AInventoryItemBase::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// The inventory overwrites this with the slot's ammo right after spawning. Items without a definition keep their class default
+	if (ItemDefinition)
+	{
+		ItemAmmoInfo = ItemDefinition->DefaultAmmoInfo;
+	}
+}
+
+void AInventoryItemBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(ShotTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AInventoryItemBase::StartFiring()
+{
+	if (IsFiring())
+	{
+		return;
+	}
+
+	// A shot from long ago must not be caught up on. A recent one still holds back the next shot to keep the fire rate across presses
+	NextShotTime = FMath::Max(NextShotTime, GetWorld()->GetTimeSeconds());
+
+	switch (FireMode)
+	{
+	case EItemFireMode::Burst:
+		ShotsLeft = FMath::Max(BurstCount, 1);
+		break;
+
+	case EItemFireMode::FullAuto:
+		ShotsLeft = -1;
+		break;
+
+	default:
+		ShotsLeft = 1;
+		break;
+	}
+
+	FireScheduledShots();
+}
+
+void AInventoryItemBase::StopFiring()
+{
+	if (FireMode == EItemFireMode::FullAuto)
+	{
+		ShotsLeft = 0;
+		GetWorldTimerManager().ClearTimer(ShotTimerHandle);
+	}
+}
+
+bool AInventoryItemBase::IsFiring() const
+{
+	return ShotsLeft != 0;
+}
+
+int AInventoryItemBase::SubmitHitscanShot(const FVector& Origin, const FVector& Direction)
+{
+	UHitscanResolverSubsystem* HitscanResolver = GetWorld()->GetSubsystem<UHitscanResolverSubsystem>();
+	if (!HitscanResolver)
+	{
+		return 0;
+	}
+
+	FHitscanShot Shot;
+	Shot.Origin = Origin;
+	Shot.Direction = Direction;
+	Shot.SpreadAngle = HitscanSpreadAngle;
+	Shot.NumPellets = HitscanPellets;
+	Shot.DamagePerPellet = HitscanDamagePerPellet;
+	Shot.Range = HitscanRange;
+	Shot.DamageType = HitscanDamageType;
+
+	return HitscanResolver->SubmitShot(this, Shot);
+}
+
+int AInventoryItemBase::LaunchProjectile(const FVector& Origin, const FVector& Velocity)
+{
+	UProjectileSimulationSubsystem* ProjectileSimulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>();
+	if (!ProjectileSimulation)
+	{
+		return 0;
+	}
+
+	return ProjectileSimulation->LaunchProjectile(this, ProjectileSpec, Origin, Velocity);
+}
+
+void AInventoryItemBase::FireScheduledShots()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const float ShotInterval = 60.0f / FMath::Max(RoundsPerMinute, 1.0f);
+
+	// At fire rates above the frame rate several shots are due each frame, so fire all of them on their own timestamps
+	while (ShotsLeft != 0 && NextShotTime <= CurrentTime)
+	{
+		if (!FireShot(CurrentTime - NextShotTime))
+		{
+			ShotsLeft = 0;
+			break;
+		}
+
+		NextShotTime += ShotInterval;
+
+		if (ShotsLeft > 0)
+		{
+			ShotsLeft--;
+		}
+	}
+
+	if (ShotsLeft != 0)
+	{
+		// A rate of 0 would clear the timer instead of setting it
+		GetWorldTimerManager().SetTimer(ShotTimerHandle, this, &AInventoryItemBase::FireScheduledShots, FMath::Max(NextShotTime - CurrentTime, KINDA_SMALL_NUMBER), false);
+	}
+}
+
+bool AInventoryItemBase::FireShot(float TimeSinceShot)
+{
+	if (ItemAmmoInfo.NumRounds < RoundsPerShot || (RoundsPerShot == 0 && !AvailableRounds()))
+	{
+		return false;
+	}
+
+	DepleteRounds(RoundsPerShot);
+	OnShot(TimeSinceShot);
+
+	return true;
+}
+
 void AInventoryItemBase::UpdateIdleAnimation(UInventoryComponentBase* InventoryComponent)
 {	
 	if (InventoryComponent)
@@ -88,7 +415,8 @@ void AInventoryItemBase::UpdateIdleAnimation(UInventoryComponentBase* InventoryC
 				UGameCharacterAnim* CharacterAnim = Cast<UGameCharacterAnim>(AnimatedMesh->GetAnimInstance());
 				if (CharacterAnim)
 				{
-					CharacterAnim->UpdateIdleAnimation(ItemAnimations.Character_IdleAnim);
+					// Null while the idle animation is still streaming in, which leaves the character in its fallback pose
+					CharacterAnim->UpdateIdleAnimation(GetItemAnimations().Character_IdleAnim.Get());
 				}
 			}
 		}
@@ -124,6 +452,9 @@ void AInventoryItemBase::OnEquip_Implementation(UInventoryComponentBase* Invento
 void AInventoryItemBase::OnUnEquip_Implementation()
 {	
 	IsEquipped = false;
+	ShotsLeft = 0;
+	GetWorldTimerManager().ClearTimer(ShotTimerHandle);
+
 	if (IsValid(RootComponent))
 	{
 		RootComponent->SetVisibility(false, true);
@@ -132,14 +463,12 @@ void AInventoryItemBase::OnUnEquip_Implementation()
 
 void AInventoryItemBase::OnFirePressed_Implementation()
 {
-	
-	GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Green, "OnFirePressed");
+	StartFiring();
 }
 
 void AInventoryItemBase::OnFireReleased_Implementation()
 {
-	
-	GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Green, "OnFireReleased");
+	StopFiring();
 }
 
 void AInventoryItemBase::OnCancelReloadEvent_Implementation()
@@ -5,8 +5,9 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "InventoryComponentBase.h"
-#include "Animation/AnimSequence.h"
-#include "Sound/SoundWave.h"
+#include "InventoryItemDefinition.h"
+#include "HitscanResolverSubsystem.h"
+#include "ProjectileSimulationSubsystem.h"
 
 #include "InventoryItemBase.generated.h"
 
@@ -14,161 +15,70 @@ class USceneComponent;
 class USkeletalMeshComponent;
 
 
-USTRUCT(BlueprintType)
-struct FAmmoInfo
+// How the fire scheduler fires while the fire input is held
+UENUM(BlueprintType)
+enum class EItemFireMode : uint8
 {
+	// One shot per press
+	SemiAuto UMETA(DisplayName = "Semi Auto"),
 
-public:
-	GENERATED_BODY()
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
-	int MaxMagazines;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
-	int NumMagazines;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
-	int MaxRounds;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
-	int NumRounds;
+	// BurstCount shots per press. The burst finishes even if the input is released
+	Burst UMETA(DisplayName = "Burst"),
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ammo")
-	bool UsesMagazines;
-
-	FAmmoInfo()
-	{
-		NumMagazines = MaxMagazines = 10;
-		NumRounds = MaxRounds = 10;
-		UsesMagazines = true;
-	}
+	// Shots until the input is released or the rounds run out
+	FullAuto UMETA(DisplayName = "Full Auto")
 };
 
-USTRUCT(BlueprintType)
-struct FAnimationData
+UCLASS()
+class ROUNDBASEDSHOOTER_API AInventoryItemBase : public AActor
 {
 	GENERATED_BODY()
+	
+private:
 
-public:
-
-	// animation to use on the character when equipping the item
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Character_EquipAnim;
-
-	// Animation to use on the item when equipping the item
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Item_EquipAnim;
-
-	// Base idle animation to use on the character
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Character_IdleAnim;
-
-	// Base idle animation to use on the item
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Item_IdleAnim;
-
-	// Animation to play on the character when reloading weapon
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Character_OnReloadAnim;
-
-	// Animation to play on the item on reload
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Item_OnReloadAnim;
-
-	// Animation to play on the character on fire pressed 
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Character_OnFirePressedAnim;
-
-	// Animation to play on the item when on fire pressed
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Item_OnFirePressedAnim;
-
-	// Animation to play on the character on fire released
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Character_OnFireReleasedAnim;
-
-	// Animation to play on the item on fire released
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Item_OnFireReleasedAnim;
-
-	// Animation to play on the character on throw
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Character_ThrowAnim;
-
-	// Animation to play on the item on throw
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimSequence* Item_ThrowAnim;
-
-	FAnimationData()
-	{
-		Character_EquipAnim = nullptr;
-		Item_EquipAnim = nullptr;
-		Character_IdleAnim = nullptr;
-		Item_IdleAnim = nullptr;
-		Character_OnReloadAnim = nullptr;
-		Item_OnReloadAnim = nullptr;
-		Character_OnFirePressedAnim = nullptr;
-		Item_OnFirePressedAnim = nullptr;
-		Character_OnFireReleasedAnim = nullptr;
-		Character_OnFireReleasedAnim = nullptr;
-		Item_OnFireReleasedAnim = nullptr;
-		Character_ThrowAnim = nullptr;
-		Item_ThrowAnim = nullptr;
-	}
-};
+	void UpdateIdleAnimation(UInventoryComponentBase* InventoryComponent);
 
-USTRUCT(BlueprintType)
-struct FSoundData
-{
-	GENERATED_BODY()
+	// Warns once per class that the item has no definition and runs on its deprecated settings
+	void WarnMissingDefinition() const;
 
-public:
+	// Set on class defaults whose definition PostLoad built from the deprecated settings. Not saved
+	bool bCreatedLegacyDefinition;
 
-	// Sound played when OnFirePressed triggered
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio")
-	USoundWave* OnFirePressedSound;
+	// Fires every shot whose time has come, then waits for the next one
+	void FireScheduledShots();
 
-	// Sound played on reload
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio")
-	USoundWave* OnReloadSound;
+	// Depletes the rounds of one shot and calls OnShot. Returns false if there were not enough rounds
+	bool FireShot(float TimeSinceShot);
 
-	// Sound played on equip
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio")
-	USoundWave* OnEquipSound;
+	FTimerHandle ShotTimerHandle;
 
-	// Sound played on unequip
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio")
-	USoundWave* OnUnEquipSound;
+	// World time of the next shot. Also keeps the fire rate across presses
+	float NextShotTime;
 
-	// On empty magazine 
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio")
-	USoundWave* EmptyMagazineSound;
+	// Shots left in the current press. Below 0 for no limit
+	int ShotsLeft;
 
-	FSoundData()
-	{
-		OnFirePressedSound = nullptr;
-		OnReloadSound = nullptr;
-		OnEquipSound = nullptr;
-		OnUnEquipSound = nullptr;
-		EmptyMagazineSound = nullptr;
-	}
-};
+protected:
 
-UCLASS()
-class ROUNDBASEDSHOOTER_API AInventoryItemBase : public AActor
-{
-	GENERATED_BODY()
-	
-private:
+	// Static configuration shared by every actor of this item
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	UInventoryItemDefinition* ItemDefinition;
 
-	void UpdateIdleAnimation(UInventoryComponentBase* InventoryComponent);
+	// Replaced by the definition's EquipSocketName. Moved into a definition in PostLoad
+	UPROPERTY()
+	FName EquipSocketName_DEPRECATED;
 
-protected:
+	// Replaced by the definition's InventorySlotType. Moved into a definition in PostLoad
+	UPROPERTY()
+	TEnumAsByte<ESlotType> InventorySlotType_DEPRECATED;
 
+	// Replaced by the definition's Animations. Moved into a definition in PostLoad
+	UPROPERTY()
+	FAnimationData ItemAnimations_DEPRECATED;
 
-	// The name of the socket that items will attach to
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
-	FName EquipSocketName;
+	// Replaced by the definition's Sounds. Moved into a definition in PostLoad
+	UPROPERTY()
+	FSoundData ItemSounds_DEPRECATED;
 
 	// Flag to check if this item is currently equipped
 	UPROPERTY(BlueprintReadWrite, Category = "Inventory")
@@ -180,6 +90,7 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
 	USkeletalMeshComponent* ItemMesh;
 
+	// Current ammo of this actor. Starts from the definition's default ammo. The class default is only used for items without a definition
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
 	FAmmoInfo ItemAmmoInfo;
 
@@ -192,11 +103,99 @@ protected:
 	UFUNCTION(BlueprintPure, Category = "Ammo")
 	bool AvailableRounds() const;
 
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation")
-	FAnimationData ItemAnimations;
 
-	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio")
-	FSoundData ItemSounds;
+	// How the fire scheduler fires while the fire input is held
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+	EItemFireMode FireMode;
+
+	// Fire rate of the fire scheduler
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing", meta = (ClampMin = "1.0"))
+	float RoundsPerMinute;
+
+	// Shots per press in burst mode
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing", meta = (ClampMin = "1"))
+	int BurstCount;
+
+	// Rounds depleted by every shot
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing", meta = (ClampMin = "0"))
+	int RoundsPerShot;
+
+	/**
+		Called by the fire scheduler for every shot, after its rounds were depleted. At high fire rates several shots can
+		fall in one frame, and each is called with how long ago it should have happened.
+		@param TimeSinceShot - Seconds since the shot's exact time. Use it to place tracers and effects where they would have been
+	*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "Firing")
+	void OnShot(float TimeSinceShot);
+
+	// Starts the fire scheduler. Called by the default OnFirePressed. Does nothing while a burst is still firing
+	UFUNCTION(BlueprintCallable, Category = "Firing")
+	void StartFiring();
+
+	// Stops full auto fire. Bursts and semi auto shots already started still finish. Called by the default OnFireReleased
+	UFUNCTION(BlueprintCallable, Category = "Firing")
+	void StopFiring();
+
+	// If the fire scheduler has shots left to fire
+	UFUNCTION(BlueprintPure, Category = "Firing")
+	bool IsFiring() const;
+
+	// Pellets per hitscan shot
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing|Hitscan", meta = (ClampMin = "1"))
+	int HitscanPellets;
+
+	// Half angle of the hitscan spread cone in degrees
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing|Hitscan", meta = (ClampMin = "0.0", ClampMax = "90.0"))
+	float HitscanSpreadAngle;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing|Hitscan", meta = (ClampMin = "0.0"))
+	float HitscanDamagePerPellet;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing|Hitscan", meta = (ClampMin = "0.0"))
+	float HitscanRange;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing|Hitscan")
+	TSubclassOf<UDamageType> HitscanDamageType;
+
+	/**
+		Submits a shot with this item's hitscan settings to the hitscan resolver. Damage is applied and OnHitscanResolved
+		called at the end of the frame, together with every other shot fired that frame.
+		@param Origin - Where the pellets start, e.g. the muzzle or the camera
+		@param Direction - Center of the spread cone
+		@return Id of the shot, found again in the result. 0 if the shot was not submitted
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Firing|Hitscan")
+	int SubmitHitscanShot(const FVector& Origin, const FVector& Direction);
+
+	// Called by the hitscan resolver with what a submitted shot hit, after its damage was applied
+	UFUNCTION(BlueprintImplementableEvent, Category = "Firing|Hitscan")
+	void OnHitscanResolved(const FHitscanResult& Result);
+
+	// Flight and detonation of the projectiles this item launches
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing|Projectile")
+	FProjectileSpec ProjectileSpec;
+
+	/**
+		Launches a projectile with this item's projectile spec into the projectile simulation. It is simulated without an
+		actor of its own, and OnProjectileDetonated is called once it goes off.
+		@param Origin - Launch location, e.g. the character's hand
+		@param Velocity - Launch velocity
+		@return Id of the projectile, found again in the detonation. 0 if it was not launched
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Firing|Projectile")
+	int LaunchProjectile(const FVector& Origin, const FVector& Velocity);
+
+	// Called by the projectile simulation when a launched projectile goes off, after its damage was applied
+	UFUNCTION(BlueprintImplementableEvent, Category = "Firing|Projectile")
+	void OnProjectileDetonated(const FProjectileDetonation& Detonation);
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	virtual void PostLoad() override;
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 
@@ -204,17 +203,54 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Inventory")
 	bool GetIsEquipped() const;
 
-	// Returns the character equip animation sequence
+	// Returns the item's shared definition
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	UInventoryItemDefinition* GetItemDefinition() const;
+
+	// The type of inventory slot this goes in
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	TEnumAsByte<ESlotType> GetInventorySlotType() const;
+
+	// The name of the socket the item attaches to
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FName GetEquipSocketName() const;
+
+	// Ammo a new actor of this item starts with
+	UFUNCTION(BlueprintPure, Category = "Ammo")
+	FAmmoInfo GetDefaultAmmoInfo() const;
+
+	// Animations of the item, from its definition. Replaces reading ItemAnimations
+	UFUNCTION(BlueprintPure, Category = "Animation")
+	const FAnimationData& GetItemAnimations() const;
+
+	// Sounds of the item, from its definition. Replaces reading ItemSounds
+	UFUNCTION(BlueprintPure, Category = "Audio")
+	const FSoundData& GetItemSounds() const;
+
+	// Paths of the item's animations and sounds
+	void GetEquippedAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+
+	// Returns the character equip animation sequence. Null while it is not loaded, it is never loaded here
 	UFUNCTION(BlueprintPure, Category = "Animation")
 	UAnimSequence* GetCharacterEquipAnim() const;
 
-	// Returns the item equip animation sequence
+	// Returns the item equip animation sequence. Null while it is not loaded, it is never loaded here
 	UFUNCTION(BlueprintPure, Category = "Animation")
 	UAnimSequence* GetItemEquipAnim() const;
 
-	// The type of inventory slot this goes in
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
-	TEnumAsByte<ESlotType> InventorySlotType;
+	// If the animations and sounds of the item's definition are loaded
+	UFUNCTION(BlueprintPure, Category = "Animation")
+	bool AreAssetsResident() const;
+
+	// Called by the inventory once the definition's animations and sounds have streamed in. Swaps the fallback idle pose for the item's own
+	void OnAssetsLoaded();
+
+	// Returns the current ammo state of the item
+	UFUNCTION(BlueprintPure, Category = "Ammo")
+	FAmmoInfo GetAmmoInfo() const;
+
+	// Overwrites the ammo state. Used by the inventory to carry ammo over when the item actor is created or released
+	void SetAmmoInfo(const FAmmoInfo& NewAmmoInfo);
 
 	// Sets default values for this actor's properties
 	AInventoryItemBase();
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryItemDefinition.h"
+
+namespace
+{
+	template<typename AssetType>
+	void AddAssetPath(const TSoftObjectPtr<AssetType>& Asset, TArray<FSoftObjectPath>& OutPaths)
+	{
+		if (!Asset.IsNull())
+		{
+			OutPaths.AddUnique(Asset.ToSoftObjectPath());
+		}
+	}
+}
+
+void FAnimationData::GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	AddAssetPath(Character_EquipAnim, OutPaths);
+	AddAssetPath(Item_EquipAnim, OutPaths);
+	AddAssetPath(Character_IdleAnim, OutPaths);
+	AddAssetPath(Item_IdleAnim, OutPaths);
+	AddAssetPath(Character_OnReloadAnim, OutPaths);
+	AddAssetPath(Item_OnReloadAnim, OutPaths);
+	AddAssetPath(Character_OnFirePressedAnim, OutPaths);
+	AddAssetPath(Item_OnFirePressedAnim, OutPaths);
+	AddAssetPath(Character_OnFireReleasedAnim, OutPaths);
+	AddAssetPath(Item_OnFireReleasedAnim, OutPaths);
+	AddAssetPath(Character_ThrowAnim, OutPaths);
+	AddAssetPath(Item_ThrowAnim, OutPaths);
+}
+
+void FSoundData::GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	AddAssetPath(OnFirePressedSound, OutPaths);
+	AddAssetPath(OnReloadSound, OutPaths);
+	AddAssetPath(OnEquipSound, OutPaths);
+	AddAssetPath(OnUnEquipSound, OutPaths);
+	AddAssetPath(EmptyMagazineSound, OutPaths);
+}
+
+const FPrimaryAssetType UInventoryItemDefinition::PrimaryAssetType = TEXT("InventoryItem");
+
+const FName UInventoryItemDefinition::EquippedBundle = TEXT("Equipped");
+
+UInventoryItemDefinition::UInventoryItemDefinition()
+{
+	InventorySlotType = ESlotType::WeaponType;
+	EquipSocketName = "S_GripPoint";
+}
+
+FPrimaryAssetId UInventoryItemDefinition::GetPrimaryAssetId() const
+{
+	// Class defaults are not definitions themselves
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		return Super::GetPrimaryAssetId();
+	}
+
+	// Definitions made from blueprint subclasses share the type, so every definition is found under one type
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+void UInventoryItemDefinition::GetEquippedAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	Animations.GetAssetPaths(OutPaths);
+	Sounds.GetAssetPaths(OutPaths);
+}
+
+bool UInventoryItemDefinition::AreEquippedAssetsResident() const
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	GetEquippedAssetPaths(AssetPaths);
+
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (!AssetPath.ResolveObject())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "InventoryComponentBase.h"
+#include "Animation/AnimSequence.h"
+#include "Sound/SoundWave.h"
+
+#include "InventoryItemDefinition.generated.h"
+
+// Animations of an item. Soft references, streamed in with the item's Equipped bundle before they are needed
+USTRUCT(BlueprintType)
+struct FAnimationData
+{
+	GENERATED_BODY()
+
+public:
+
+	// animation to use on the character when equipping the item
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Character_EquipAnim;
+
+	// Animation to use on the item when equipping the item
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Item_EquipAnim;
+
+	// Base idle animation to use on the character
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Character_IdleAnim;
+
+	// Base idle animation to use on the item
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Item_IdleAnim;
+
+	// Animation to play on the character when reloading weapon
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Character_OnReloadAnim;
+
+	// Animation to play on the item on reload
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Item_OnReloadAnim;
+
+	// Animation to play on the character on fire pressed 
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Character_OnFirePressedAnim;
+
+	// Animation to play on the item when on fire pressed
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Item_OnFirePressedAnim;
+
+	// Animation to play on the character on fire released
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Character_OnFireReleasedAnim;
+
+	// Animation to play on the item on fire released
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Item_OnFireReleasedAnim;
+
+	// Animation to play on the character on throw
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Character_ThrowAnim;
+
+	// Animation to play on the item on throw
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Animation", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<UAnimSequence> Item_ThrowAnim;
+
+	// Adds the paths of the animations that are set
+	void GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+};
+
+// Sounds of an item. Soft references, streamed in with the item's Equipped bundle before they are needed
+USTRUCT(BlueprintType)
+struct FSoundData
+{
+	GENERATED_BODY()
+
+public:
+
+	// Sound played when OnFirePressed triggered
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<USoundWave> OnFirePressedSound;
+
+	// Sound played on reload
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<USoundWave> OnReloadSound;
+
+	// Sound played on equip
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<USoundWave> OnEquipSound;
+
+	// Sound played on unequip
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<USoundWave> OnUnEquipSound;
+
+	// On empty magazine 
+	UPROPERTY(Editanywhere, BlueprintReadWrite, Category = "Audio", meta = (AssetBundles = "Equipped"))
+	TSoftObjectPtr<USoundWave> EmptyMagazineSound;
+
+	// Adds the paths of the sounds that are set
+	void GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+};
+
+/**
+	Static configuration of an inventory item, shared by every actor of the item instead of copied into each of them.
+	Item actors point at their definition and only keep their own mutable state, like ammo. Definitions are primary
+	assets of type InventoryItem, so the asset manager can find, track and bundle them.
+	Animations and sounds are soft references in the Equipped bundle. The inventory streams them in when an item comes
+	into reach or is added, so nothing is loaded on the game thread when it is equipped.
+*/
+UCLASS(BlueprintType)
+class ROUNDBASEDSHOOTER_API UInventoryItemDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryItemDefinition();
+
+	// Primary asset type of every item definition
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	// Asset bundle holding everything an item needs once it is in the hands
+	static const FName EquippedBundle;
+
+	// Paths of every animation and sound in the Equipped bundle that is set
+	void GetEquippedAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+
+	// If every animation and sound in the Equipped bundle is loaded
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	bool AreEquippedAssetsResident() const;
+
+	// The type of inventory slot the item goes in
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	TEnumAsByte<ESlotType> InventorySlotType;
+
+	// The name of the socket the item attaches to
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	FName EquipSocketName;
+
+	// Ammo a new item starts with. Also holds the magazine and round limits
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ammo")
+	FAmmoInfo DefaultAmmoInfo;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Animation")
+	FAnimationData Animations;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Audio")
+	FSoundData Sounds;
+};
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventorySlotLayout.h"
+
+namespace
+{
+	// Slot order matches ESlotOption
+	typedef TInventorySlotLayout<WeaponType, WeaponType, ThrowableType, GadgetType, GadgetType> FStandardSlotLayout;
+
+	typedef TInventorySlotLayout<WeaponType, WeaponType, ThrowableType> FWeaponsOnlySlotLayout;
+
+	static_assert(FStandardSlotLayout::GetFirstSlotOfType(ThrowableType) == ESlotOption::Throwable, "The standard layout's throwable slot must match ESlotOption");
+
+	// Indexed by EInventoryLayout
+	const FInventorySlotLayout* const SlotLayouts[] =
+	{
+		&FStandardSlotLayout::Layout,
+		&FWeaponsOnlySlotLayout::Layout
+	};
+
+	static_assert(UE_ARRAY_COUNT(SlotLayouts) == (int32)EInventoryLayout::Count, "Every inventory layout needs a slot layout");
+}
+
+const FInventorySlotLayout& GetInventorySlotLayout(EInventoryLayout InventoryLayout)
+{
+	// Out of range values wrap instead of being checked
+	return *SlotLayouts[(uint8)InventoryLayout % (uint8)EInventoryLayout::Count];
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventorySlotLayout.generated.h"
+
+// Slots of the standard loadout layout. Other layouts use the same indices for their own slots
+UENUM(Blueprintable)
+enum ESlotOption
+{
+	PrimaryMainWeapon UMETA(DisplayName = "PrimaryMainWeapon"),
+	SecondaryMainWeapon UMETA(DisplayName = "SecondaryMainWeapon"),
+	Throwable UMETA(DisplayName = "Throwable"),
+	PrimaryGadget UMETA(DisplayName = "PrimaryGadget"),
+	SecondaryGadget UMETA(DisplayName = "SecondaryGadget")
+};
+
+UENUM(Blueprintable)
+enum ESlotType
+{
+	WeaponType UMETA(DisplayName = "Weapon"),
+	GadgetType UMETA(DisplayName = "Gadget"),
+	ThrowableType UMETA(DisplayName = "Throwable")
+};
+
+// Loadout layouts game modes can give inventories. Each one is a slot layout built at compile time
+UENUM(BlueprintType)
+enum class EInventoryLayout : uint8
+{
+	// Two main weapons, a throwable and two gadgets
+	Standard UMETA(DisplayName = "Standard"),
+
+	// Two main weapons and a throwable
+	WeaponsOnly UMETA(DisplayName = "Weapons Only"),
+
+	Count UMETA(Hidden)
+};
+
+constexpr int32 NumInventorySlotTypes = ESlotType::ThrowableType + 1;
+
+// Size of the slot storage of every inventory. A power of two, so slot indices are masked into range instead of checked
+constexpr int32 MaxInventorySlots = 8;
+
+// Slot no layout uses and that is always empty. Masked indices of slots a layout does not have end up here or on other empty slots
+constexpr int32 NoInventorySlot = MaxInventorySlots - 1;
+
+// Masks any slot index into the slot storage
+FORCEINLINE int32 MaskInventorySlot(int32 SlotIndex)
+{
+	return SlotIndex & (MaxInventorySlots - 1);
+}
+
+// Slot to slot type table of a loadout layout. Built by TInventorySlotLayout, never at runtime
+struct FInventorySlotLayout
+{
+	// Slots in use. Always below MaxInventorySlots so NoInventorySlot stays free
+	int32 NumSlots;
+
+	// Bit per slot of each slot type
+	uint32 SlotTypeMasks[NumInventorySlotTypes];
+
+	// Lowest slot of each slot type. NoInventorySlot if the layout has none
+	int32 FirstSlotOfType[NumInventorySlotTypes];
+
+	// Slot type of each slot
+	ESlotType SlotTypes[MaxInventorySlots];
+};
+
+/**
+	Compile time loadout layout, listing the type of each slot in slot order, e.g.
+	TInventorySlotLayout<WeaponType, WeaponType, ThrowableType>::Layout is two weapon slots followed by a throwable slot.
+*/
+template<ESlotType... InSlotTypes>
+struct TInventorySlotLayout
+{
+	static constexpr int32 NumSlots = sizeof...(InSlotTypes);
+
+	static_assert(NumSlots > 0 && NumSlots < MaxInventorySlots, "Inventory slot layouts need at least one slot and must leave NoInventorySlot free");
+
+	static constexpr uint32 GetSlotTypeMask(ESlotType SlotType)
+	{
+		constexpr ESlotType SlotTypes[] = { InSlotTypes... };
+
+		uint32 SlotTypeMask = 0;
+		for (int32 SlotIndex = 0; SlotIndex < NumSlots; SlotIndex++)
+		{
+			SlotTypeMask |= (SlotTypes[SlotIndex] == SlotType ? 1u : 0u) << SlotIndex;
+		}
+
+		return SlotTypeMask;
+	}
+
+	static constexpr int32 GetFirstSlotOfType(ESlotType SlotType)
+	{
+		constexpr ESlotType SlotTypes[] = { InSlotTypes... };
+
+		for (int32 SlotIndex = 0; SlotIndex < NumSlots; SlotIndex++)
+		{
+			if (SlotTypes[SlotIndex] == SlotType)
+			{
+				return SlotIndex;
+			}
+		}
+
+		return NoInventorySlot;
+	}
+
+	// The layout's table
+	static const FInventorySlotLayout Layout;
+};
+
+// Defined out of the class, the constexpr functions above can not be called until the class is complete
+template<ESlotType... InSlotTypes>
+const FInventorySlotLayout TInventorySlotLayout<InSlotTypes...>::Layout =
+{
+	NumSlots,
+	{ GetSlotTypeMask(WeaponType), GetSlotTypeMask(GadgetType), GetSlotTypeMask(ThrowableType) },
+	{ GetFirstSlotOfType(WeaponType), GetFirstSlotOfType(GadgetType), GetFirstSlotOfType(ThrowableType) },
+	{ InSlotTypes... }
+};
+
+// Slot layout of the loadout layout
+ROUNDBASEDSHOOTER_API const FInventorySlotLayout& GetInventorySlotLayout(EInventoryLayout InventoryLayout);
@@ -0,0 +1,427 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileSimulationSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "GameFramework/PlayerController.h"
+#include "InventoryItemBase.h"
+#include "Kismet/GameplayStatics.h"
+#include "Math/VectorRegister.h"
+#include "Characters/CharacterSpatialHashSubsystem.h"
+#include "Characters/GameCharacterBase.h"
+
+UProjectileSimulationSubsystem::UProjectileSimulationSubsystem()
+{
+	TraceChannel = ECC_Visibility;
+	MinProjectilesForParallelTrace = 16;
+	MaxCharacterExtent = 150.0f;
+	VisualActorDistance = 5000.0f;
+	RestingSpeed = 50.0f;
+	bIsInitialized = false;
+	NextProjectileId = 1;
+}
+
+void UProjectileSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bIsInitialized = true;
+}
+
+void UProjectileSimulationSubsystem::Deinitialize()
+{
+	bIsInitialized = false;
+
+	for (int32 ProjectileIndex = PositionsX.Num() - 1; ProjectileIndex >= 0; ProjectileIndex--)
+	{
+		RemoveProjectile(ProjectileIndex);
+	}
+
+	Super::Deinitialize();
+}
+
+int UProjectileSimulationSubsystem::LaunchProjectile(AInventoryItemBase* Item, const FProjectileSpec& Spec, const FVector& Origin, const FVector& Velocity)
+{
+	if (!bIsInitialized)
+	{
+		return 0;
+	}
+
+	PositionsX.Add(Origin.X);
+	PositionsY.Add(Origin.Y);
+	PositionsZ.Add(Origin.Z);
+	VelocitiesX.Add(Velocity.X);
+	VelocitiesY.Add(Velocity.Y);
+	VelocitiesZ.Add(Velocity.Z);
+	GravitiesZ.Add(GetWorld()->GetGravityZ() * Spec.GravityScale);
+	TimesLeft.Add(Spec.Lifetime);
+
+	Specs.Add(Spec);
+	Items.Add(Item);
+	ProjectileIds.Add(NextProjectileId);
+	VisualActors.Add(nullptr);
+
+	const int32 ProjectileId = NextProjectileId;
+
+	// Skip 0 so it can stay the invalid id
+	NextProjectileId = NextProjectileId == MAX_int32 ? 1 : NextProjectileId + 1;
+
+	return ProjectileId;
+}
+
+int UProjectileSimulationSubsystem::GetNumProjectiles() const
+{
+	return PositionsX.Num();
+}
+
+void UProjectileSimulationSubsystem::Integrate(float DeltaTime)
+{
+	const int32 NumProjectiles = PositionsX.Num();
+	const int32 NumVectorProjectiles = NumProjectiles & ~3;
+
+	float* RESTRICT PositionX = PositionsX.GetData();
+	float* RESTRICT PositionY = PositionsY.GetData();
+	float* RESTRICT PositionZ = PositionsZ.GetData();
+	float* RESTRICT VelocityX = VelocitiesX.GetData();
+	float* RESTRICT VelocityY = VelocitiesY.GetData();
+	float* RESTRICT VelocityZ = VelocitiesZ.GetData();
+	const float* RESTRICT GravityZ = GravitiesZ.GetData();
+	float* RESTRICT TimeLeft = TimesLeft.GetData();
+
+	const VectorRegister DeltaTimes = VectorSetFloat1(DeltaTime);
+
+	// Semi implicit Euler. Gravity only ever pulls on Z
+	for (int32 ProjectileIndex = 0; ProjectileIndex < NumVectorProjectiles; ProjectileIndex += 4)
+	{
+		const VectorRegister NewVelocityZ = VectorMultiplyAdd(VectorLoad(GravityZ + ProjectileIndex), DeltaTimes, VectorLoad(VelocityZ + ProjectileIndex));
+		VectorStore(NewVelocityZ, VelocityZ + ProjectileIndex);
+
+		VectorStore(VectorMultiplyAdd(VectorLoad(VelocityX + ProjectileIndex), DeltaTimes, VectorLoad(PositionX + ProjectileIndex)), PositionX + ProjectileIndex);
+		VectorStore(VectorMultiplyAdd(VectorLoad(VelocityY + ProjectileIndex), DeltaTimes, VectorLoad(PositionY + ProjectileIndex)), PositionY + ProjectileIndex);
+		VectorStore(VectorMultiplyAdd(NewVelocityZ, DeltaTimes, VectorLoad(PositionZ + ProjectileIndex)), PositionZ + ProjectileIndex);
+		VectorStore(VectorSubtract(VectorLoad(TimeLeft + ProjectileIndex), DeltaTimes), TimeLeft + ProjectileIndex);
+	}
+
+	for (int32 ProjectileIndex = NumVectorProjectiles; ProjectileIndex < NumProjectiles; ProjectileIndex++)
+	{
+		VelocityZ[ProjectileIndex] += GravityZ[ProjectileIndex] * DeltaTime;
+		PositionX[ProjectileIndex] += VelocityX[ProjectileIndex] * DeltaTime;
+		PositionY[ProjectileIndex] += VelocityY[ProjectileIndex] * DeltaTime;
+		PositionZ[ProjectileIndex] += VelocityZ[ProjectileIndex] * DeltaTime;
+		TimeLeft[ProjectileIndex] -= DeltaTime;
+	}
+}
+
+AActor* UProjectileSimulationSubsystem::SweepCharacters(int32 ProjectileIndex, const FVector& Start, const FVector& End) const
+{
+	const UCharacterSpatialHashSubsystem* CharacterSpatialHash = GetWorld()->GetSubsystem<UCharacterSpatialHashSubsystem>();
+	if (!CharacterSpatialHash)
+	{
+		return nullptr;
+	}
+
+	// Players' projectiles hit enemies and everyone else's hit players
+	const AInventoryItemBase* Item = Items[ProjectileIndex].Get();
+	const APawn* OwnerPawn = Item ? Cast<APawn>(Item->GetOwner()) : nullptr;
+	const ECharacterQueryFilter Filter = !OwnerPawn ? ECharacterQueryFilter::Alive : OwnerPawn->IsPlayerControlled() ? ECharacterQueryFilter::AliveEnemies : ECharacterQueryFilter::AlivePlayers;
+
+	const float Radius = Specs[ProjectileIndex].Radius;
+
+	NearbyCharacters.Reset();
+	CharacterSpatialHash->QuerySphere((Start + End) * 0.5f, FVector::Dist(Start, End) * 0.5f + Radius + MaxCharacterExtent, Filter, NearbyCharacters);
+
+	AActor* FirstHitCharacter = nullptr;
+	float FirstHitDistanceSquared = MAX_flt;
+
+	for (AGameCharacterBase* Character : NearbyCharacters)
+	{
+		if (Character == OwnerPawn)
+		{
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+		const FVector CapsuleAxis(0.0f, 0.0f, FMath::Max(Capsule->GetScaledCapsuleHalfHeight() - CapsuleRadius, 0.0f));
+		const FVector CapsuleCenter = Capsule->GetComponentLocation();
+
+		// The step hits the capsule if it passes within the capsule radius of the capsule's inner segment
+		FVector StepPoint;
+		FVector CapsulePoint;
+		FMath::SegmentDistToSegmentSafe(Start, End, CapsuleCenter - CapsuleAxis, CapsuleCenter + CapsuleAxis, StepPoint, CapsulePoint);
+
+		if (FVector::DistSquared(StepPoint, CapsulePoint) <= FMath::Square(CapsuleRadius + Radius))
+		{
+			const float DistanceSquared = FVector::DistSquared(Start, StepPoint);
+			if (DistanceSquared < FirstHitDistanceSquared)
+			{
+				FirstHitDistanceSquared = DistanceSquared;
+				FirstHitCharacter = Character;
+			}
+		}
+	}
+
+	return FirstHitCharacter;
+}
+
+void UProjectileSimulationSubsystem::Detonate(int32 ProjectileIndex, AActor* HitActor)
+{
+	const FVector Location(PositionsX[ProjectileIndex], PositionsY[ProjectileIndex], PositionsZ[ProjectileIndex]);
+	const FProjectileSpec& Spec = Specs[ProjectileIndex];
+
+	AInventoryItemBase* Item = Items[ProjectileIndex].Get();
+	const APawn* OwnerPawn = Item ? Cast<APawn>(Item->GetOwner()) : nullptr;
+	AController* InstigatorController = OwnerPawn ? OwnerPawn->GetController() : nullptr;
+	const TSubclassOf<UDamageType> DamageType = Spec.DamageType ? Spec.DamageType : TSubclassOf<UDamageType>(UDamageType::StaticClass());
+
+	if (Spec.Damage > 0.0f)
+	{
+		if (Spec.DamageRadius > 0.0f)
+		{
+			UGameplayStatics::ApplyRadialDamage(GetWorld(), Spec.Damage, Location, Spec.DamageRadius, DamageType, TArray<AActor*>(), Item, InstigatorController, false, TraceChannel);
+		}
+		else if (IsValid(HitActor))
+		{
+			UGameplayStatics::ApplyDamage(HitActor, Spec.Damage, InstigatorController, Item, DamageType);
+		}
+	}
+
+	FProjectileDetonation Detonation;
+	Detonation.ProjectileId = ProjectileIds[ProjectileIndex];
+	Detonation.Location = Location;
+	Detonation.HitActor = HitActor;
+
+	// Removed before the item hears about it, so the item can launch again straight away
+	RemoveProjectile(ProjectileIndex);
+
+	if (IsValid(Item))
+	{
+		Item->OnProjectileDetonated(Detonation);
+	}
+}
+
+void UProjectileSimulationSubsystem::RemoveProjectile(int32 ProjectileIndex)
+{
+	if (IsValid(VisualActors[ProjectileIndex]))
+	{
+		VisualActors[ProjectileIndex]->Destroy();
+	}
+
+	PositionsX.RemoveAtSwap(ProjectileIndex, 1, false);
+	PositionsY.RemoveAtSwap(ProjectileIndex, 1, false);
+	PositionsZ.RemoveAtSwap(ProjectileIndex, 1, false);
+	VelocitiesX.RemoveAtSwap(ProjectileIndex, 1, false);
+	VelocitiesY.RemoveAtSwap(ProjectileIndex, 1, false);
+	VelocitiesZ.RemoveAtSwap(ProjectileIndex, 1, false);
+	GravitiesZ.RemoveAtSwap(ProjectileIndex, 1, false);
+	TimesLeft.RemoveAtSwap(ProjectileIndex, 1, false);
+	Specs.RemoveAtSwap(ProjectileIndex, 1, false);
+	Items.RemoveAtSwap(ProjectileIndex, 1, false);
+	ProjectileIds.RemoveAtSwap(ProjectileIndex, 1, false);
+	VisualActors.RemoveAtSwap(ProjectileIndex, 1, false);
+}
+
+void UProjectileSimulationSubsystem::UpdateVisualActors()
+{
+	UWorld* World = GetWorld();
+
+	TArray<FVector, TInlineAllocator<4>> CameraLocations;
+	for (FConstPlayerControllerIterator PlayerControllerIt = World->GetPlayerControllerIterator(); PlayerControllerIt; ++PlayerControllerIt)
+	{
+		const APlayerController* PlayerController = PlayerControllerIt->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			CameraLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+	}
+
+	const float VisualActorDistanceSquared = FMath::Square(VisualActorDistance);
+
+	for (int32 ProjectileIndex = 0; ProjectileIndex < PositionsX.Num(); ProjectileIndex++)
+	{
+		const TSubclassOf<AActor> VisualActorClass = Specs[ProjectileIndex].VisualActorClass;
+		if (!VisualActorClass)
+		{
+			continue;
+		}
+
+		const FVector Location(PositionsX[ProjectileIndex], PositionsY[ProjectileIndex], PositionsZ[ProjectileIndex]);
+
+		bool bNearCamera = false;
+		for (const FVector& CameraLocation : CameraLocations)
+		{
+			bNearCamera |= FVector::DistSquared(Location, CameraLocation) <= VisualActorDistanceSquared;
+		}
+
+		AActor*& VisualActor = VisualActors[ProjectileIndex];
+		const FVector Velocity(VelocitiesX[ProjectileIndex], VelocitiesY[ProjectileIndex], VelocitiesZ[ProjectileIndex]);
+		const FRotator Rotation = Velocity.IsNearlyZero() ? FRotator::ZeroRotator : Velocity.Rotation();
+
+		if (!bNearCamera)
+		{
+			if (IsValid(VisualActor))
+			{
+				VisualActor->Destroy();
+			}
+
+			VisualActor = nullptr;
+		}
+		else if (!IsValid(VisualActor))
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+			VisualActor = World->SpawnActor<AActor>(VisualActorClass, Location, Rotation, SpawnParams);
+			if (VisualActor)
+			{
+				VisualActor->SetActorEnableCollision(false);
+			}
+		}
+		else if (!Velocity.IsNearlyZero())
+		{
+			VisualActor->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		}
+	}
+}
+
+void UProjectileSimulationSubsystem::Tick(float DeltaTime)
+{
+	const int32 NumProjectiles = PositionsX.Num();
+
+	StepStarts.SetNumUninitialized(NumProjectiles);
+	for (int32 ProjectileIndex = 0; ProjectileIndex < NumProjectiles; ProjectileIndex++)
+	{
+		StepStarts[ProjectileIndex] = FVector(PositionsX[ProjectileIndex], PositionsY[ProjectileIndex], PositionsZ[ProjectileIndex]);
+	}
+
+	Integrate(DeltaTime);
+
+	// Sweep the steps of projectiles that collide with the world. Owners are looked up here, weak pointers are not for worker threads
+	WorldTraceSlots.Reset();
+	WorldTraceSlots.Init(INDEX_NONE, NumProjectiles);
+	WorldTraceIndices.Reset();
+	WorldTraceOwners.Reset();
+
+	for (int32 ProjectileIndex = 0; ProjectileIndex < NumProjectiles; ProjectileIndex++)
+	{
+		// Resting projectiles have nothing to trace
+		const bool bIsResting = GravitiesZ[ProjectileIndex] == 0.0f && VelocitiesX[ProjectileIndex] == 0.0f && VelocitiesY[ProjectileIndex] == 0.0f && VelocitiesZ[ProjectileIndex] == 0.0f;
+
+		if (Specs[ProjectileIndex].bCollideWithWorld && !bIsResting)
+		{
+			WorldTraceSlots[ProjectileIndex] = WorldTraceIndices.Add(ProjectileIndex);
+
+			const AInventoryItemBase* Item = Items[ProjectileIndex].Get();
+			WorldTraceOwners.Add(Item ? Item->GetOwner() : nullptr);
+		}
+	}
+
+	WorldHits.SetNum(WorldTraceIndices.Num(), false);
+	WorldHitFlags.SetNum(WorldTraceIndices.Num(), false);
+
+	UWorld* World = GetWorld();
+	const ECollisionChannel Channel = TraceChannel;
+
+	ParallelFor(WorldTraceIndices.Num(), [this, World, Channel](int32 TraceIndex)
+	{
+		const int32 ProjectileIndex = WorldTraceIndices[TraceIndex];
+		const FVector StepEnd(PositionsX[ProjectileIndex], PositionsY[ProjectileIndex], PositionsZ[ProjectileIndex]);
+		const float Radius = Specs[ProjectileIndex].Radius;
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileStep), false, WorldTraceOwners[TraceIndex]);
+		QueryParams.AddIgnoredActor(VisualActors[ProjectileIndex]);
+
+		// Sweep the projectile's sphere so it does not clip through thin walls and corners. Hit locations are then the sphere's center
+		if (Radius > 0.0f)
+		{
+			WorldHitFlags[TraceIndex] = World->SweepSingleByChannel(WorldHits[TraceIndex], StepStarts[ProjectileIndex], StepEnd, FQuat::Identity, Channel, FCollisionShape::MakeSphere(Radius), QueryParams);
+		}
+		else
+		{
+			WorldHitFlags[TraceIndex] = World->LineTraceSingleByChannel(WorldHits[TraceIndex], StepStarts[ProjectileIndex], StepEnd, Channel, QueryParams);
+		}
+	}, WorldTraceIndices.Num() < MinProjectilesForParallelTrace);
+
+	// Backwards, so a detonated projectile is only ever replaced by one already handled. Projectiles launched from detonation events wait for the next step
+	for (int32 ProjectileIndex = NumProjectiles - 1; ProjectileIndex >= 0; ProjectileIndex--)
+	{
+		const FProjectileSpec& Spec = Specs[ProjectileIndex];
+		const int32 WorldTraceSlot = WorldTraceSlots[ProjectileIndex];
+		const FHitResult* WorldHit = WorldTraceSlot != INDEX_NONE && WorldHitFlags[WorldTraceSlot] ? &WorldHits[WorldTraceSlot] : nullptr;
+
+		// Characters behind the wall the step hit can not be hit
+		const FVector StepEnd = WorldHit ? WorldHit->Location : FVector(PositionsX[ProjectileIndex], PositionsY[ProjectileIndex], PositionsZ[ProjectileIndex]);
+
+		if (Spec.bDetonateOnCharacterHit)
+		{
+			AActor* HitCharacter = SweepCharacters(ProjectileIndex, StepStarts[ProjectileIndex], StepEnd);
+			if (HitCharacter)
+			{
+				Detonate(ProjectileIndex, HitCharacter);
+				continue;
+			}
+		}
+
+		if (WorldHit)
+		{
+			// The hit location is already the sphere's center, so only back off a little. Push out of geometry the sweep started in
+			const FVector HitNormal = WorldHit->ImpactNormal;
+			FVector Location = WorldHit->Location + HitNormal * ((WorldHit->bStartPenetrating ? WorldHit->PenetrationDepth : 0.0f) + 1.0f);
+
+			PositionsX[ProjectileIndex] = Location.X;
+			PositionsY[ProjectileIndex] = Location.Y;
+			PositionsZ[ProjectileIndex] = Location.Z;
+
+			if (Spec.Restitution <= 0.0f)
+			{
+				Detonate(ProjectileIndex, nullptr);
+				continue;
+			}
+
+			FVector Velocity = FVector(VelocitiesX[ProjectileIndex], VelocitiesY[ProjectileIndex], VelocitiesZ[ProjectileIndex]).MirrorByVector(HitNormal) * Spec.Restitution;
+
+			// Settle on the floor rather than bouncing a little every step
+			if (Velocity.SizeSquared() < FMath::Square(RestingSpeed) && HitNormal.Z > 0.7f)
+			{
+				Velocity = FVector::ZeroVector;
+				GravitiesZ[ProjectileIndex] = 0.0f;
+			}
+
+			VelocitiesX[ProjectileIndex] = Velocity.X;
+			VelocitiesY[ProjectileIndex] = Velocity.Y;
+			VelocitiesZ[ProjectileIndex] = Velocity.Z;
+		}
+
+		if (TimesLeft[ProjectileIndex] <= 0.0f)
+		{
+			Detonate(ProjectileIndex, nullptr);
+		}
+	}
+
+	UpdateVisualActors();
+}
+
+bool UProjectileSimulationSubsystem::IsTickable() const
+{
+	return bIsInitialized && PositionsX.Num() > 0;
+}
+
+ETickableTickType UProjectileSimulationSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UProjectileSimulationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UProjectileSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSimulationSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ProjectileSimulationSubsystem.generated.h"
+
+class AGameCharacterBase;
+class AInventoryItemBase;
+class UDamageType;
+
+// How a simulated projectile flies and what it does when it goes off
+USTRUCT(BlueprintType)
+struct FProjectileSpec
+{
+	GENERATED_BODY()
+
+public:
+
+	// Collision radius against characters and the world
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float Radius;
+
+	// Multiplier of the world gravity. 0 for rockets
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+	float GravityScale;
+
+	// Seconds until the projectile goes off on its own, e.g. a grenade fuse
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float Lifetime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float Damage;
+
+	// Radius of the explosion damage. 0 to only damage the character hit directly
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float DamageRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+	TSubclassOf<UDamageType> DamageType;
+
+	// Trace against the world each step. Without it the projectile only hits characters
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+	bool bCollideWithWorld;
+
+	// Speed kept when bouncing off the world. 0 to go off on the first world hit instead of bouncing
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Restitution;
+
+	// Go off when hitting a character. Otherwise it passes through and waits for its lifetime
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+	bool bDetonateOnCharacterHit;
+
+	// Actor shown for the projectile while it is near a local player's camera. Moved every step, it must not collide or simulate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+	TSubclassOf<AActor> VisualActorClass;
+
+	FProjectileSpec()
+	{
+		Radius = 5.0f;
+		GravityScale = 1.0f;
+		Lifetime = 3.0f;
+		Damage = 100.0f;
+		DamageRadius = 400.0f;
+		bCollideWithWorld = true;
+		Restitution = 0.3f;
+		bDetonateOnCharacterHit = false;
+	}
+};
+
+// A simulated projectile going off, handed back to the item that launched it
+USTRUCT(BlueprintType)
+struct FProjectileDetonation
+{
+	GENERATED_BODY()
+
+public:
+
+	// Id returned when the projectile was launched
+	UPROPERTY(BlueprintReadOnly, Category = "Projectile")
+	int ProjectileId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Projectile")
+	FVector Location;
+
+	// Character hit directly. Null if the projectile went off on the world or at the end of its lifetime
+	UPROPERTY(BlueprintReadOnly, Category = "Projectile")
+	AActor* HitActor;
+
+	FProjectileDetonation()
+	{
+		ProjectileId = 0;
+		Location = FVector::ZeroVector;
+		HitActor = nullptr;
+	}
+};
+
+/**
+	Simulates throwables and slow projectiles without an actor or physics body each. Positions, velocities and lifetimes are
+	kept in contiguous arrays and integrated four at a time with SIMD. Each step is swept against the capsules of nearby
+	characters from the character spatial hash and, for projectiles that want it, traced against the world in parallel.
+	Visual actors are only spawned for projectiles near a local player's camera.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UProjectileSimulationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UProjectileSimulationSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+		Starts simulating a projectile.
+		@param Item - Item launching the projectile. Gets OnProjectileDetonated and is the damage causer. Its owner is never hit
+		@param Spec - How the projectile flies and goes off
+		@param Origin - Launch location
+		@param Velocity - Launch velocity
+		@return Id of the projectile. 0 if it was not launched
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Projectile")
+	int LaunchProjectile(AInventoryItemBase* Item, const FProjectileSpec& Spec, const FVector& Origin, const FVector& Velocity);
+
+	// Number of projectiles in flight
+	UFUNCTION(BlueprintPure, Category = "Projectile")
+	int GetNumProjectiles() const;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile")
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	// Projectiles tracing the world in a step before the traces are spread over worker threads
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "1"))
+	int MinProjectilesForParallelTrace;
+
+	// Largest capsule radius plus half height of any character. Widens the spatial hash query so no capsule is missed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float MaxCharacterExtent;
+
+	// Distance from a local player's camera within which projectiles get their visual actor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float VisualActorDistance;
+
+	// Bounces slower than this on ground that faces up leave the projectile resting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile", meta = (ClampMin = "0.0"))
+	float RestingSpeed;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	// Moves every projectile by DeltaTime. Hot data only, four at a time
+	void Integrate(float DeltaTime);
+
+	// Finds the first character capsule the projectile's step passes through. Null if none
+	AActor* SweepCharacters(int32 ProjectileIndex, const FVector& Start, const FVector& End) const;
+
+	// Applies the projectile's damage, tells its item and removes it
+	void Detonate(int32 ProjectileIndex, AActor* HitActor);
+
+	// Removes the projectile, moving the last one into its place in every array
+	void RemoveProjectile(int32 ProjectileIndex);
+
+	// Spawns visual actors for projectiles near a local camera, drops them for projectiles far from all of them, and moves the rest
+	void UpdateVisualActors();
+
+	bool bIsInitialized;
+
+	int32 NextProjectileId;
+
+	// Hot data, integrated every step
+	TArray<float> PositionsX;
+	TArray<float> PositionsY;
+	TArray<float> PositionsZ;
+	TArray<float> VelocitiesX;
+	TArray<float> VelocitiesY;
+	TArray<float> VelocitiesZ;
+	TArray<float> GravitiesZ;
+	TArray<float> TimesLeft;
+
+	// Cold data, only read on hits, detonation and visual updates
+	TArray<FProjectileSpec> Specs;
+	TArray<TWeakObjectPtr<AInventoryItemBase>> Items;
+	TArray<int32> ProjectileIds;
+
+	// Visual actor of each projectile. Null while it has none
+	UPROPERTY()
+	TArray<AActor*> VisualActors;
+
+	// Step start positions and world trace results, kept between steps so they do not allocate
+	TArray<FVector> StepStarts;
+	TArray<int32> WorldTraceSlots;
+	TArray<int32> WorldTraceIndices;
+	TArray<const AActor*> WorldTraceOwners;
+	TArray<FHitResult> WorldHits;
+	TArray<bool> WorldHitFlags;
+
+	// Characters found by SweepCharacters' spatial hash query, reused by every sweep
+	mutable TArray<AGameCharacterBase*> NearbyCharacters;
+};
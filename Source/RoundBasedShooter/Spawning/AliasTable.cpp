@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AliasTable.h"
+
+void FAliasTable::Build(const TArray<float>& Weights)
+{
+	Probabilities.Reset();
+	Aliases.Reset();
+
+	float TotalWeight = 0.0f;
+	for (float Weight : Weights)
+	{
+		TotalWeight += FMath::Max(Weight, 0.0f);
+	}
+
+	if (TotalWeight <= 0.0f)
+	{
+		return;
+	}
+
+	const int32 NumColumns = Weights.Num();
+	Probabilities.SetNumUninitialized(NumColumns);
+	Aliases.SetNumUninitialized(NumColumns);
+
+	// Scale weights so the average column holds exactly 1, then split into under and over full columns
+	TArray<float> ScaledWeights;
+	TArray<int32> SmallColumns;
+	TArray<int32> LargeColumns;
+	ScaledWeights.SetNumUninitialized(NumColumns);
+
+	for (int32 Column = 0; Column < NumColumns; Column++)
+	{
+		ScaledWeights[Column] = FMath::Max(Weights[Column], 0.0f) * NumColumns / TotalWeight;
+		Aliases[Column] = Column;
+
+		if (ScaledWeights[Column] < 1.0f)
+		{
+			SmallColumns.Add(Column);
+		}
+		else
+		{
+			LargeColumns.Add(Column);
+		}
+	}
+
+	// Top up each under full column from an over full one
+	while (SmallColumns.Num() > 0 && LargeColumns.Num() > 0)
+	{
+		const int32 SmallColumn = SmallColumns.Pop(false);
+		const int32 LargeColumn = LargeColumns.Last();
+
+		Probabilities[SmallColumn] = ScaledWeights[SmallColumn];
+		Aliases[SmallColumn] = LargeColumn;
+
+		ScaledWeights[LargeColumn] -= 1.0f - ScaledWeights[SmallColumn];
+		if (ScaledWeights[LargeColumn] < 1.0f)
+		{
+			LargeColumns.Pop(false);
+			SmallColumns.Add(LargeColumn);
+		}
+	}
+
+	// Whatever is left is full to within float error
+	for (int32 Column : LargeColumns)
+	{
+		Probabilities[Column] = 1.0f;
+	}
+
+	for (int32 Column : SmallColumns)
+	{
+		Probabilities[Column] = 1.0f;
+	}
+}
+
+int32 FAliasTable::Sample(const FRandomStream& RandomStream) const
+{
+	return SampleFromUniform(RandomStream.FRand());
+}
+
+int32 FAliasTable::Sample() const
+{
+	return SampleFromUniform(FMath::FRand());
+}
+
+bool FAliasTable::IsEmpty() const
+{
+	return Probabilities.Num() == 0;
+}
+
+int32 FAliasTable::SampleFromUniform(float UniformValue) const
+{
+	const int32 NumColumns = Probabilities.Num();
+	if (NumColumns == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	// One random number picks the column with its whole part and decides column or alias with its fraction
+	const float ScaledValue = UniformValue * NumColumns;
+	const int32 Column = FMath::Min(FMath::FloorToInt(ScaledValue), NumColumns - 1);
+	const float Fraction = ScaledValue - Column;
+
+	return Fraction < Probabilities[Column] ? Column : Aliases[Column];
+}
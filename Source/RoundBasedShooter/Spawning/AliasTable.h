@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+	Walker/Vose alias table for picking an index with probability proportional to its weight.
+	Building is O(N), sampling is O(1) with one random number and no branching on the weights.
+*/
+class ROUNDBASEDSHOOTER_API FAliasTable
+{
+public:
+
+	// Builds the table. Negative weights count as zero. If every weight is zero the table is empty
+	void Build(const TArray<float>& Weights);
+
+	// Picks a weighted random index. Returns INDEX_NONE if the table is empty
+	int32 Sample(const FRandomStream& RandomStream) const;
+
+	// Same as Sample, using the global random number generator
+	int32 Sample() const;
+
+	bool IsEmpty() const;
+
+private:
+
+	// Picks an index from a uniform random number in [0, 1)
+	int32 SampleFromUniform(float UniformValue) const;
+
+	// Chance of keeping each column's own index rather than taking its alias
+	TArray<float> Probabilities;
+
+	// Index each column falls back to
+	TArray<int32> Aliases;
+};
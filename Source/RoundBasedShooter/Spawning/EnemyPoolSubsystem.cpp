@@ -0,0 +1,352 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPoolSubsystem.h"
+
+#include "EnemyRegistrySubsystem.h"
+#include "../Characters/GameCharacterBase.h"
+#include "../Characters/CharacterSpatialHashSubsystem.h"
+
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "TimerManager.h"
+
+UEnemyPoolSubsystem::UEnemyPoolSubsystem()
+{
+	MaxPooledPerClass = 32;
+}
+
+void UEnemyPoolSubsystem::SetMaxPooledPerClass(int32 NewMaxPooledPerClass)
+{
+	MaxPooledPerClass = FMath::Max(NewMaxPooledPerClass, 0);
+}
+
+AActor* UEnemyPoolSubsystem::AcquireEnemy(UClass* EnemyClass, const FTransform& SpawnTransform, const FActorSpawnParameters& SpawnParams)
+{
+	if (!EnemyClass)
+	{
+		return nullptr;
+	}
+
+	FEnemyPoolBucket* PoolBucket = PoolBuckets.Find(EnemyClass);
+	if (PoolBucket)
+	{
+		// Pooled enemies can still be destroyed from outside, e.g. by a level change, so skip any that are gone
+		while (PoolBucket->InactiveEnemies.Num() > 0)
+		{
+			AActor* PooledEnemy = PoolBucket->InactiveEnemies.Last();
+			if (!IsValid(PooledEnemy))
+			{
+				PoolBucket->InactiveEnemies.Pop(false);
+				PooledEnemies.Remove(PooledEnemy);
+				DestroyPooledEnemy(PooledEnemy);
+				PoolStats.NumPooled--;
+				continue;
+			}
+
+			// A new spawn would fail at the same spot, so leave the enemy pooled and fail too
+			if (!ActivateEnemy(PooledEnemy, SpawnTransform, SpawnParams.SpawnCollisionHandlingOverride))
+			{
+				return nullptr;
+			}
+
+			PoolBucket->InactiveEnemies.Pop(false);
+			PooledEnemies.Remove(PooledEnemy);
+			PoolStats.NumPooled--;
+			PoolStats.Hits++;
+			return PooledEnemy;
+		}
+	}
+
+	PoolStats.Misses++;
+	return GetWorld()->SpawnActor<AActor>(EnemyClass, SpawnTransform, SpawnParams);
+}
+
+EEnemyReleaseResult UEnemyPoolSubsystem::ReleaseEnemy(AActor* Enemy)
+{
+	if (!IsValid(Enemy) || IsEnemyPooled(Enemy))
+	{
+		return EEnemyReleaseResult::Ignored;
+	}
+
+	// Pooled enemies no longer count as live enemies
+	UEnemyRegistrySubsystem* EnemyRegistry = GetWorld()->GetSubsystem<UEnemyRegistrySubsystem>();
+	if (EnemyRegistry)
+	{
+		EnemyRegistry->UnregisterEnemy(Enemy);
+	}
+
+	FEnemyPoolBucket& PoolBucket = PoolBuckets.FindOrAdd(Enemy->GetClass());
+	if (PoolBucket.InactiveEnemies.Num() >= MaxPooledPerClass)
+	{
+		PoolStats.CapacityRejections++;
+		Enemy->Destroy();
+		return EEnemyReleaseResult::Destroyed;
+	}
+
+	DeactivateEnemy(Enemy);
+	PoolBucket.InactiveEnemies.Add(Enemy);
+	PooledEnemies.Add(Enemy);
+	PoolStats.NumPooled++;
+
+	return EEnemyReleaseResult::Pooled;
+}
+
+bool UEnemyPoolSubsystem::IsEnemyPooled(const AActor* Enemy) const
+{
+	return PooledEnemies.Contains(Enemy);
+}
+
+bool UEnemyPoolSubsystem::PrewarmEnemy(UClass* EnemyClass, int32 TargetCount, const FTransform& SpawnTransform)
+{
+	if (!EnemyClass || GetNumPooled(EnemyClass) >= FMath::Min(TargetCount, MaxPooledPerClass))
+	{
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* SpawnedEnemy = GetWorld()->SpawnActor<AActor>(EnemyClass, SpawnTransform, SpawnParams);
+	if (!SpawnedEnemy)
+	{
+		return false;
+	}
+
+	DeactivateEnemy(SpawnedEnemy);
+	PoolBuckets.FindOrAdd(EnemyClass).InactiveEnemies.Add(SpawnedEnemy);
+	PooledEnemies.Add(SpawnedEnemy);
+	PoolStats.NumPooled++;
+
+	return true;
+}
+
+int32 UEnemyPoolSubsystem::GetNumPooled(UClass* EnemyClass) const
+{
+	const FEnemyPoolBucket* PoolBucket = PoolBuckets.Find(EnemyClass);
+	return PoolBucket ? PoolBucket->InactiveEnemies.Num() : 0;
+}
+
+FEnemyPoolStats UEnemyPoolSubsystem::GetPoolStats() const
+{
+	return PoolStats;
+}
+
+void UEnemyPoolSubsystem::EmptyPool()
+{
+	for (TPair<UClass*, FEnemyPoolBucket>& PoolBucket : PoolBuckets)
+	{
+		for (AActor* PooledEnemy : PoolBucket.Value.InactiveEnemies)
+		{
+			DestroyPooledEnemy(PooledEnemy);
+		}
+	}
+
+	PoolBuckets.Empty();
+	PooledEnemies.Empty();
+	PooledControllers.Empty();
+	PoolStats.NumPooled = 0;
+}
+
+void UEnemyPoolSubsystem::EmptyPoolForClass(UClass* EnemyClass)
+{
+	FEnemyPoolBucket PoolBucket;
+	if (!PoolBuckets.RemoveAndCopyValue(EnemyClass, PoolBucket))
+	{
+		return;
+	}
+
+	for (AActor* PooledEnemy : PoolBucket.InactiveEnemies)
+	{
+		PooledEnemies.Remove(PooledEnemy);
+		DestroyPooledEnemy(PooledEnemy);
+	}
+
+	PoolStats.NumPooled -= PoolBucket.InactiveEnemies.Num();
+}
+
+void UEnemyPoolSubsystem::DeactivateEnemy(AActor* Enemy)
+{
+	Enemy->SetActorHiddenInGame(true);
+	Enemy->SetActorEnableCollision(false);
+	Enemy->SetActorTickEnabled(false);
+	Enemy->GetWorldTimerManager().ClearAllTimersForObject(Enemy);
+
+	TInlineComponentArray<UActorComponent*> Components(Enemy);
+	for (UActorComponent* Component : Components)
+	{
+		Component->SetComponentTickEnabled(false);
+	}
+
+	// AI controllers keep running their logic on an inactive pawn, so stop it and keep the controller for reuse instead of destroying it
+	APawn* EnemyPawn = Cast<APawn>(Enemy);
+	AController* EnemyController = EnemyPawn ? EnemyPawn->Controller : nullptr;
+	if (EnemyController && !EnemyPawn->IsPlayerControlled())
+	{
+		AAIController* AIController = Cast<AAIController>(EnemyController);
+		if (AIController)
+		{
+			AIController->StopMovement();
+			AIController->ClearFocus(EAIFocusPriority::Gameplay);
+
+			if (AIController->GetBrainComponent())
+			{
+				AIController->GetBrainComponent()->StopLogic(TEXT("Pooled"));
+			}
+		}
+
+		EnemyController->UnPossess();
+		EnemyController->SetActorTickEnabled(false);
+
+		TInlineComponentArray<UActorComponent*> ControllerComponents(EnemyController);
+		for (UActorComponent* Component : ControllerComponents)
+		{
+			Component->SetComponentTickEnabled(false);
+		}
+
+		PooledControllers.Add(Enemy, EnemyController);
+	}
+
+	ACharacter* EnemyCharacter = Cast<ACharacter>(Enemy);
+	if (EnemyCharacter && EnemyCharacter->GetCharacterMovement())
+	{
+		EnemyCharacter->GetCharacterMovement()->StopMovementImmediately();
+	}
+
+	AGameCharacterBase* GameCharacter = Cast<AGameCharacterBase>(Enemy);
+	if (GameCharacter)
+	{
+		GameCharacter->SetIsAlive(GameCharacter->GetClass()->GetDefaultObject<AGameCharacterBase>()->bIsAlive);
+		GameCharacter->OnPoolDeactivated();
+
+		// Pooled enemies are hidden away and should not turn up in proximity queries
+		UCharacterSpatialHashSubsystem* SpatialHash = Enemy->GetWorld()->GetSubsystem<UCharacterSpatialHashSubsystem>();
+		if (SpatialHash)
+		{
+			SpatialHash->RemoveCharacter(GameCharacter);
+		}
+	}
+}
+
+bool UEnemyPoolSubsystem::ActivateEnemy(AActor* Enemy, const FTransform& SpawnTransform, ESpawnActorCollisionHandlingMethod CollisionHandling)
+{
+	if (CollisionHandling == ESpawnActorCollisionHandlingMethod::Undefined)
+	{
+		CollisionHandling = Enemy->SpawnCollisionHandlingMethod;
+	}
+
+	// Check for encroachment the way SpawnActor does, so reused enemies do not end up inside each other or in geometry. Collision has to be on for the check
+	Enemy->SetActorEnableCollision(true);
+
+	FVector SpawnLocation = SpawnTransform.GetLocation();
+	const FRotator SpawnRotation = SpawnTransform.Rotator();
+	UWorld* World = Enemy->GetWorld();
+
+	bool bCanPlace = true;
+	switch (CollisionHandling)
+	{
+	case ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn:
+		World->FindTeleportSpot(Enemy, SpawnLocation, SpawnRotation);
+		break;
+	case ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding:
+		bCanPlace = World->FindTeleportSpot(Enemy, SpawnLocation, SpawnRotation);
+		break;
+	case ESpawnActorCollisionHandlingMethod::DontSpawnIfColliding:
+		bCanPlace = !World->EncroachingBlockingGeometry(Enemy, SpawnLocation, SpawnRotation);
+		break;
+	default:
+		break;
+	}
+
+	if (!bCanPlace)
+	{
+		Enemy->SetActorEnableCollision(false);
+		return false;
+	}
+
+	Enemy->SetActorTransform(FTransform(SpawnRotation, SpawnLocation, SpawnTransform.GetScale3D()), false, nullptr, ETeleportType::ResetPhysics);
+	Enemy->SetActorHiddenInGame(false);
+	Enemy->SetActorTickEnabled(Enemy->PrimaryActorTick.bStartWithTickEnabled);
+
+	TInlineComponentArray<UActorComponent*> Components(Enemy);
+	for (UActorComponent* Component : Components)
+	{
+		if (Component->PrimaryComponentTick.bStartWithTickEnabled)
+		{
+			Component->SetComponentTickEnabled(true);
+		}
+	}
+
+	// Hand the enemy back to the controller it had before it was pooled and restart its logic. Only enemies without one get a new controller
+	APawn* EnemyPawn = Cast<APawn>(Enemy);
+	AController* PooledController = nullptr;
+	PooledControllers.RemoveAndCopyValue(Enemy, PooledController);
+
+	if (EnemyPawn && !EnemyPawn->Controller && IsValid(PooledController))
+	{
+		PooledController->SetActorTickEnabled(PooledController->PrimaryActorTick.bStartWithTickEnabled);
+
+		TInlineComponentArray<UActorComponent*> ControllerComponents(PooledController);
+		for (UActorComponent* Component : ControllerComponents)
+		{
+			if (Component->PrimaryComponentTick.bStartWithTickEnabled)
+			{
+				Component->SetComponentTickEnabled(true);
+			}
+		}
+
+		PooledController->Possess(EnemyPawn);
+
+		// Controllers that start their logic in OnPossess are already running again
+		AAIController* AIController = Cast<AAIController>(PooledController);
+		if (AIController && AIController->GetBrainComponent() && !AIController->GetBrainComponent()->IsRunning())
+		{
+			AIController->GetBrainComponent()->RestartLogic();
+		}
+	}
+	else if (IsValid(PooledController))
+	{
+		PooledController->Destroy();
+	}
+
+	if (EnemyPawn && !EnemyPawn->Controller)
+	{
+		EnemyPawn->SpawnDefaultController();
+	}
+
+	ACharacter* EnemyCharacter = Cast<ACharacter>(Enemy);
+	if (EnemyCharacter && EnemyCharacter->GetCharacterMovement())
+	{
+		EnemyCharacter->GetCharacterMovement()->SetDefaultMovementMode();
+	}
+
+	AGameCharacterBase* GameCharacter = Cast<AGameCharacterBase>(Enemy);
+	if (GameCharacter)
+	{
+		UCharacterSpatialHashSubsystem* SpatialHash = Enemy->GetWorld()->GetSubsystem<UCharacterSpatialHashSubsystem>();
+		if (SpatialHash)
+		{
+			SpatialHash->AddCharacter(GameCharacter);
+		}
+
+		GameCharacter->OnPoolActivated();
+	}
+
+	return true;
+}
+
+void UEnemyPoolSubsystem::DestroyPooledEnemy(AActor* Enemy)
+{
+	AController* PooledController = nullptr;
+	if (PooledControllers.RemoveAndCopyValue(Enemy, PooledController) && IsValid(PooledController))
+	{
+		PooledController->Destroy();
+	}
+
+	if (IsValid(Enemy))
+	{
+		Enemy->Destroy();
+	}
+}
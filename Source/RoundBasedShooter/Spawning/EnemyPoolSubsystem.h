@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyPoolSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FEnemyPoolStats
+{
+	GENERATED_BODY()
+
+public:
+
+	// Number of enemies that were reused from the pool
+	UPROPERTY(BlueprintReadOnly, Category = "Pooling")
+	int Hits;
+
+	// Number of enemies that had to be spawned because the pool had none of the class
+	UPROPERTY(BlueprintReadOnly, Category = "Pooling")
+	int Misses;
+
+	// Number of enemies that were destroyed on release because their pool was full
+	UPROPERTY(BlueprintReadOnly, Category = "Pooling")
+	int CapacityRejections;
+
+	// Number of inactive enemies currently waiting in the pool, across all classes
+	UPROPERTY(BlueprintReadOnly, Category = "Pooling")
+	int NumPooled;
+
+	FEnemyPoolStats()
+	{
+		Hits = 0;
+		Misses = 0;
+		CapacityRejections = 0;
+		NumPooled = 0;
+	}
+};
+
+// What happened to an enemy handed to UEnemyPoolSubsystem::ReleaseEnemy
+enum class EEnemyReleaseResult : uint8
+{
+	// The enemy was deactivated and is waiting in the pool
+	Pooled,
+
+	// The pool of its class was full, so the enemy was destroyed
+	Destroyed,
+
+	// The enemy was invalid or already pooled and was left as it was
+	Ignored
+};
+
+// Inactive enemies of a single class
+USTRUCT()
+struct FEnemyPoolBucket
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY()
+	TArray<AActor*> InactiveEnemies;
+};
+
+/**
+	Keeps deactivated enemy actors around so they can be reused instead of spawned and garbage collected every round.
+	Pooled enemies are hidden, have collision and ticking turned off and are not registered with the enemy registry or the character spatial hash.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyPoolSubsystem();
+
+	// Max number of inactive enemies kept for each class. Enemies released past this are destroyed
+	void SetMaxPooledPerClass(int32 NewMaxPooledPerClass);
+
+	/**
+		Reuses a pooled enemy of the class if there is one, otherwise spawns a new one.
+		A pooled enemy is placed following the spawn parameters' collision handling like a new spawn would be. Returns null if it can not be placed.
+	*/
+	AActor* AcquireEnemy(UClass* EnemyClass, const FTransform& SpawnTransform, const FActorSpawnParameters& SpawnParams);
+
+	/**
+		Deactivates the enemy and adds it to the pool of its class.
+		Destroys it instead if the pool is full, and leaves it alone if it is invalid or already in the pool.
+	*/
+	EEnemyReleaseResult ReleaseEnemy(AActor* Enemy);
+
+	// Whether the enemy is currently waiting in the pool
+	bool IsEnemyPooled(const AActor* Enemy) const;
+
+	/**
+		Spawns a single inactive enemy of the class into the pool if the pool holds fewer than TargetCount.
+		Returns true if an enemy was spawned.
+	*/
+	bool PrewarmEnemy(UClass* EnemyClass, int32 TargetCount, const FTransform& SpawnTransform);
+
+	// Number of inactive enemies of the class in the pool
+	int32 GetNumPooled(UClass* EnemyClass) const;
+
+	// Hit, miss and capacity counters for the pool
+	UFUNCTION(BlueprintPure, Category = "Pooling")
+	FEnemyPoolStats GetPoolStats() const;
+
+	// Destroys every pooled enemy
+	void EmptyPool();
+
+	// Destroys every pooled enemy of the class
+	void EmptyPoolForClass(UClass* EnemyClass);
+
+private:
+
+	// Hides the enemy, turns off its collision and ticking, pauses its AI controller and resets its alive state
+	void DeactivateEnemy(AActor* Enemy);
+
+	// Moves the enemy to the spawn transform and turns it back on. Returns false, leaving the enemy inactive, if the spawn collision handling does not allow placing it there
+	bool ActivateEnemy(AActor* Enemy, const FTransform& SpawnTransform, ESpawnActorCollisionHandlingMethod CollisionHandling);
+
+	// Destroys a pooled enemy and the AI controller kept for it
+	void DestroyPooledEnemy(AActor* Enemy);
+
+	UPROPERTY()
+	TMap<UClass*, FEnemyPoolBucket> PoolBuckets;
+
+	// Every enemy in the buckets, so releasing an enemy twice can be caught without searching its bucket
+	TSet<const AActor*> PooledEnemies;
+
+	// Paused AI controllers of pooled enemies. They possess their enemy again on reuse instead of a new controller being spawned
+	UPROPERTY()
+	TMap<AActor*, AController*> PooledControllers;
+
+	FEnemyPoolStats PoolStats;
+
+	int32 MaxPooledPerClass;
+};
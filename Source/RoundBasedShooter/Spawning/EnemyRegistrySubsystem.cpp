@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyRegistrySubsystem.h"
+
+#include "../Characters/GameCharacterBase.h"
+
+UEnemyRegistrySubsystem::UEnemyRegistrySubsystem()
+{
+	NumAliveEnemies = 0;
+}
+
+void UEnemyRegistrySubsystem::RegisterEnemy(AActor* Enemy)
+{
+	if (!IsValid(Enemy) || EnemyIndices.Contains(Enemy))
+	{
+		return;
+	}
+
+	const bool bIsAlive = IsEnemyAlive(Enemy);
+
+	EnemyIndices.Add(Enemy, Enemies.Add(Enemy));
+	EnemyAliveStates.Add(bIsAlive);
+
+	if (bIsAlive)
+	{
+		NumAliveEnemies++;
+	}
+
+	Enemy->OnDestroyed.AddDynamic(this, &UEnemyRegistrySubsystem::OnEnemyDestroyed);
+}
+
+void UEnemyRegistrySubsystem::UnregisterEnemy(AActor* Enemy)
+{
+	int32 EnemyIndex = INDEX_NONE;
+	if (!EnemyIndices.RemoveAndCopyValue(Enemy, EnemyIndex))
+	{
+		return;
+	}
+
+	if (EnemyAliveStates[EnemyIndex])
+	{
+		NumAliveEnemies--;
+	}
+
+	// Swap the last enemy into the removed slot and fix up its index
+	Enemies.RemoveAtSwap(EnemyIndex, 1, false);
+	EnemyAliveStates.RemoveAtSwap(EnemyIndex, 1, false);
+
+	if (Enemies.IsValidIndex(EnemyIndex))
+	{
+		EnemyIndices.Add(Enemies[EnemyIndex], EnemyIndex);
+	}
+
+	if (IsValid(Enemy))
+	{
+		Enemy->OnDestroyed.RemoveDynamic(this, &UEnemyRegistrySubsystem::OnEnemyDestroyed);
+	}
+}
+
+void UEnemyRegistrySubsystem::NotifyAliveStateChanged(AGameCharacterBase* GameCharacter)
+{
+	const int32* EnemyIndex = EnemyIndices.Find(GameCharacter);
+	if (!EnemyIndex)
+	{
+		return;
+	}
+
+	const bool bIsAlive = IsEnemyAlive(GameCharacter);
+	if (EnemyAliveStates[*EnemyIndex] != bIsAlive)
+	{
+		EnemyAliveStates[*EnemyIndex] = bIsAlive;
+		NumAliveEnemies += bIsAlive ? 1 : -1;
+	}
+}
+
+bool UEnemyRegistrySubsystem::IsEnemyRegistered(const AActor* Enemy) const
+{
+	return EnemyIndices.Contains(Enemy);
+}
+
+int UEnemyRegistrySubsystem::GetNumLiveEnemies() const
+{
+	return Enemies.Num();
+}
+
+int UEnemyRegistrySubsystem::GetNumAliveEnemies() const
+{
+	return NumAliveEnemies;
+}
+
+const TArray<AActor*>& UEnemyRegistrySubsystem::GetEnemies() const
+{
+	return Enemies;
+}
+
+void UEnemyRegistrySubsystem::OnEnemyDestroyed(AActor* DestroyedActor)
+{
+	UnregisterEnemy(DestroyedActor);
+}
+
+bool UEnemyRegistrySubsystem::IsEnemyAlive(const AActor* Enemy)
+{
+	// Only game characters have an alive state. Matches the old GetNumRemainingEnemies behaviour
+	const AGameCharacterBase* GameCharacter = Cast<AGameCharacterBase>(Enemy);
+	return IsValid(GameCharacter) && GameCharacter->bIsAlive;
+}
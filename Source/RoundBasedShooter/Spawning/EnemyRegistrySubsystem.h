@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyRegistrySubsystem.generated.h"
+
+class AGameCharacterBase;
+
+/**
+	Keeps track of every enemy spawned by the spawn manager so that enemy queries do not need to scan the world.
+	Enemies are added when they spawn and removed when they are destroyed. Live and alive counts are kept up to date
+	as enemies are added, removed or change their alive state, so the count queries are O(1).
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UEnemyRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyRegistrySubsystem();
+
+	// Adds the enemy to the registry. Does nothing if the enemy is already registered
+	void RegisterEnemy(AActor* Enemy);
+
+	// Removes the enemy from the registry. Does nothing if the enemy is not registered
+	void UnregisterEnemy(AActor* Enemy);
+
+	// Called by AGameCharacterBase when its alive state changes so the alive count stays correct
+	void NotifyAliveStateChanged(AGameCharacterBase* GameCharacter);
+
+	// Returns true if the enemy is in the registry
+	bool IsEnemyRegistered(const AActor* Enemy) const;
+
+	// Number of registered enemy actors. Dead or alive
+	UFUNCTION(BlueprintPure, Category = "Enemies")
+	int GetNumLiveEnemies() const;
+
+	// Number of registered enemy characters that are still alive
+	UFUNCTION(BlueprintPure, Category = "Enemies")
+	int GetNumAliveEnemies() const;
+
+	// All registered enemy actors. Dead or alive. The order is not stable between calls
+	const TArray<AActor*>& GetEnemies() const;
+
+private:
+
+	// Bound to OnDestroyed of every registered enemy
+	UFUNCTION()
+	void OnEnemyDestroyed(AActor* DestroyedActor);
+
+	// Returns if the actor counts towards the alive count
+	static bool IsEnemyAlive(const AActor* Enemy);
+
+	UPROPERTY()
+	TArray<AActor*> Enemies;
+
+	// Alive state of each enemy at the same index in Enemies, as last seen by the registry
+	TArray<bool> EnemyAliveStates;
+
+	// Maps enemy to its index in Enemies so removal does not need a search
+	TMap<const AActor*, int32> EnemyIndices;
+
+	int32 NumAliveEnemies;
+};
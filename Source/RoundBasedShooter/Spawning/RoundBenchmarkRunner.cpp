@@ -0,0 +1,351 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RoundBenchmarkRunner.h"
+
+#include "SpawnManager.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+ARoundBenchmarkRunner::ARoundBenchmarkRunner()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	SpawnManager = nullptr;
+	bRunOnBeginPlay = false;
+	NumRounds = 10;
+	SpawnMultiplierOverride = 0;
+	RoundDuration = 3.0f;
+	CooldownDuration = 2.0f;
+	ClassStreamingTimeout = 30.0f;
+	bFlushCleanup = false;
+	bForceGarbageCollectionEachRound = false;
+	bQuitWhenFinished = false;
+	Phase = EBenchmarkPhase::Idle;
+	PhaseTime = 0.0f;
+	CleanupStartTime = 0.0;
+	GarbageCollectStartTime = 0.0;
+	OriginalSpawnMultiplier = 0;
+}
+
+void ARoundBenchmarkRunner::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &ARoundBenchmarkRunner::OnPreGarbageCollect);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ARoundBenchmarkRunner::OnPostGarbageCollect);
+
+	const bool bStartedFromCommandLine = FParse::Param(FCommandLine::Get(), TEXT("RoundBenchmark"));
+	FParse::Value(FCommandLine::Get(), TEXT("RoundBenchmarkRounds="), NumRounds);
+	FParse::Value(FCommandLine::Get(), TEXT("RoundBenchmarkMultiplier="), SpawnMultiplierOverride);
+
+	if (bStartedFromCommandLine)
+	{
+		bQuitWhenFinished = true;
+	}
+
+	if (bStartedFromCommandLine || bRunOnBeginPlay)
+	{
+		StartBenchmark();
+	}
+}
+
+void ARoundBenchmarkRunner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+
+	if (SpawnManager && Phase != EBenchmarkPhase::Idle)
+	{
+		SpawnManager->SpawnMultiplier = OriginalSpawnMultiplier;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ARoundBenchmarkRunner::StartBenchmark()
+{
+	if (Phase != EBenchmarkPhase::Idle)
+	{
+		return;
+	}
+
+	if (!SpawnManager)
+	{
+		SpawnManager = Cast<ASpawnManager>(UGameplayStatics::GetActorOfClass(GetWorld(), ASpawnManager::StaticClass()));
+	}
+
+	if (!SpawnManager)
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "StartBenchmark: There is no spawn manager in the level!");
+		return;
+	}
+
+	OriginalSpawnMultiplier = SpawnManager->SpawnMultiplier;
+	if (SpawnMultiplierOverride > 0)
+	{
+		SpawnManager->SpawnMultiplier = SpawnMultiplierOverride;
+	}
+
+	Results.Reset();
+
+	BeginNextRound();
+}
+
+bool ARoundBenchmarkRunner::IsBenchmarkRunning() const
+{
+	return Phase != EBenchmarkPhase::Idle;
+}
+
+const TArray<FRoundBenchmarkResult>& ARoundBenchmarkRunner::GetResults() const
+{
+	return Results;
+}
+
+void ARoundBenchmarkRunner::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Phase == EBenchmarkPhase::Idle || !SpawnManager)
+	{
+		return;
+	}
+
+	FrameTimesMs.Add(DeltaTime * 1000.0f);
+	PhaseTime += DeltaTime;
+
+	switch (Phase)
+	{
+	case EBenchmarkPhase::WaitingForClasses:
+		if (SpawnManager->AreRoundEnemyClassesResident(SpawnManager->GetCurrentRound()) || PhaseTime >= ClassStreamingTimeout)
+		{
+			SpawnRound();
+		}
+		break;
+
+	case EBenchmarkPhase::InRound:
+		if (PhaseTime >= RoundDuration)
+		{
+			BeginCleanup();
+		}
+		break;
+
+	case EBenchmarkPhase::CleaningUp:
+		// Only frames the cleanup was still running on count, not the one it is first seen finished on
+		if (SpawnManager->IsCleaningUpEnemies())
+		{
+			CurrentResult.CleanupFrames++;
+		}
+		else
+		{
+			if (!bFlushCleanup)
+			{
+				CurrentResult.CleanupMs = (FPlatformTime::Seconds() - CleanupStartTime) * 1000.0;
+			}
+
+			if (bForceGarbageCollectionEachRound)
+			{
+				GEngine->ForceGarbageCollection(true);
+			}
+
+			Phase = EBenchmarkPhase::Cooldown;
+			PhaseTime = 0.0f;
+		}
+		break;
+
+	case EBenchmarkPhase::Cooldown:
+		if (PhaseTime >= CooldownDuration)
+		{
+			FinishRound();
+			BeginNextRound();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ARoundBenchmarkRunner::BeginNextRound()
+{
+	if (Results.Num() >= NumRounds)
+	{
+		FinishBenchmark();
+		return;
+	}
+
+	SpawnManager->IncrementCurrentRound();
+
+	CurrentResult = FRoundBenchmarkResult();
+	CurrentResult.Round = SpawnManager->GetCurrentRound();
+	FrameTimesMs.Reset();
+
+	Phase = EBenchmarkPhase::WaitingForClasses;
+	PhaseTime = 0.0f;
+}
+
+void ARoundBenchmarkRunner::SpawnRound()
+{
+	const int NumToSpawn = SpawnManager->SpawnMultiplier * SpawnManager->GetCurrentRound();
+
+	SpawnManager->CurrentRoundState = ERoundState::InRound;
+	SpawnManager->NumEnemiesSpawned = 0;
+
+	for (int SpawnIndex = 0; SpawnIndex < NumToSpawn; SpawnIndex++)
+	{
+		const double SpawnStartTime = FPlatformTime::Seconds();
+		AActor* SpawnedEnemy = SpawnManager->SpawnEnemy(SpawnManager->ShouldSpawnHardEnemy(SpawnIndex));
+		const float SpawnMs = (FPlatformTime::Seconds() - SpawnStartTime) * 1000.0;
+
+		CurrentResult.SpawnMs += SpawnMs;
+		CurrentResult.MaxSpawnMs = FMath::Max(CurrentResult.MaxSpawnMs, SpawnMs);
+
+		if (SpawnedEnemy)
+		{
+			CurrentResult.NumEnemiesSpawned++;
+			SpawnManager->NumEnemiesSpawned++;
+		}
+	}
+
+	CurrentResult.SpawnMsPerEnemy = CurrentResult.NumEnemiesSpawned > 0 ? CurrentResult.SpawnMs / CurrentResult.NumEnemiesSpawned : 0.0f;
+
+	Phase = EBenchmarkPhase::InRound;
+	PhaseTime = 0.0f;
+}
+
+void ARoundBenchmarkRunner::BeginCleanup()
+{
+	SpawnManager->CurrentRoundState = ERoundState::Cooldown;
+
+	CleanupStartTime = FPlatformTime::Seconds();
+	SpawnManager->CleanupEnemies();
+
+	if (bFlushCleanup)
+	{
+		SpawnManager->FlushEnemyCleanup();
+		CurrentResult.CleanupMs = (FPlatformTime::Seconds() - CleanupStartTime) * 1000.0;
+	}
+
+	Phase = EBenchmarkPhase::CleaningUp;
+	PhaseTime = 0.0f;
+}
+
+void ARoundBenchmarkRunner::FinishRound()
+{
+	FrameTimesMs.Sort();
+
+	const int NumFrames = FrameTimesMs.Num();
+	CurrentResult.NumFrames = NumFrames;
+
+	if (NumFrames > 0)
+	{
+		auto GetPercentile = [this, NumFrames](float Percentile)
+		{
+			return FrameTimesMs[FMath::Clamp(FMath::CeilToInt(Percentile * NumFrames) - 1, 0, NumFrames - 1)];
+		};
+
+		CurrentResult.FrameMsP50 = GetPercentile(0.5f);
+		CurrentResult.FrameMsP90 = GetPercentile(0.9f);
+		CurrentResult.FrameMsP99 = GetPercentile(0.99f);
+		CurrentResult.FrameMsMax = FrameTimesMs.Last();
+	}
+
+	Results.Add(CurrentResult);
+}
+
+void ARoundBenchmarkRunner::FinishBenchmark()
+{
+	Phase = EBenchmarkPhase::Idle;
+	SpawnManager->SpawnMultiplier = OriginalSpawnMultiplier;
+
+	WriteReport();
+	OnBenchmarkFinished();
+
+	if (bQuitWhenFinished)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void ARoundBenchmarkRunner::WriteReport() const
+{
+	const FString ReportDirectory = FPaths::ProjectSavedDir() / TEXT("Benchmarks");
+	const FString ReportName = FString::Printf(TEXT("RoundBenchmark-%s"), *FDateTime::Now().ToString());
+
+	TArray<TSharedPtr<FJsonValue>> JsonRounds;
+	FString Csv = TEXT("Round,NumEnemiesSpawned,SpawnMs,SpawnMsPerEnemy,MaxSpawnMs,CleanupMs,CleanupFrames,NumGarbageCollections,GarbageCollectionMs,MaxGarbageCollectionMs,NumFrames,FrameMsP50,FrameMsP90,FrameMsP99,FrameMsMax\n");
+
+	for (const FRoundBenchmarkResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> JsonRound = MakeShared<FJsonObject>();
+		JsonRound->SetNumberField(TEXT("Round"), Result.Round);
+		JsonRound->SetNumberField(TEXT("NumEnemiesSpawned"), Result.NumEnemiesSpawned);
+		JsonRound->SetNumberField(TEXT("SpawnMs"), Result.SpawnMs);
+		JsonRound->SetNumberField(TEXT("SpawnMsPerEnemy"), Result.SpawnMsPerEnemy);
+		JsonRound->SetNumberField(TEXT("MaxSpawnMs"), Result.MaxSpawnMs);
+		JsonRound->SetNumberField(TEXT("CleanupMs"), Result.CleanupMs);
+		JsonRound->SetNumberField(TEXT("CleanupFrames"), Result.CleanupFrames);
+		JsonRound->SetNumberField(TEXT("NumGarbageCollections"), Result.NumGarbageCollections);
+		JsonRound->SetNumberField(TEXT("GarbageCollectionMs"), Result.GarbageCollectionMs);
+		JsonRound->SetNumberField(TEXT("MaxGarbageCollectionMs"), Result.MaxGarbageCollectionMs);
+		JsonRound->SetNumberField(TEXT("NumFrames"), Result.NumFrames);
+		JsonRound->SetNumberField(TEXT("FrameMsP50"), Result.FrameMsP50);
+		JsonRound->SetNumberField(TEXT("FrameMsP90"), Result.FrameMsP90);
+		JsonRound->SetNumberField(TEXT("FrameMsP99"), Result.FrameMsP99);
+		JsonRound->SetNumberField(TEXT("FrameMsMax"), Result.FrameMsMax);
+		JsonRounds.Add(MakeShared<FJsonValueObject>(JsonRound));
+
+		Csv += FString::Printf(TEXT("%d,%d,%.3f,%.3f,%.3f,%.3f,%d,%d,%.3f,%.3f,%d,%.3f,%.3f,%.3f,%.3f\n"),
+			Result.Round, Result.NumEnemiesSpawned, Result.SpawnMs, Result.SpawnMsPerEnemy, Result.MaxSpawnMs,
+			Result.CleanupMs, Result.CleanupFrames, Result.NumGarbageCollections, Result.GarbageCollectionMs, Result.MaxGarbageCollectionMs,
+			Result.NumFrames, Result.FrameMsP50, Result.FrameMsP90, Result.FrameMsP99, Result.FrameMsMax);
+	}
+
+	TSharedRef<FJsonObject> JsonReport = MakeShared<FJsonObject>();
+	JsonReport->SetStringField(TEXT("Map"), GetWorld()->GetMapName());
+	JsonReport->SetNumberField(TEXT("SpawnMultiplier"), SpawnManager->SpawnMultiplier);
+	JsonReport->SetBoolField(TEXT("FlushCleanup"), bFlushCleanup);
+	JsonReport->SetArrayField(TEXT("Rounds"), JsonRounds);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(JsonReport, JsonWriter);
+
+	const FString JsonPath = ReportDirectory / (ReportName + TEXT(".json"));
+	const FString CsvPath = ReportDirectory / (ReportName + TEXT(".csv"));
+
+	if (!FFileHelper::SaveStringToFile(Json, *JsonPath) || !FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "WriteReport: Could not write the benchmark report!");
+		return;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Round benchmark report written to %s"), *JsonPath);
+}
+
+void ARoundBenchmarkRunner::OnPreGarbageCollect()
+{
+	GarbageCollectStartTime = FPlatformTime::Seconds();
+}
+
+void ARoundBenchmarkRunner::OnPostGarbageCollect()
+{
+	if (Phase == EBenchmarkPhase::Idle)
+	{
+		return;
+	}
+
+	const float GarbageCollectionMs = (FPlatformTime::Seconds() - GarbageCollectStartTime) * 1000.0;
+
+	CurrentResult.NumGarbageCollections++;
+	CurrentResult.GarbageCollectionMs += GarbageCollectionMs;
+	CurrentResult.MaxGarbageCollectionMs = FMath::Max(CurrentResult.MaxGarbageCollectionMs, GarbageCollectionMs);
+}
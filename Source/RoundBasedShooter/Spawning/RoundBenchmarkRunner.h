@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "RoundBenchmarkRunner.generated.h"
+
+class ASpawnManager;
+
+// Measurements for a single benchmarked round
+USTRUCT(BlueprintType)
+struct FRoundBenchmarkResult
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	int Round;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	int NumEnemiesSpawned;
+
+	// Time spent in SpawnEnemy for the whole round
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float SpawnMs;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float SpawnMsPerEnemy;
+
+	// Slowest single SpawnEnemy call
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float MaxSpawnMs;
+
+	// Time spent cleaning up. Measured directly when the cleanup is flushed, otherwise the wall time until the cleanup queue emptied
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float CleanupMs;
+
+	// Number of frames the cleanup queue took to empty
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	int CleanupFrames;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	int NumGarbageCollections;
+
+	// Total time spent in garbage collection during the round
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float GarbageCollectionMs;
+
+	// Longest single garbage collection pause during the round
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float MaxGarbageCollectionMs;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	int NumFrames;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float FrameMsP50;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float FrameMsP90;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float FrameMsP99;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Benchmark")
+	float FrameMsMax;
+
+	FRoundBenchmarkResult()
+	{
+		Round = 0;
+		NumEnemiesSpawned = 0;
+		SpawnMs = 0.0f;
+		SpawnMsPerEnemy = 0.0f;
+		MaxSpawnMs = 0.0f;
+		CleanupMs = 0.0f;
+		CleanupFrames = 0;
+		NumGarbageCollections = 0;
+		GarbageCollectionMs = 0.0f;
+		MaxGarbageCollectionMs = 0.0f;
+		NumFrames = 0;
+		FrameMsP50 = 0.0f;
+		FrameMsP90 = 0.0f;
+		FrameMsP99 = 0.0f;
+		FrameMsMax = 0.0f;
+	}
+};
+
+/**
+	Drives the level's spawn manager through a number of rounds and records what every round transition costs: frame time
+	percentiles, spawn cost per enemy, cleanup cost and garbage collection pauses. Writes a JSON and a CSV report to
+	Saved/Benchmarks when it finishes.
+
+	Place one in a test arena whose game mode does not run rounds itself, then run headless with
+	-game -nullrhi -unattended -RoundBenchmark [-RoundBenchmarkRounds=N] [-RoundBenchmarkMultiplier=N]
+	The game quits once the report is written when started from the command line.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API ARoundBenchmarkRunner : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	ARoundBenchmarkRunner();
+
+	virtual void Tick(float DeltaTime) override;
+
+	// Starts benchmarking from the spawn manager's current round
+	UFUNCTION(BlueprintCallable, Category = "Benchmark")
+	void StartBenchmark();
+
+	UFUNCTION(BlueprintPure, Category = "Benchmark")
+	bool IsBenchmarkRunning() const;
+
+	// Results of every round benchmarked so far
+	UFUNCTION(BlueprintPure, Category = "Benchmark")
+	const TArray<FRoundBenchmarkResult>& GetResults() const;
+
+	// Called once every round has been benchmarked and the report has been written
+	UFUNCTION(BlueprintImplementableEvent, Category = "Benchmark")
+	void OnBenchmarkFinished();
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// The spawn manager to drive. The first one in the level is used if this is not set
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	ASpawnManager* SpawnManager;
+
+	// Start the benchmark on begin play even without -RoundBenchmark on the command line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	bool bRunOnBeginPlay;
+
+	// Number of rounds to benchmark. Overridden by -RoundBenchmarkRounds=
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark", meta = (ClampMin = "1"))
+	int NumRounds;
+
+	// Replaces the spawn manager's SpawnMultiplier while benchmarking. 0 keeps it. Overridden by -RoundBenchmarkMultiplier=
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark", meta = (ClampMin = "0"))
+	int SpawnMultiplierOverride;
+
+	// Seconds to keep each round's enemies alive before cleaning them up
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float RoundDuration;
+
+	// Seconds to wait after a cleanup has finished before starting the next round
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float CooldownDuration;
+
+	// Seconds to wait for a round's enemy classes to stream in before spawning anyway, which loads them on the spot
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float ClassStreamingTimeout;
+
+	// Finish each cleanup in the frame it starts instead of letting the cleanup queue spread it out. Measures the full cleanup cost
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	bool bFlushCleanup;
+
+	// Run a full garbage collection at the start of every cooldown so its pause is measured every round
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	bool bForceGarbageCollectionEachRound;
+
+	// Quit the game once the report is written. Always on when started from the command line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	bool bQuitWhenFinished;
+
+private:
+
+	enum class EBenchmarkPhase : uint8
+	{
+		Idle,
+		WaitingForClasses,
+		InRound,
+		CleaningUp,
+		Cooldown
+	};
+
+	// Moves on to the next round, or finishes the benchmark after the last one
+	void BeginNextRound();
+
+	// Spawns the whole round quota in one frame, timing every spawn
+	void SpawnRound();
+
+	// Starts cleaning up the round's enemies
+	void BeginCleanup();
+
+	// Works out the frame time percentiles of the round and adds it to the results
+	void FinishRound();
+
+	// Writes the JSON and CSV reports and quits if asked to
+	void FinishBenchmark();
+
+	void WriteReport() const;
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	EBenchmarkPhase Phase;
+
+	// Seconds spent in the current phase
+	float PhaseTime;
+
+	FRoundBenchmarkResult CurrentResult;
+
+	// Frame times of the current round in milliseconds
+	TArray<float> FrameTimesMs;
+
+	TArray<FRoundBenchmarkResult> Results;
+
+	double CleanupStartTime;
+
+	double GarbageCollectStartTime;
+
+	// Spawn multiplier of the spawn manager before the override was applied
+	int OriginalSpawnMultiplier;
+
+	FDelegateHandle PreGarbageCollectHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// A single enemy spawn in a round spawn plan
+struct FPlannedSpawn
+{
+	// Seconds after the round started spawning that this enemy is due
+	float SpawnTime;
+
+	// Index of the enemy class, across the spawn manager's basic then hard enemy classes
+	int32 EnemyClassIndex;
+
+	// Spawn point picked when the plan was built. Picked again at spawn time if it is no longer usable
+	int32 SpawnPointIndex;
+};
+
+/**
+	The whole spawn schedule for one round, built during cooldown so spawning only has to walk the list.
+	Plans built from the same seed, enemy classes and player positions are identical.
+*/
+struct FRoundSpawnPlan
+{
+	// The round this plan is for. INDEX_NONE if nothing has been planned
+	int32 Round = INDEX_NONE;
+
+	// Seed the plan was built from
+	int32 Seed = 0;
+
+	// Spawns in the order they are due
+	TArray<FPlannedSpawn> Spawns;
+};
@@ -2,8 +2,16 @@
 #include "SpawnManager.h"
 
 #include "SpawnPoint.h"
+#include "EnemyRegistrySubsystem.h"
+#include "EnemyPoolSubsystem.h"
 #include "../Characters/GameCharacterBase.h"
+#include "../Characters/EnemySignificanceSubsystem.h"
+#include "../Characters/CharacterSpatialHashSubsystem.h"
+#include "../Characters/LineOfSightSubsystem.h"
 
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
 
 ASpawnManager::ASpawnManager()
@@ -17,6 +25,38 @@ ASpawnManager::ASpawnManager()
 	EnemySpawnDelay = 1.0f;
 	SpawnMultiplier = 5;
 	CurrentRound = 0;
+	MaxPooledEnemiesPerClass = 32;
+	NumPrewarmedEnemiesPerClass = 4;
+	MaxPrewarmSpawnsPerFrame = 1;
+	PrewarmClassIndex = 0;
+	bIsSpawning = false;
+	NumEnemiesToSpawn = 0;
+	NumQueuedSpawns = 0;
+	MaxSpawnsPerFrame = 2;
+	SpawnFrameBudgetMs = 1.0f;
+	MaxSpawnAttempts = 30;
+	NumFailedSpawnAttempts = 0;
+	HardEnemySpawnRatio = 0.2f;
+	RoundSpawnTime = 0.0f;
+	RoundPlanSeed = 0;
+	SessionPlanSeed = 0;
+	ClassAliasTablesRound = INDEX_NONE;
+	MinSpawnDistanceFromPlayers = 1500.0f;
+	MaxSpawnDistanceFromPlayers = 6000.0f;
+	PreferredSpawnDistance = 3000.0f;
+	NumBestSpawnPointsToChooseFrom = 3;
+	SpawnPointGridCellSize = 1000.0f;
+	SpawnPointCrowdRadius = 300.0f;
+	MaxCharactersNearSpawnPoint = 2;
+	bAvoidSpawningInPlayerView = true;
+	SpawnLineOfSightLookahead = 0.2f;
+	bRebuildSpawnPointManifestOnSave = true;
+	bUsingSpawnPointManifest = false;
+	NextRoundClassesRound = INDEX_NONE;
+	MaxCleanupsPerFrame = 4;
+	CleanupFrameBudgetMs = 1.0f;
+	CleanupGarbageCollectionThreshold = 16;
+	NumCleanupDestroyedEnemies = 0;
 
 }
 
@@ -25,62 +65,574 @@ void ASpawnManager::BeginPlay()
 	Super::BeginPlay();
 
 	FindSpawnPoints();
-	
+	BuildSpawnPointGrid();
+
+	SessionPlanSeed = RoundPlanSeed != 0 ? RoundPlanSeed : FMath::Rand();
+
+	UEnemyPoolSubsystem* EnemyPool = GetEnemyPool();
+	if (EnemyPool)
+	{
+		EnemyPool->SetMaxPooledPerClass(MaxPooledEnemiesPerClass);
+	}
+
+	UEnemySignificanceSubsystem* EnemySignificance = GetWorld()->GetSubsystem<UEnemySignificanceSubsystem>();
+	if (EnemySignificance)
+	{
+		EnemySignificance->SetSignificanceSettings(EnemySignificanceSettings);
+	}
+
+	RequestRoundEnemyClasses(CurrentRound + 1);
+}
+
+void ASpawnManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (CurrentRoundClassesHandle.IsValid())
+	{
+		CurrentRoundClassesHandle->ReleaseHandle();
+		CurrentRoundClassesHandle.Reset();
+	}
+
+	if (NextRoundClassesHandle.IsValid())
+	{
+		NextRoundClassesHandle->ReleaseHandle();
+		NextRoundClassesHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASpawnManager::PostLoad()
+{
+	Super::PostLoad();
+
+	// Move enemy classes saved before the class arrays became soft references
+	for (TSubclassOf<AActor> EnemyClass : BasicEnemyClassArray_DEPRECATED)
+	{
+		FEnemyClassEntry Entry;
+		Entry.EnemyClass = EnemyClass.Get();
+		BasicEnemyClasses.Add(Entry);
+	}
+
+	for (TSubclassOf<AActor> EnemyClass : HardEnemyClassArray_DEPRECATED)
+	{
+		FEnemyClassEntry Entry;
+		Entry.EnemyClass = EnemyClass.Get();
+		HardEnemyClasses.Add(Entry);
+	}
+
+	BasicEnemyClassArray_DEPRECATED.Empty();
+	HardEnemyClassArray_DEPRECATED.Empty();
+}
+
+TArray<TSubclassOf<AActor>> ASpawnManager::GetBasicEnemyClassArray() const
+{
+	TArray<TSubclassOf<AActor>> EnemyClasses;
+	EnemyClasses.Reserve(BasicEnemyClasses.Num());
+
+	for (const FEnemyClassEntry& Entry : BasicEnemyClasses)
+	{
+		EnemyClasses.Add(Entry.EnemyClass.Get());
+	}
+
+	return EnemyClasses;
+}
+
+TArray<TSubclassOf<AActor>> ASpawnManager::GetHardEnemyClassArray() const
+{
+	TArray<TSubclassOf<AActor>> EnemyClasses;
+	EnemyClasses.Reserve(HardEnemyClasses.Num());
+
+	for (const FEnemyClassEntry& Entry : HardEnemyClasses)
+	{
+		EnemyClasses.Add(Entry.EnemyClass.Get());
+	}
+
+	return EnemyClasses;
+}
+
+void ASpawnManager::RequestRoundEnemyClasses(int Round)
+{
+	if (NextRoundClassesRound == Round && NextRoundClassesHandle.IsValid())
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> RoundClassPaths;
+	for (int EnemyClassIndex = 0; EnemyClassIndex < GetNumEnemyClasses(); EnemyClassIndex++)
+	{
+		const FEnemyClassEntry& Entry = GetEnemyClassEntry(EnemyClassIndex);
+		if (Entry.IsUsedInRound(Round) && !Entry.EnemyClass.IsNull())
+		{
+			RoundClassPaths.AddUnique(Entry.EnemyClass.ToSoftObjectPath());
+		}
+	}
+
+	if (NextRoundClassesHandle.IsValid())
+	{
+		NextRoundClassesHandle->ReleaseHandle();
+		NextRoundClassesHandle.Reset();
+	}
+
+	NextRoundClassesRound = Round;
+
+	if (RoundClassPaths.Num() > 0)
+	{
+		NextRoundClassesHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(RoundClassPaths);
+	}
+}
+
+bool ASpawnManager::AreRoundEnemyClassesResident(int Round) const
+{
+	for (int EnemyClassIndex = 0; EnemyClassIndex < GetNumEnemyClasses(); EnemyClassIndex++)
+	{
+		const FEnemyClassEntry& Entry = GetEnemyClassEntry(EnemyClassIndex);
+		if (Entry.IsUsedInRound(Round) && !Entry.EnemyClass.IsNull() && !Entry.EnemyClass.Get())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ASpawnManager::ReleaseUnusedPooledClasses()
+{
+	UEnemyPoolSubsystem* EnemyPool = GetEnemyPool();
+	if (!EnemyPool)
+	{
+		return;
+	}
+
+	for (int EnemyClassIndex = 0; EnemyClassIndex < GetNumEnemyClasses(); EnemyClassIndex++)
+	{
+		const FEnemyClassEntry& Entry = GetEnemyClassEntry(EnemyClassIndex);
+		if (!Entry.IsUsedInRound(CurrentRound) && !Entry.IsUsedInRound(CurrentRound + 1) && Entry.EnemyClass.Get())
+		{
+			EnemyPool->EmptyPoolForClass(Entry.EnemyClass.Get());
+		}
+	}
 }
 
 AActor* ASpawnManager::SpawnEnemy(bool bSpawnHardEnemy)
 {
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-	
-	ASpawnPoint* SpawnPoint = GetRandomSpawnPoint();
+	const int EnemyClassIndex = bSpawnHardEnemy ? GetRandomHardEnemyClassIndex() : GetRandomBasicEnemyClassIndex();
+
+	TArray<FVector> PlayerLocations;
+	GetPlayerLocations(PlayerLocations);
 
-	AActor* SpawnedActor = nullptr;
+	return SpawnEnemyAt(EnemyClassIndex, PickSpawnPointIndex(EnemyClassIndex, PlayerLocations));
+}
+
+AActor* ASpawnManager::SpawnEnemyAt(int EnemyClassIndex, int SpawnPointIndex)
+{
+	TSubclassOf<AActor> EnemyClass = GetEnemyClass(EnemyClassIndex, true);
+	UEnemyPoolSubsystem* EnemyPool = GetEnemyPool();
 
-	if (!bSpawnHardEnemy)
+	if (!EnemyClass || SpawnPointIndex == INDEX_NONE || !EnemyPool)
 	{
-		SpawnedActor = GetWorld()->SpawnActor<AActor>(GetRandomBasicEnemyClass(), SpawnPoint->GetActorTransform(), SpawnParams);
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	FTransform SpawnTransform;
+
+	// Manifest transforms were checked for this class in the editor, so there is nothing to fix up
+	if (bUsingSpawnPointManifest && SpawnPointManifest.IsValidForClass(SpawnPointIndex, EnemyClassIndex))
+	{
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnTransform = SpawnPointManifest.GetSpawnTransform(SpawnPointIndex, EnemyClassIndex);
 	}
 	else
 	{
-		SpawnedActor = GetWorld()->SpawnActor<AActor>(GetRandomHardEnemyClass(), SpawnPoint->GetActorTransform(), SpawnParams);
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		SpawnTransform = SpawnPoints[SpawnPointIndex]->GetActorTransform();
+	}
+
+	AActor* SpawnedActor = EnemyPool->AcquireEnemy(EnemyClass, SpawnTransform, SpawnParams);
+
+	UEnemyRegistrySubsystem* EnemyRegistry = GetEnemyRegistry();
+	if (SpawnedActor && EnemyRegistry)
+	{
+		EnemyRegistry->RegisterEnemy(SpawnedActor);
 	}
-	
 
 	return SpawnedActor;
 }
 
 int ASpawnManager::GetNumRemainingEnemies() const
 {
-	int NumRemainingEnemies = 0;
+	UEnemyRegistrySubsystem* EnemyRegistry = GetEnemyRegistry();
+	return EnemyRegistry ? EnemyRegistry->GetNumAliveEnemies() : 0;
+}
+
+void ASpawnManager::IncrementCurrentRound()
+{
+	CurrentRound++;
+
+	if (NextRoundClassesRound != CurrentRound)
+	{
+		RequestRoundEnemyClasses(CurrentRound);
+	}
+
+	// The next round's classes are now the current round's. Releasing the old handle lets classes that are no longer used unload
+	if (CurrentRoundClassesHandle.IsValid())
+	{
+		CurrentRoundClassesHandle->ReleaseHandle();
+	}
+
+	CurrentRoundClassesHandle = NextRoundClassesHandle;
+	NextRoundClassesHandle.Reset();
+	NextRoundClassesRound = INDEX_NONE;
+
+	ReleaseUnusedPooledClasses();
+}
+
+void ASpawnManager::StartRoundSpawning()
+{
+	// Enemies left over from the last round would count against MaxEnemies
+	FlushEnemyCleanup();
 
-	for (AActor* IActor : GetAllEnemyActors())
+	if (RoundSpawnPlan.Round != CurrentRound)
 	{
-		AGameCharacterBase* GameCharacter = Cast<AGameCharacterBase>(IActor);
-		if (IsValid(GameCharacter) && GameCharacter->bIsAlive)
+		PlanRound(CurrentRound);
+	}
+
+	NumEnemiesToSpawn = RoundSpawnPlan.Spawns.Num();
+	NumEnemiesSpawned = 0;
+	NumQueuedSpawns = 0;
+	NumFailedSpawnAttempts = 0;
+	RoundSpawnTime = 0.0f;
+	bIsSpawning = NumEnemiesToSpawn > 0;
+}
+
+void ASpawnManager::PlanRound(int Round)
+{
+	RoundSpawnPlan.Round = Round;
+	RoundSpawnPlan.Seed = (int32)HashCombine(GetTypeHash(SessionPlanSeed), GetTypeHash(Round));
+	RoundSpawnPlan.Spawns.Reset();
+
+	const FRandomStream RandomStream(RoundSpawnPlan.Seed);
+
+	FAliasTable RoundBasicAliasTable;
+	FAliasTable RoundHardAliasTable;
+	BuildClassAliasTable(BasicEnemyClasses, Round, RoundBasicAliasTable);
+	BuildClassAliasTable(HardEnemyClasses, Round, RoundHardAliasTable);
+
+	// Spawn points around the players as they are now. Each planned point is checked again when its enemy spawns
+	TArray<FVector> PlayerLocations;
+	TArray<int32> CandidateSpawnPoints;
+	GetPlayerLocations(PlayerLocations);
+	SpawnPointGrid.FindPointsInRange(PlayerLocations, MinSpawnDistanceFromPlayers, MaxSpawnDistanceFromPlayers, CandidateSpawnPoints);
+
+	const int NumRoundEnemies = FMath::Max(SpawnMultiplier * Round, 0);
+
+	// Without any class enabled for the round every sample would fail, so plan an empty round and say so
+	if (NumRoundEnemies > 0 && RoundBasicAliasTable.IsEmpty() && RoundHardAliasTable.IsEmpty())
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::Printf(TEXT("PlanRound: No enemy classes are enabled for round %d! No enemies will spawn"), Round));
+		return;
+	}
+
+	RoundSpawnPlan.Spawns.Reserve(NumRoundEnemies);
+
+	for (int SpawnIndex = 0; SpawnIndex < NumRoundEnemies; SpawnIndex++)
+	{
+		FPlannedSpawn PlannedSpawn;
+		PlannedSpawn.SpawnTime = SpawnIndex * FMath::Max(EnemySpawnDelay, 0.0f);
+
+		// Hard enemies fall back to basic ones when the round has no hard classes, and the other way around
+		const bool bSpawnHardEnemy = ShouldSpawnHardEnemy(SpawnIndex) ? !RoundHardAliasTable.IsEmpty() : RoundBasicAliasTable.IsEmpty();
+
+		// Sample before offsetting hard classes past the basic ones, so a failed sample stays INDEX_NONE
+		const int32 SampledClassIndex = bSpawnHardEnemy ? RoundHardAliasTable.Sample(RandomStream) : RoundBasicAliasTable.Sample(RandomStream);
+		if (SampledClassIndex == INDEX_NONE)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::Printf(TEXT("PlanRound: Could not pick an enemy class for spawn %d of round %d!"), SpawnIndex, Round));
+			continue;
+		}
+
+		PlannedSpawn.EnemyClassIndex = bSpawnHardEnemy ? BasicEnemyClasses.Num() + SampledClassIndex : SampledClassIndex;
+
+		PlannedSpawn.SpawnPointIndex = INDEX_NONE;
+		if (CandidateSpawnPoints.Num() > 0)
+		{
+			const int32 CandidateSpawnPoint = CandidateSpawnPoints[RandomStream.RandRange(0, CandidateSpawnPoints.Num() - 1)];
+			if (CanSpawnAtSpawnPoint(CandidateSpawnPoint, PlannedSpawn.EnemyClassIndex))
+			{
+				PlannedSpawn.SpawnPointIndex = CandidateSpawnPoint;
+			}
+		}
+
+		RoundSpawnPlan.Spawns.Add(PlannedSpawn);
+	}
+}
+
+void ASpawnManager::UpdateSpawnQueue(float DeltaTime)
+{
+	RoundSpawnTime += DeltaTime;
+
+	// Release spawns whose planned time has come on to the queue. Spawns that can not happen this frame stay queued
+	while (NumEnemiesSpawned + NumQueuedSpawns < RoundSpawnPlan.Spawns.Num() && RoundSpawnPlan.Spawns[NumEnemiesSpawned + NumQueuedSpawns].SpawnTime <= RoundSpawnTime)
+	{
+		NumQueuedSpawns++;
+	}
+
+	/**
+		Fetch line of sight for spawns that are about to be due so the results are cached by the time they spawn.
+		Only the spawns the queue can get to within the next couple of frames are fetched, and only for points that pass the cheap checks,
+		so a long lookahead window does not fill the line of sight queue ahead of the pairs that are actually needed.
+	*/
+	if (bAvoidSpawningInPlayerView)
+	{
+		const int LastPrefetchIndex = FMath::Min(RoundSpawnPlan.Spawns.Num(), NumEnemiesSpawned + NumQueuedSpawns + MaxSpawnsPerFrame);
+		for (int PlanIndex = NumEnemiesSpawned; PlanIndex < LastPrefetchIndex && RoundSpawnPlan.Spawns[PlanIndex].SpawnTime <= RoundSpawnTime + SpawnLineOfSightLookahead; PlanIndex++)
+		{
+			const FPlannedSpawn& PlannedSpawn = RoundSpawnPlan.Spawns[PlanIndex];
+			if (PlannedSpawn.SpawnPointIndex != INDEX_NONE && CanSpawnAtSpawnPoint(PlannedSpawn.SpawnPointIndex, PlannedSpawn.EnemyClassIndex) && !IsSpawnPointCrowded(PlannedSpawn.SpawnPointIndex))
+			{
+				IsSpawnPointInPlayerView(PlannedSpawn.SpawnPointIndex);
+			}
+		}
+	}
+
+	UEnemyRegistrySubsystem* EnemyRegistry = GetEnemyRegistry();
+	int NumFreeEnemySlots = MaxEnemies - (EnemyRegistry ? EnemyRegistry->GetNumAliveEnemies() : 0);
+
+	if (NumQueuedSpawns > 0 && NumFreeEnemySlots > 0)
+	{
+		GetPlayerLocations(SpawnTickPlayerLocations);
+	}
+
+	const double SpawnStartTime = FPlatformTime::Seconds();
+	int NumSpawnedThisFrame = 0;
+
+	while (NumQueuedSpawns > 0 && NumFreeEnemySlots > 0 && NumSpawnedThisFrame < MaxSpawnsPerFrame)
+	{
+		// Always spawn at least one enemy a frame so the queue keeps moving when a single spawn is over budget
+		if (NumSpawnedThisFrame > 0 && SpawnFrameBudgetMs > 0.0f && (FPlatformTime::Seconds() - SpawnStartTime) * 1000.0 >= SpawnFrameBudgetMs)
+		{
+			break;
+		}
+
+		FPlannedSpawn& PlannedSpawn = RoundSpawnPlan.Spawns[NumEnemiesSpawned];
+
+		int SpawnPointIndex = PlannedSpawn.SpawnPointIndex;
+		if (!IsPlannedSpawnPointUsable(SpawnPointIndex, PlannedSpawn.EnemyClassIndex))
+		{
+			SpawnPointIndex = PickSpawnPointIndex(PlannedSpawn.EnemyClassIndex, SpawnTickPlayerLocations);
+		}
+
+		if (!SpawnEnemyAt(PlannedSpawn.EnemyClassIndex, SpawnPointIndex))
+		{
+			NumFailedSpawnAttempts++;
+
+			// Give up on a spawn that keeps failing so it does not hold up the rest of the round
+			if (MaxSpawnAttempts > 0 && NumFailedSpawnAttempts >= MaxSpawnAttempts)
+			{
+				GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::Printf(TEXT("UpdateSpawnQueue: Dropped a planned enemy that failed to spawn %d times!"), NumFailedSpawnAttempts));
+
+				RoundSpawnPlan.Spawns.RemoveAt(NumEnemiesSpawned);
+				NumEnemiesToSpawn--;
+				NumQueuedSpawns--;
+				NumFailedSpawnAttempts = 0;
+				continue;
+			}
+
+			// Pick a new spawn point next frame instead of retrying the one that failed
+			PlannedSpawn.SpawnPointIndex = INDEX_NONE;
+			break;
+		}
+
+		NumFailedSpawnAttempts = 0;
+		NumQueuedSpawns--;
+		NumEnemiesSpawned++;
+		NumFreeEnemySlots--;
+		NumSpawnedThisFrame++;
+	}
+
+	if (NumEnemiesSpawned >= NumEnemiesToSpawn)
+	{
+		bIsSpawning = false;
+		OnRoundSpawningFinished();
+	}
+}
+
+bool ASpawnManager::IsPlannedSpawnPointUsable(int SpawnPointIndex, int EnemyClassIndex) const
+{
+	if (SpawnPointIndex == INDEX_NONE || !CanSpawnAtSpawnPoint(SpawnPointIndex, EnemyClassIndex) || IsSpawnPointCrowded(SpawnPointIndex) || IsSpawnPointInPlayerView(SpawnPointIndex))
+	{
+		return false;
+	}
+
+	const FVector& SpawnPointLocation = SpawnPointGrid.GetLocation(SpawnPointIndex);
+	bool bInRangeOfAnyPlayer = false;
+
+	for (const FVector& PlayerLocation : SpawnTickPlayerLocations)
+	{
+		const float DistanceSquared = FVector::DistSquared(SpawnPointLocation, PlayerLocation);
+		if (DistanceSquared < FMath::Square(MinSpawnDistanceFromPlayers))
 		{
-			NumRemainingEnemies++;
+			return false;
 		}
+
+		bInRangeOfAnyPlayer |= DistanceSquared <= FMath::Square(MaxSpawnDistanceFromPlayers);
 	}
 
-	return NumRemainingEnemies;
+	return bInRangeOfAnyPlayer || SpawnTickPlayerLocations.Num() == 0;
 }
 
-void ASpawnManager::IncrementCurrentRound()
+bool ASpawnManager::ShouldSpawnHardEnemy(int SpawnIndex) const
 {
-	CurrentRound++;
+	// True whenever the running total of hard enemies ticks over to the next whole enemy
+	return FMath::FloorToInt((SpawnIndex + 1) * HardEnemySpawnRatio) > FMath::FloorToInt(SpawnIndex * HardEnemySpawnRatio);
 }
 
 void ASpawnManager::CleanupEnemies()
 {
-	for (AActor* IActor : GetAllEnemyActors())
+	UEnemyRegistrySubsystem* EnemyRegistry = GetEnemyRegistry();
+	if (!EnemyRegistry)
 	{
-		IActor->Destroy();
+		return;
+	}
+
+	// Enemies are still registered while queued, so only queue the ones not queued already
+	for (AActor* IActor : EnemyRegistry->GetEnemies())
+	{
+		bool bAlreadyQueued = false;
+		PendingCleanupEnemySet.Add(IActor, &bAlreadyQueued);
+
+		if (!bAlreadyQueued)
+		{
+			PendingCleanupEnemies.Add(IActor);
+		}
+	}
+}
+
+void ASpawnManager::FlushEnemyCleanup()
+{
+	while (PendingCleanupEnemies.Num() > 0)
+	{
+		CleanupNextQueuedEnemy();
+	}
+}
+
+bool ASpawnManager::IsCleaningUpEnemies() const
+{
+	return PendingCleanupEnemies.Num() > 0;
+}
+
+void ASpawnManager::UpdateCleanupQueue()
+{
+	const double CleanupStartTime = FPlatformTime::Seconds();
+	int NumCleanedUpThisFrame = 0;
+
+	while (PendingCleanupEnemies.Num() > 0 && NumCleanedUpThisFrame < MaxCleanupsPerFrame)
+	{
+		// Always clean up at least one enemy a frame so the queue keeps moving when a single cleanup is over budget
+		if (NumCleanedUpThisFrame > 0 && CleanupFrameBudgetMs > 0.0f && (FPlatformTime::Seconds() - CleanupStartTime) * 1000.0 >= CleanupFrameBudgetMs)
+		{
+			break;
+		}
+
+		CleanupNextQueuedEnemy();
+		NumCleanedUpThisFrame++;
+	}
+
+	// The queue just emptied between rounds, which is a safe moment to collect whatever the cleanup destroyed
+	if (PendingCleanupEnemies.Num() == 0 && CleanupGarbageCollectionThreshold > 0 && NumCleanupDestroyedEnemies >= CleanupGarbageCollectionThreshold)
+	{
+		NumCleanupDestroyedEnemies = 0;
+		GEngine->ForceGarbageCollection(false);
+	}
+}
+
+void ASpawnManager::CleanupNextQueuedEnemy()
+{
+	AActor* Enemy = PendingCleanupEnemies.Pop(false);
+
+	// Not in the set when it was already returned to the pool through ReturnEnemyToPool
+	if (PendingCleanupEnemySet.Remove(Enemy) == 0 || !IsValid(Enemy))
+	{
+		return;
+	}
+
+	// Only count enemies that were really destroyed. An enemy the pool ignored leaves nothing to collect
+	UEnemyPoolSubsystem* EnemyPool = GetEnemyPool();
+	if (!EnemyPool)
+	{
+		Enemy->Destroy();
+		NumCleanupDestroyedEnemies++;
+	}
+	else if (EnemyPool->ReleaseEnemy(Enemy) == EEnemyReleaseResult::Destroyed)
+	{
+		NumCleanupDestroyedEnemies++;
+	}
+}
+
+void ASpawnManager::ReturnEnemyToPool(AActor* Enemy)
+{
+	PendingCleanupEnemySet.Remove(Enemy);
+
+	UEnemyPoolSubsystem* EnemyPool = GetEnemyPool();
+	if (EnemyPool)
+	{
+		EnemyPool->ReleaseEnemy(Enemy);
+	}
+	else if (IsValid(Enemy))
+	{
+		Enemy->Destroy();
+	}
+}
+
+void ASpawnManager::PrewarmEnemyPool()
+{
+	UEnemyPoolSubsystem* EnemyPool = GetEnemyPool();
+	const int NumEnemyClasses = GetNumEnemyClasses();
+
+	if (!EnemyPool || NumEnemyClasses <= 0 || NumPrewarmedEnemiesPerClass <= 0)
+	{
+		return;
+	}
+
+	int NumPrewarmSpawns = 0;
+
+	// Visit each class at most once per frame so a fully warmed pool costs nothing more than the loop
+	for (int ClassesChecked = 0; ClassesChecked < NumEnemyClasses && NumPrewarmSpawns < MaxPrewarmSpawnsPerFrame; ClassesChecked++)
+	{
+		PrewarmClassIndex = (PrewarmClassIndex + 1) % NumEnemyClasses;
+
+		// Only warm classes the next round uses, and only once they have streamed in
+		if (!GetEnemyClassEntry(PrewarmClassIndex).IsUsedInRound(CurrentRound + 1))
+		{
+			continue;
+		}
+
+		if (EnemyPool->PrewarmEnemy(GetEnemyClass(PrewarmClassIndex), NumPrewarmedEnemiesPerClass, GetActorTransform()))
+		{
+			NumPrewarmSpawns++;
+		}
 	}
 }
 
 TArray<ASpawnPoint*> ASpawnManager::FindSpawnPoints()
 {
+	SpawnPoints.Reset();
+
+	TArray<FSoftObjectPath> EnemyClassPaths;
+	GetEnemyClassPaths(EnemyClassPaths);
+
+	// Take the spawn points straight from the manifest when it was built for the current enemy classes
+	bUsingSpawnPointManifest = SpawnPointManifest.IsValidFor(FSpawnPointManifest::ComputeClassSignature(EnemyClassPaths));
+	if (bUsingSpawnPointManifest)
+	{
+		for (const FSpawnPointManifestEntry& Entry : SpawnPointManifest.Entries)
+		{
+			SpawnPoints.Add(Entry.SpawnPoint);
+		}
+
+		return SpawnPoints;
+	}
+
 	TArray<AActor*> FoundActors;
 	UGameplayStatics::GetAllActorsOfClass(GetWorld(), SpawnPointClass, FoundActors);
 
@@ -96,95 +648,360 @@ TArray<ASpawnPoint*> ASpawnManager::FindSpawnPoints()
 	return SpawnPoints;
 }
 
-TSubclassOf<AActor> ASpawnManager::GetRandomBasicEnemyClass() const
+void ASpawnManager::BuildSpawnPointGrid()
+{
+	TArray<FVector> SpawnPointLocations;
+	SpawnPointLocations.Reserve(SpawnPoints.Num());
+
+	for (int SpawnPointIndex = 0; SpawnPointIndex < SpawnPoints.Num(); SpawnPointIndex++)
+	{
+		if (bUsingSpawnPointManifest)
+		{
+			SpawnPointLocations.Add(SpawnPointManifest.Entries[SpawnPointIndex].FloorLocation);
+		}
+		else
+		{
+			SpawnPointLocations.Add(SpawnPoints[SpawnPointIndex]->GetActorLocation());
+		}
+	}
+
+	SpawnPointGrid.Build(SpawnPointLocations, SpawnPointGridCellSize);
+}
+
+void ASpawnManager::FindBestSpawnPoints(int MaxResults, TArray<ASpawnPoint*>& OutSpawnPoints) const
+{
+	TArray<FVector> PlayerLocations;
+	GetPlayerLocations(PlayerLocations);
+
+	TArray<int32> SpawnPointIndices;
+	FindBestSpawnPointIndices(MaxResults, INDEX_NONE, PlayerLocations, SpawnPointIndices);
+
+	OutSpawnPoints.Reset();
+	for (int32 SpawnPointIndex : SpawnPointIndices)
+	{
+		OutSpawnPoints.Add(SpawnPoints[SpawnPointIndex]);
+	}
+}
+
+void ASpawnManager::FindBestSpawnPointIndices(int MaxResults, int EnemyClassIndex, const TArray<FVector>& PlayerLocations, TArray<int32>& OutSpawnPointIndices) const
+{
+	OutSpawnPointIndices.Reset();
+
+	if (MaxResults <= 0)
+	{
+		return;
+	}
+
+	SpawnPointGrid.FindPointsInRange(PlayerLocations, MinSpawnDistanceFromPlayers, MaxSpawnDistanceFromPlayers, SpawnPointQueryResults);
+
+	/**
+		Keep the best scoring spawn points sorted by score. MaxResults is small so insertion beats sorting every candidate.
+		Line of sight is left out of this pass, since every check queues traces for each player. Twice MaxResults are kept
+		so there are spare points to replace the ones the players turn out to see.
+	*/
+	const int32 MaxCandidates = MaxResults * 2;
+	TArray<TPair<float, int32>, TInlineAllocator<16>> BestSpawnPoints;
+
+	for (int32 SpawnPointIndex : SpawnPointQueryResults)
+	{
+		if (!CanSpawnAtSpawnPoint(SpawnPointIndex, EnemyClassIndex) || IsSpawnPointCrowded(SpawnPointIndex))
+		{
+			continue;
+		}
+
+		const FVector& SpawnPointLocation = SpawnPointGrid.GetLocation(SpawnPointIndex);
+
+		float NearestPlayerDistanceSquared = TNumericLimits<float>::Max();
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			NearestPlayerDistanceSquared = FMath::Min(NearestPlayerDistanceSquared, FVector::DistSquared(SpawnPointLocation, PlayerLocation));
+		}
+
+		const float Score = -FMath::Abs(FMath::Sqrt(NearestPlayerDistanceSquared) - PreferredSpawnDistance);
+
+		if (BestSpawnPoints.Num() >= MaxCandidates && Score <= BestSpawnPoints.Last().Key)
+		{
+			continue;
+		}
+
+		int32 InsertIndex = BestSpawnPoints.Num();
+		while (InsertIndex > 0 && BestSpawnPoints[InsertIndex - 1].Key < Score)
+		{
+			InsertIndex--;
+		}
+
+		BestSpawnPoints.Insert(TPair<float, int32>(Score, SpawnPointIndex), InsertIndex);
+
+		if (BestSpawnPoints.Num() > MaxCandidates)
+		{
+			BestSpawnPoints.Pop(false);
+		}
+	}
+
+	// Only the chosen few are checked against the players' view, best first
+	for (const TPair<float, int32>& BestSpawnPoint : BestSpawnPoints)
+	{
+		if (OutSpawnPointIndices.Num() >= MaxResults)
+		{
+			break;
+		}
+
+		if (!IsSpawnPointInPlayerView(BestSpawnPoint.Value))
+		{
+			OutSpawnPointIndices.Add(BestSpawnPoint.Value);
+		}
+	}
+}
+
+bool ASpawnManager::CanSpawnAtSpawnPoint(int SpawnPointIndex, int EnemyClassIndex) const
+{
+	ASpawnPoint* SpawnPoint = SpawnPoints[SpawnPointIndex];
+	if (!IsValid(SpawnPoint) || !SpawnPoint->IsSpawnPointEnabled())
+	{
+		return false;
+	}
+
+	return !bUsingSpawnPointManifest || EnemyClassIndex == INDEX_NONE || SpawnPointManifest.IsValidForClass(SpawnPointIndex, EnemyClassIndex);
+}
+
+bool ASpawnManager::IsSpawnPointCrowded(int SpawnPointIndex) const
+{
+	if (MaxCharactersNearSpawnPoint <= 0)
+	{
+		return false;
+	}
+
+	UCharacterSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UCharacterSpatialHashSubsystem>();
+	if (!SpatialHash)
+	{
+		return false;
+	}
+
+	return SpatialHash->CountInSphere(SpawnPointGrid.GetLocation(SpawnPointIndex), SpawnPointCrowdRadius, ECharacterQueryFilter::Alive, MaxCharactersNearSpawnPoint) >= MaxCharactersNearSpawnPoint;
+}
+
+bool ASpawnManager::IsSpawnPointInPlayerView(int SpawnPointIndex) const
+{
+	ULineOfSightSubsystem* LineOfSight = GetWorld()->GetSubsystem<ULineOfSightSubsystem>();
+	if (!bAvoidSpawningInPlayerView || !LineOfSight)
+	{
+		return false;
+	}
+
+	const ASpawnPoint* SpawnPoint = SpawnPoints[SpawnPointIndex];
+	bool bInPlayerView = false;
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (!PlayerController || !PlayerController->GetPawn())
+		{
+			continue;
+		}
+
+		bool bHasLineOfSight;
+		if (LineOfSight->GetCachedLineOfSight(PlayerController->GetPawn(), SpawnPoint, bHasLineOfSight))
+		{
+			bInPlayerView |= bHasLineOfSight;
+		}
+		else
+		{
+			LineOfSight->PrefetchLineOfSight(PlayerController->GetPawn(), SpawnPoint);
+		}
+	}
+
+	return bInPlayerView;
+}
+
+void ASpawnManager::GetPlayerLocations(TArray<FVector>& OutPlayerLocations) const
 {
-	int ClassIndex = FMath::FRandRange(0, BasicEnemyClassArray.Num() - 1);
+	OutPlayerLocations.Reset();
 
-	if (BasicEnemyClassArray.IsValidIndex(ClassIndex))
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
 	{
-		return BasicEnemyClassArray[ClassIndex];
+		APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController && PlayerController->GetPawn())
+		{
+			OutPlayerLocations.Add(PlayerController->GetPawn()->GetActorLocation());
+		}
+	}
+}
+
+int ASpawnManager::GetRandomBasicEnemyClassIndex() const
+{
+	UpdateClassAliasTables();
+	int ClassIndex = BasicClassAliasTable.Sample();
+
+	if (BasicEnemyClasses.IsValidIndex(ClassIndex))
+	{
+		return ClassIndex;
 	}
 	else
 	{
 		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "GetRandomBasicEnemyClass: ClassIndex invalid!");
-		return nullptr;
+		return INDEX_NONE;
 	}
 }
 
-TSubclassOf<AActor> ASpawnManager::GetRandomHardEnemyClass() const
+int ASpawnManager::GetRandomHardEnemyClassIndex() const
 {
-	int ClassIndex = FMath::FRandRange(0, HardEnemyClassArray.Num() - 1);
+	UpdateClassAliasTables();
+	int ClassIndex = HardClassAliasTable.Sample();
 
-	if (HardEnemyClassArray.IsValidIndex(ClassIndex))
+	if (HardEnemyClasses.IsValidIndex(ClassIndex))
 	{
-		return HardEnemyClassArray[ClassIndex];
+		return BasicEnemyClasses.Num() + ClassIndex;
 	}
 	else
 	{
 		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "GetRandomHardEnemyClass: ClassIndex invalid!");
-		return nullptr;
+		return INDEX_NONE;
 	}
 }
 
-TArray<AActor*> ASpawnManager::GetAllEnemyActors() const
+void ASpawnManager::BuildClassAliasTable(const TArray<FEnemyClassEntry>& EnemyClassArray, int Round, FAliasTable& OutAliasTable)
 {
-	TArray<AActor*> CombinedFoundActors;
+	TArray<float> ClassWeights;
+	ClassWeights.Reserve(EnemyClassArray.Num());
 
-	// Get all actors of classes found in BasicEnemyClassArray
-	for (TSubclassOf<AActor> ActorClass : BasicEnemyClassArray)
+	for (const FEnemyClassEntry& Entry : EnemyClassArray)
 	{
-		TArray<AActor*> FoundActors;
-		UGameplayStatics::GetAllActorsOfClass(GetWorld(), ActorClass, FoundActors);
-				
-		for (AActor* IActor : FoundActors)
-		{
-			CombinedFoundActors.Add(IActor);
-		}
+		ClassWeights.Add(Entry.IsUsedInRound(Round) && !Entry.EnemyClass.IsNull() ? Entry.Weight : 0.0f);
 	}
 
-	// Get all actors of classes found in HardEnemyClassArray
-	for (TSubclassOf<AActor> ActorClass : HardEnemyClassArray)
+	OutAliasTable.Build(ClassWeights);
+}
+
+void ASpawnManager::UpdateClassAliasTables() const
+{
+	if (ClassAliasTablesRound != CurrentRound)
 	{
-		TArray<AActor*> FoundActors;
-		UGameplayStatics::GetAllActorsOfClass(GetWorld(), ActorClass, FoundActors);
+		BuildClassAliasTable(BasicEnemyClasses, CurrentRound, BasicClassAliasTable);
+		BuildClassAliasTable(HardEnemyClasses, CurrentRound, HardClassAliasTable);
+		ClassAliasTablesRound = CurrentRound;
+	}
+}
 
-		for (AActor* IActor : FoundActors)
-		{
-			CombinedFoundActors.Add(IActor);
-		}
+const FEnemyClassEntry& ASpawnManager::GetEnemyClassEntry(int EnemyClassIndex) const
+{
+	return EnemyClassIndex < BasicEnemyClasses.Num() ? BasicEnemyClasses[EnemyClassIndex] : HardEnemyClasses[EnemyClassIndex - BasicEnemyClasses.Num()];
+}
+
+TSubclassOf<AActor> ASpawnManager::GetEnemyClass(int EnemyClassIndex, bool bLoadIfNotResident) const
+{
+	if (EnemyClassIndex < 0 || EnemyClassIndex >= GetNumEnemyClasses())
+	{
+		return nullptr;
+	}
+
+	const TSoftClassPtr<AActor>& EnemyClass = GetEnemyClassEntry(EnemyClassIndex).EnemyClass;
+
+	if (!EnemyClass.Get() && bLoadIfNotResident && !EnemyClass.IsNull())
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Yellow, "GetEnemyClass: Enemy class was not streamed in before it was needed. Loading it now");
+		return EnemyClass.LoadSynchronous();
+	}
+
+	return EnemyClass.Get();
+}
+
+int ASpawnManager::GetNumEnemyClasses() const
+{
+	return BasicEnemyClasses.Num() + HardEnemyClasses.Num();
+}
+
+void ASpawnManager::GetEnemyClassPaths(TArray<FSoftObjectPath>& OutEnemyClassPaths) const
+{
+	OutEnemyClassPaths.Reset();
+
+	for (int EnemyClassIndex = 0; EnemyClassIndex < GetNumEnemyClasses(); EnemyClassIndex++)
+	{
+		OutEnemyClassPaths.Add(GetEnemyClassEntry(EnemyClassIndex).EnemyClass.ToSoftObjectPath());
 	}
+}
 
-	return CombinedFoundActors;
+UEnemyRegistrySubsystem* ASpawnManager::GetEnemyRegistry() const
+{
+	UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UEnemyRegistrySubsystem>() : nullptr;
+}
+
+UEnemyPoolSubsystem* ASpawnManager::GetEnemyPool() const
+{
+	UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr;
 }
 
 ASpawnPoint* ASpawnManager::GetRandomSpawnPoint() const
+{
+	TArray<FVector> PlayerLocations;
+	GetPlayerLocations(PlayerLocations);
+
+	const int SpawnPointIndex = PickSpawnPointIndex(INDEX_NONE, PlayerLocations);
+	return SpawnPointIndex != INDEX_NONE ? SpawnPoints[SpawnPointIndex] : nullptr;
+}
+
+int ASpawnManager::PickSpawnPointIndex(int EnemyClassIndex, const TArray<FVector>& PlayerLocations) const
 {
 	if (SpawnPoints.Num() <= 0)
 	{
 		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "GetRandomSpawnPoint: There were no spawn points found!");
-		return nullptr;
+		return INDEX_NONE;
 	}
 
-	int NumSpawnPoints = SpawnPoints.Num();
+	FindBestSpawnPointIndices(NumBestSpawnPointsToChooseFrom, EnemyClassIndex, PlayerLocations, BestSpawnPointIndices);
 
-	int SpawnPointIndex = FMath::FRandRange(0, SpawnPoints.Num() - 1);
-
-	if (SpawnPoints.IsValidIndex(SpawnPointIndex))
+	if (BestSpawnPointIndices.Num() > 0)
 	{
-		return SpawnPoints[SpawnPointIndex];
+		return BestSpawnPointIndices[FMath::RandRange(0, BestSpawnPointIndices.Num() - 1)];
 	}
 
-	else
+	return GetAnyEnabledSpawnPointIndex(EnemyClassIndex);
+}
+
+int ASpawnManager::GetAnyEnabledSpawnPointIndex(int EnemyClassIndex) const
+{
+	// Start at a random spawn point and take the first usable one from there
+	const int NumSpawnPoints = SpawnPoints.Num();
+	const int StartIndex = FMath::RandRange(0, NumSpawnPoints - 1);
+
+	for (int Offset = 0; Offset < NumSpawnPoints; Offset++)
 	{
-		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "GetRandomSpawnPoint: SpanPointIndex invalid!");
-		return nullptr;
+		const int SpawnPointIndex = (StartIndex + Offset) % NumSpawnPoints;
+		if (CanSpawnAtSpawnPoint(SpawnPointIndex, EnemyClassIndex))
+		{
+			return SpawnPointIndex;
+		}
 	}
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "GetRandomSpawnPoint: There were no enabled spawn points found!");
+	return INDEX_NONE;
 }
 
 void ASpawnManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	if (bIsSpawning && NumEnemiesToSpawn > 0)
+	{
+		UpdateSpawnQueue(DeltaTime);
+	}
+
+	if (PendingCleanupEnemies.Num() > 0)
+	{
+		UpdateCleanupQueue();
+	}
+
+	if (CurrentRoundState == ERoundState::Cooldown)
+	{
+		RequestRoundEnemyClasses(CurrentRound + 1);
+		PrewarmEnemyPool();
+
+		if (RoundSpawnPlan.Round != CurrentRound + 1)
+		{
+			PlanRound(CurrentRound + 1);
+		}
+	}
 }
 
 int ASpawnManager::GetCurrentRound() const
@@ -192,3 +1009,41 @@ int ASpawnManager::GetCurrentRound() const
 	return CurrentRound;
 }
 
+#if WITH_EDITOR
+void ASpawnManager::BuildSpawnPointManifest()
+{
+	TArray<AActor*> FoundActors;
+	UGameplayStatics::GetAllActorsOfClass(GetWorld(), SpawnPointClass ? *SpawnPointClass : ASpawnPoint::StaticClass(), FoundActors);
+
+	TArray<ASpawnPoint*> LevelSpawnPoints;
+	for (AActor* SpawnPointActor : FoundActors)
+	{
+		ASpawnPoint* SpawnPoint = Cast<ASpawnPoint>(SpawnPointActor);
+		if (SpawnPoint)
+		{
+			LevelSpawnPoints.Add(SpawnPoint);
+		}
+	}
+
+	// The editor needs the class defaults for their capsules. Load them directly, not through GetEnemyClass, which warns about classes that were not streamed in
+	TArray<UClass*> EnemyClasses;
+	for (int EnemyClassIndex = 0; EnemyClassIndex < GetNumEnemyClasses(); EnemyClassIndex++)
+	{
+		EnemyClasses.Add(GetEnemyClassEntry(EnemyClassIndex).EnemyClass.LoadSynchronous());
+	}
+
+	Modify();
+	SpawnPointManifest.Build(GetWorld(), LevelSpawnPoints, EnemyClasses, TArray<AActor*>({ this }));
+}
+
+void ASpawnManager::PreSave(const class ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	// Only rebuild on a normal editor save. Cook and commandlet worlds have no navigation or collision to validate against
+	if (bRebuildSpawnPointManifestOnSave && !TargetPlatform && !IsRunningCommandlet() && !IsTemplate() && GetWorld() && GetWorld()->WorldType == EWorldType::Editor)
+	{
+		BuildSpawnPointManifest();
+	}
+}
+#endif
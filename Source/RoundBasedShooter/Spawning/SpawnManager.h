@@ -4,9 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "SpawnPointGrid.h"
+#include "SpawnPointManifest.h"
+#include "AliasTable.h"
+#include "RoundSpawnPlan.h"
+#include "../Characters/EnemySignificanceSubsystem.h"
 #include "SpawnManager.generated.h"
 
 class ASpawnPoint;
+class UEnemyRegistrySubsystem;
+class UEnemyPoolSubsystem;
+struct FStreamableHandle;
 
 UENUM(Blueprintable)
 enum ERoundState
@@ -15,10 +23,50 @@ enum ERoundState
 	Cooldown UMETA(DisplayName = "Cooldown")
 };
 
+USTRUCT(BlueprintType)
+struct FEnemyClassEntry
+{
+	GENERATED_BODY()
+
+public:
+
+	// The enemy class. Soft so the class and everything it references is only loaded for the rounds it is used in
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
+	TSoftClassPtr<AActor> EnemyClass;
+
+	// First round this enemy can be spawned in
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (ClampMin = "1"))
+	int FirstRound;
+
+	// Last round this enemy can be spawned in. 0 for no last round
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (ClampMin = "0"))
+	int LastRound;
+
+	// How likely this enemy is to be picked compared to the other enemies of the same array in the same round
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (ClampMin = "0.0"))
+	float Weight;
+
+	FEnemyClassEntry()
+	{
+		FirstRound = 1;
+		LastRound = 0;
+		Weight = 1.0f;
+	}
+
+	// If this enemy can be spawned in the given round
+	bool IsUsedInRound(int Round) const
+	{
+		return Round >= FirstRound && (LastRound <= 0 || Round <= LastRound);
+	}
+};
+
 UCLASS()
 class ROUNDBASEDSHOOTER_API ASpawnManager : public AActor
 {
 	GENERATED_BODY()
+
+	// Drives rounds through the same calls the game's Blueprints use
+	friend class ARoundBenchmarkRunner;
 	
 public:	
 
@@ -30,35 +78,135 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Spawning")
 	int GetCurrentRound() const;
 
+#if WITH_EDITOR
+	// Validates every spawn point in the level against every enemy class and stores the results in SpawnPointManifest
+	UFUNCTION(CallInEditor, Category = "Spawning")
+	void BuildSpawnPointManifest();
+
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+#endif
+
+	virtual void PostLoad() override;
+
+	/**
+		Starts streaming in the enemy classes used in the given round and keeps them loaded until the round after it begins.
+		Called automatically for the next round during cooldown.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	void RequestRoundEnemyClasses(int Round);
+
+	// If every enemy class used in the given round is loaded
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	bool AreRoundEnemyClassesResident(int Round) const;
+
 protected:
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/**
+		Spawn points of this level validated in the editor with BuildSpawnPointManifest. While it matches the enemy class arrays
+		the spawn manager uses it instead of scanning the level, and spawns at its transforms without any collision fixup.
+	*/
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	FSpawnPointManifest SpawnPointManifest;
+
+	// Rebuild SpawnPointManifest every time the level is saved in the editor
+	UPROPERTY(EditAnywhere, Category = "Spawning")
+	bool bRebuildSpawnPointManifestOnSave;
+
 	// The spawn point blueprint class
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
 	TSubclassOf<ASpawnPoint> SpawnPointClass;
 
-	// Array containing all the classes of basic enemies that can be spawned
+	// All the classes of basic enemies that can be spawned and the rounds they are used in
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
-	TArray<TSubclassOf<AActor>> BasicEnemyClassArray;
+	TArray<FEnemyClassEntry> BasicEnemyClasses;
 
-	// Array containing all the classes of harder enemies that can be spawned
+	// All the classes of harder enemies that can be spawned and the rounds they are used in
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
-	TArray<TSubclassOf<AActor>> HardEnemyClassArray;
+	TArray<FEnemyClassEntry> HardEnemyClasses;
+
+	// Replaced by BasicEnemyClasses. Hard references loaded every enemy with the level. Moved over in PostLoad
+	UPROPERTY()
+	TArray<TSubclassOf<AActor>> BasicEnemyClassArray_DEPRECATED;
+
+	// Replaced by HardEnemyClasses. Moved over in PostLoad
+	UPROPERTY()
+	TArray<TSubclassOf<AActor>> HardEnemyClassArray_DEPRECATED;
+
+	// Classes of BasicEnemyClasses, for blueprints that read BasicEnemyClassArray. Classes that are not loaded yet are null
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	TArray<TSubclassOf<AActor>> GetBasicEnemyClassArray() const;
+
+	// Classes of HardEnemyClasses, for blueprints that read HardEnemyClassArray. Classes that are not loaded yet are null
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	TArray<TSubclassOf<AActor>> GetHardEnemyClassArray() const;
 
 	// Spawns an enemy
 	UFUNCTION(BlueprintCallable, Category = "Spawning")
 	AActor* SpawnEnemy(bool bSpawnHardEnemy = false);
 
+	// Number of spawned enemies that are still alive. Cheap enough to poll every frame
 	UFUNCTION(BlueprintPure, Category = "Spawning")
 	int GetNumRemainingEnemies() const;
 
 	UPROPERTY(BlueprintReadWrite, Category = "Spawning")
 	bool bIsSpawning;
 
+	// Picks a random spawn point from the best scoring spawn points around the players. Falls back to any enabled spawn point if none are in range
 	UFUNCTION(BlueprintPure, Category = "Spawning")
 	ASpawnPoint* GetRandomSpawnPoint() const;
 
+	/**
+		Finds the enabled spawn points between MinSpawnDistanceFromPlayers and MaxSpawnDistanceFromPlayers of the players, best score first.
+		Spawn points score higher the closer their distance to the nearest player is to PreferredSpawnDistance.
+		@param MaxResults - Max number of spawn points returned
+		@param OutSpawnPoints - The best spawn points found
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	void FindBestSpawnPoints(int MaxResults, TArray<ASpawnPoint*>& OutSpawnPoints) const;
+
+	// Enemies are not spawned closer than this to any player
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float MinSpawnDistanceFromPlayers;
+
+	// Enemies are spawned at most this far from the nearest player
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float MaxSpawnDistanceFromPlayers;
+
+	// Distance to the nearest player that spawn points score best at
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float PreferredSpawnDistance;
+
+	// Number of best scoring spawn points GetRandomSpawnPoint picks between
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	int NumBestSpawnPointsToChooseFrom;
+
+	// Size of the cells in the spawn point grid. Roughly the spacing of spawn points works well
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float SpawnPointGridCellSize;
+
+	// Spawn points with at least MaxCharactersNearSpawnPoint characters within this radius are skipped so enemies do not pile up
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float SpawnPointCrowdRadius;
+
+	// Number of characters near a spawn point that makes it crowded. 0 never treats spawn points as crowded
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	int MaxCharactersNearSpawnPoint;
+
+	/**
+		Skip spawn points a player can see. Visibility comes from line of sight results cached by the line of sight subsystem,
+		which are fetched ahead of planned spawns. A spawn point with no result yet counts as out of view
+	*/
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	bool bAvoidSpawningInPlayerView;
+
+	// Seconds ahead of a planned spawn that line of sight from the players to its spawn point is fetched
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float SpawnLineOfSightLookahead;
+
 	// Current round state
 	UPROPERTY(BlueprintReadWrite, Category = "Spawning")
 	TEnumAsByte<ERoundState> CurrentRoundState;
@@ -88,23 +236,238 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "Spawning")
 	void IncrementCurrentRound();
 
-	// Destroys all enemy actors. Dead or alive. Used to clean up enemies before new round start
+	/**
+		Starts spawning this round's enemies from tick, following the round's spawn plan. Plans the round first if that has not happened yet.
+		Enemies are released to the spawn queue at their planned times and the queue is worked through within the per frame spawn budget.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	void StartRoundSpawning();
+
+	/**
+		Builds the spawn plan for the given round in one pass: class, spawn point and spawn time of every enemy.
+		The round's quota is SpawnMultiplier * Round and enemies are due every EnemySpawnDelay. Called automatically for the next round during cooldown.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	void PlanRound(int Round);
+
+	// Seed for round spawn plans. The same seed gives the same rounds, which is useful for benchmarking. 0 picks a new seed every play session
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	int RoundPlanSeed;
+
+	// Called once every enemy in the round's quota has been spawned by the spawn queue
+	UFUNCTION(BlueprintImplementableEvent, Category = "Spawning")
+	void OnRoundSpawningFinished();
+
+	// Number of enemies to spawn this round. Set by StartRoundSpawning
+	UPROPERTY(BlueprintReadOnly, Category = "Spawning")
+	int NumEnemiesToSpawn;
+
+	// Number of enemies waiting in the spawn queue. These are due but have not been spawned yet due to the frame budget or MaxEnemies
+	UPROPERTY(BlueprintReadOnly, Category = "Spawning")
+	int NumQueuedSpawns;
+
+	// Max number of enemies the spawn queue spawns in a single frame. Leftover spawns are carried over to the next frames
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	int MaxSpawnsPerFrame;
+
+	// Time in milliseconds the spawn queue may spend spawning in a single frame. At least one enemy is always spawned. 0 for no time limit
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning")
+	float SpawnFrameBudgetMs;
+
+	// Number of frames in a row the spawn queue tries a planned enemy that fails to spawn before it drops it from the round. 0 never drops one
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning", meta = (ClampMin = "0"))
+	int MaxSpawnAttempts;
+
+	// Fraction of the round's enemies the spawn queue spawns as hard enemies. Hard enemies are spread evenly through the round
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Spawning", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float HardEnemySpawnRatio;
+
+	/**
+		Queues every enemy actor, dead or alive, to be returned to the enemy pool. Used to clean up enemies before new round start.
+		The queue is worked through on tick within the per frame cleanup budget. StartRoundSpawning finishes any cleanup still queued.
+	*/
 	UFUNCTION(BlueprintCallable, Category = "Spawning")
 	void CleanupEnemies();
 
+	// Returns every enemy still queued for cleanup to the pool right away
+	UFUNCTION(BlueprintCallable, Category = "Cleanup")
+	void FlushEnemyCleanup();
+
+	// If enemies queued by CleanupEnemies are still waiting to be returned to the pool
+	UFUNCTION(BlueprintPure, Category = "Cleanup")
+	bool IsCleaningUpEnemies() const;
+
+	// Max number of enemies the cleanup queue returns to the pool in a single frame
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Cleanup")
+	int MaxCleanupsPerFrame;
+
+	// Time in milliseconds the cleanup queue may spend in a single frame. At least one enemy is always cleaned up. 0 for no time limit
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Cleanup")
+	float CleanupFrameBudgetMs;
+
+	/**
+		Number of enemies a cleanup has to destroy, because their pool was full or there is no pool, before a garbage collection
+		is requested once the cleanup queue is empty. The collection purges incrementally so it does not hitch either. 0 never requests one
+	*/
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Cleanup")
+	int CleanupGarbageCollectionThreshold;
+
+	// Returns a single enemy to the enemy pool. Call this once a dead enemy is no longer needed in the level
+	UFUNCTION(BlueprintCallable, Category = "Pooling")
+	void ReturnEnemyToPool(AActor* Enemy);
+
+	// Max number of inactive enemies kept in the pool for each enemy class. Enemies returned past this are destroyed
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Pooling")
+	int MaxPooledEnemiesPerClass;
+
+	// Number of inactive enemies of each class to have ready in the pool before the next round starts
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Pooling")
+	int NumPrewarmedEnemiesPerClass;
+
+	// Max number of enemies spawned into the pool per frame while pre-warming during cooldown
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Pooling")
+	int MaxPrewarmSpawnsPerFrame;
+
+	// How often enemies tick, move and animate depending on how far they are from the players. Handed to the enemy significance subsystem on begin play
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Significance")
+	FEnemySignificanceSettings EnemySignificanceSettings;
+
 private:
 
-	// Gets and saves all spawn points in the level
+	// Gets and saves all spawn points in the level. Takes them from the spawn point manifest when it is up to date
 	TArray<ASpawnPoint*> FindSpawnPoints();
 
+	// If SpawnPoints came from the spawn point manifest. Spawn point indices then match manifest entry indices
+	bool bUsingSpawnPointManifest;
+
 	TArray<ASpawnPoint*> SpawnPoints;		
 
-	TSubclassOf<AActor> GetRandomBasicEnemyClass() const;
-	TSubclassOf<AActor> GetRandomHardEnemyClass() const;
+	// Builds the spawn point grid from SpawnPoints. Indices in the grid match indices in SpawnPoints
+	void BuildSpawnPointGrid();
+
+	// Picks the index of a spawn point around the player locations to spawn an enemy of the class at. Pass INDEX_NONE to accept any spawn point
+	int PickSpawnPointIndex(int EnemyClassIndex, const TArray<FVector>& PlayerLocations) const;
+
+	// Same as FindBestSpawnPoints, but around already gathered player locations. Returns indices into SpawnPoints and skips spawn points the enemy class does not fit at
+	void FindBestSpawnPointIndices(int MaxResults, int EnemyClassIndex, const TArray<FVector>& PlayerLocations, TArray<int32>& OutSpawnPointIndices) const;
+
+	// Picks the index of a random enabled spawn point without looking at the players
+	int GetAnyEnabledSpawnPointIndex(int EnemyClassIndex) const;
+
+	// If the spawn point is enabled and the enemy class fits at it
+	bool CanSpawnAtSpawnPoint(int SpawnPointIndex, int EnemyClassIndex) const;
+
+	// If enough characters are standing around the spawn point that spawning there would pile enemies up
+	bool IsSpawnPointCrowded(int SpawnPointIndex) const;
+
+	// If a player is known to see the spawn point. Queues line of sight checks for players with no cached result
+	bool IsSpawnPointInPlayerView(int SpawnPointIndex) const;
+
+	// Locations of all player controlled pawns
+	void GetPlayerLocations(TArray<FVector>& OutPlayerLocations) const;
+
+	// Grid of SpawnPoints locations used to find spawn points around players
+	FSpawnPointGrid SpawnPointGrid;
+
+	// Reused by spawn point queries so they do not allocate on every spawn
+	mutable TArray<int32> SpawnPointQueryResults;
+
+	// Enemy classes are indexed across the basic then the hard enemy classes
+	int GetRandomBasicEnemyClassIndex() const;
+	int GetRandomHardEnemyClassIndex() const;
+	const FEnemyClassEntry& GetEnemyClassEntry(int EnemyClassIndex) const;
+	int GetNumEnemyClasses() const;
+
+	// Returns the enemy class if it is loaded. Loads it on the spot if bLoadIfNotResident is set, which hitches
+	TSubclassOf<AActor> GetEnemyClass(int EnemyClassIndex, bool bLoadIfNotResident = false) const;
+
+	// Builds an alias table over the class array's weights, with classes not used in the round weighted zero
+	static void BuildClassAliasTable(const TArray<FEnemyClassEntry>& EnemyClassArray, int Round, FAliasTable& OutAliasTable);
+
+	// Rebuilds the alias tables used by SpawnEnemy if the round has changed since they were built
+	void UpdateClassAliasTables() const;
+
+	// Weighted pickers over the current round's basic and hard enemy classes
+	mutable FAliasTable BasicClassAliasTable;
+	mutable FAliasTable HardClassAliasTable;
+
+	// The round BasicClassAliasTable and HardClassAliasTable were built for
+	mutable int ClassAliasTablesRound;
+
+	// Spawns an enemy of the class at the spawn point, reusing a pooled enemy when there is one
+	AActor* SpawnEnemyAt(int EnemyClassIndex, int SpawnPointIndex);
+
+	// If the spawn point can still be used for the class and is within the spawn distance band of the players in SpawnTickPlayerLocations
+	bool IsPlannedSpawnPointUsable(int SpawnPointIndex, int EnemyClassIndex) const;
+
+	// Player locations gathered once per spawn tick by UpdateSpawnQueue, so checking each planned spawn does not gather them again
+	TArray<FVector> SpawnTickPlayerLocations;
+
+	// Spawn plan of the current or next round
+	FRoundSpawnPlan RoundSpawnPlan;
+
+	// Number of frames the planned spawn at the head of the queue has failed to spawn
+	int NumFailedSpawnAttempts;
+
+	// Seed used for this play session's round plans. Equal to RoundPlanSeed unless that is 0
+	int SessionPlanSeed;
+
+	// Time since StartRoundSpawning was called
+	float RoundSpawnTime;
+
+	// Releases pooled enemies of classes that are not used in the current or next round so the classes can unload
+	void ReleaseUnusedPooledClasses();
+
+	// Keeps the enemy classes of the current round loaded
+	TSharedPtr<FStreamableHandle> CurrentRoundClassesHandle;
+
+	// Keeps the enemy classes of the next round loaded once they have been requested
+	TSharedPtr<FStreamableHandle> NextRoundClassesHandle;
+
+	// The round NextRoundClassesHandle was requested for
+	int NextRoundClassesRound;
+
+	// Paths of all enemy classes in enemy class index order
+	void GetEnemyClassPaths(TArray<FSoftObjectPath>& OutEnemyClassPaths) const;
+
+	// Reused by PickSpawnPointIndex so picking a spawn point does not allocate
+	mutable TArray<int32> BestSpawnPointIndices;
 
 	int CurrentRound;
 
-	// Loops through the array of basic and hard actor classes and runs GetAllActorsofClass. WARNING: Expensive. Do not use on tick
-	TArray<AActor*> GetAllEnemyActors() const;
+	// The world's enemy registry. Every enemy spawned by the spawn manager is registered with it
+	UEnemyRegistrySubsystem* GetEnemyRegistry() const;
+
+	// The world's enemy pool. Enemies are taken from and returned to it instead of being spawned and destroyed
+	UEnemyPoolSubsystem* GetEnemyPool() const;
+
+	// Moves due spawns on to the spawn queue and spawns as many queued enemies as the frame budget allows
+	void UpdateSpawnQueue(float DeltaTime);
+
+	// If the spawn with the given index in the round should be a hard enemy
+	bool ShouldSpawnHardEnemy(int SpawnIndex) const;
+
+
+	// Returns queued enemies to the pool within the per frame cleanup budget
+	void UpdateCleanupQueue();
+
+	// Returns the next queued enemy to the pool
+	void CleanupNextQueuedEnemy();
+
+	// Enemies waiting to be returned to the pool by the cleanup queue
+	UPROPERTY()
+	TArray<AActor*> PendingCleanupEnemies;
+
+	// Enemies still to be cleaned up. Enemies returned to the pool early are taken out of this and skipped when the queue reaches them
+	TSet<AActor*> PendingCleanupEnemySet;
+
+	// Number of enemies destroyed rather than pooled since the last garbage collection request
+	int NumCleanupDestroyedEnemies;
+
+	// Spawns a few inactive enemies into the pool, cycling through the enemy classes. Called on tick during cooldown
+	void PrewarmEnemyPool();
+
+	// Index of the next enemy class to pre-warm, across the basic then hard enemy classes
+	int PrewarmClassIndex;
 	
 };
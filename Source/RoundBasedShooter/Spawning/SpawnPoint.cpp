@@ -8,4 +8,15 @@ ASpawnPoint::ASpawnPoint()
 {
 	PrimaryActorTick.bCanEverTick = false;
 
+	bIsEnabled = true;
+}
+
+void ASpawnPoint::SetSpawnPointEnabled(bool bEnabled)
+{
+	bIsEnabled = bEnabled;
+}
+
+bool ASpawnPoint::IsSpawnPointEnabled() const
+{
+	return bIsEnabled;
 }
@@ -15,8 +15,19 @@ public:
 
 	ASpawnPoint();
 
+	// Enables or disables the spawn point. Disabled spawn points are skipped by the spawn manager
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	void SetSpawnPointEnabled(bool bEnabled);
+
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	bool IsSpawnPointEnabled() const;
+
 protected:
 
+	// If the spawn manager can use this spawn point
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
+	bool bIsEnabled;
+
 public:	
 
 };
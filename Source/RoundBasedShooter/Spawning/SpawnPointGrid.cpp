@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnPointGrid.h"
+
+FSpawnPointGrid::FSpawnPointGrid()
+{
+	CellSize = 1000.0f;
+	QueryStamp = 0;
+}
+
+void FSpawnPointGrid::Build(const TArray<FVector>& Locations, float InCellSize)
+{
+	Reset();
+
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	PointLocations = Locations;
+
+	// Give every occupied cell an index and count its points
+	TArray<int32> PointCells;
+	TArray<int32> CellCounts;
+	PointCells.Reserve(Locations.Num());
+
+	for (const FVector& Location : Locations)
+	{
+		const FIntPoint Cell = GetCell(Location);
+
+		int32* CellIndex = CellLookup.Find(Cell);
+		if (!CellIndex)
+		{
+			CellIndex = &CellLookup.Add(Cell, CellCounts.Add(0));
+		}
+
+		CellCounts[*CellIndex]++;
+		PointCells.Add(*CellIndex);
+	}
+
+	// Prefix sum the counts into range starts
+	CellStarts.SetNumUninitialized(CellCounts.Num() + 1);
+	CellStarts[0] = 0;
+	for (int32 CellIndex = 0; CellIndex < CellCounts.Num(); CellIndex++)
+	{
+		CellStarts[CellIndex + 1] = CellStarts[CellIndex] + CellCounts[CellIndex];
+	}
+
+	// Scatter the points into their cell ranges
+	TArray<int32> CellFill(CellStarts.GetData(), CellCounts.Num());
+	SortedPointIndices.SetNumUninitialized(Locations.Num());
+	SortedLocations.SetNumUninitialized(Locations.Num());
+
+	for (int32 PointIndex = 0; PointIndex < Locations.Num(); PointIndex++)
+	{
+		const int32 SortedIndex = CellFill[PointCells[PointIndex]]++;
+		SortedPointIndices[SortedIndex] = PointIndex;
+		SortedLocations[SortedIndex] = Locations[PointIndex];
+	}
+
+	PointQueryStamps.SetNumZeroed(Locations.Num());
+}
+
+void FSpawnPointGrid::Reset()
+{
+	PointLocations.Reset();
+	SortedPointIndices.Reset();
+	SortedLocations.Reset();
+	CellStarts.Reset();
+	CellLookup.Reset();
+	PointQueryStamps.Reset();
+	QueryStamp = 0;
+}
+
+void FSpawnPointGrid::FindPointsInRange(const TArray<FVector>& QueryLocations, float MinDistance, float MaxDistance, TArray<int32>& OutPointIndices) const
+{
+	OutPointIndices.Reset();
+
+	if (PointLocations.Num() <= 0 || MaxDistance < MinDistance)
+	{
+		return;
+	}
+
+	// Stamps wrap around after 4 billion queries. Clear them so an old stamp can not be mistaken for this query
+	if (++QueryStamp == 0)
+	{
+		FMemory::Memzero(PointQueryStamps.GetData(), PointQueryStamps.Num() * sizeof(uint32));
+		QueryStamp = 1;
+	}
+
+	const float MinDistanceSquared = FMath::Square(MinDistance);
+	const float MaxDistanceSquared = FMath::Square(MaxDistance);
+
+	for (const FVector& QueryLocation : QueryLocations)
+	{
+		const FIntPoint MinCell = GetCell(QueryLocation - FVector(MaxDistance, MaxDistance, 0.0f));
+		const FIntPoint MaxCell = GetCell(QueryLocation + FVector(MaxDistance, MaxDistance, 0.0f));
+
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+		{
+			for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+			{
+				const int32* CellIndex = CellLookup.Find(FIntPoint(CellX, CellY));
+				if (!CellIndex)
+				{
+					continue;
+				}
+
+				for (int32 SortedIndex = CellStarts[*CellIndex]; SortedIndex < CellStarts[*CellIndex + 1]; SortedIndex++)
+				{
+					const FVector& PointLocation = SortedLocations[SortedIndex];
+					const float DistanceSquared = FVector::DistSquared(PointLocation, QueryLocation);
+
+					if (DistanceSquared > MaxDistanceSquared || DistanceSquared < MinDistanceSquared)
+					{
+						continue;
+					}
+
+					const int32 PointIndex = SortedPointIndices[SortedIndex];
+					if (PointQueryStamps[PointIndex] == QueryStamp)
+					{
+						continue;
+					}
+
+					PointQueryStamps[PointIndex] = QueryStamp;
+
+					// The point must also keep its distance from every other query location
+					bool bTooClose = false;
+					for (const FVector& OtherLocation : QueryLocations)
+					{
+						if (FVector::DistSquared(PointLocation, OtherLocation) < MinDistanceSquared)
+						{
+							bTooClose = true;
+							break;
+						}
+					}
+
+					if (!bTooClose)
+					{
+						OutPointIndices.Add(PointIndex);
+					}
+				}
+			}
+		}
+	}
+}
+
+const FVector& FSpawnPointGrid::GetLocation(int32 PointIndex) const
+{
+	return PointLocations[PointIndex];
+}
+
+int32 FSpawnPointGrid::Num() const
+{
+	return PointLocations.Num();
+}
+
+FIntPoint FSpawnPointGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+	Uniform 2D grid over a fixed set of spawn point locations. Built once, then queried for points within a distance band
+	of a set of locations (normally the players) by only visiting the grid cells that overlap the band.
+	Points are stored sorted by cell so each cell is a contiguous range.
+*/
+class ROUNDBASEDSHOOTER_API FSpawnPointGrid
+{
+public:
+
+	FSpawnPointGrid();
+
+	// Builds the grid. Point indices returned by queries are indices into Locations
+	void Build(const TArray<FVector>& Locations, float InCellSize);
+
+	// Removes all points from the grid
+	void Reset();
+
+	/**
+		Finds all points that are at most MaxDistance from at least one of the query locations and at least MinDistance from all of them.
+		@param QueryLocations - Locations to measure the distance from. Normally the player locations
+		@param MinDistance - Points closer than this to any query location are skipped
+		@param MaxDistance - Points must be this close to at least one query location
+		@param OutPointIndices - Indices of the points found. Reset before it is filled
+	*/
+	void FindPointsInRange(const TArray<FVector>& QueryLocations, float MinDistance, float MaxDistance, TArray<int32>& OutPointIndices) const;
+
+	// Location of the point with the given index
+	const FVector& GetLocation(int32 PointIndex) const;
+
+	int32 Num() const;
+
+private:
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	float CellSize;
+
+	// Point locations in the order they were passed to Build
+	TArray<FVector> PointLocations;
+
+	// Point indices sorted by cell
+	TArray<int32> SortedPointIndices;
+
+	// Point locations sorted by cell, so a cell's points are read from contiguous memory
+	TArray<FVector> SortedLocations;
+
+	// Start of each cell's range in the sorted arrays. Has one extra entry at the end so a cell's range is [Start[i], Start[i + 1])
+	TArray<int32> CellStarts;
+
+	// Maps grid cell coordinate to cell index. Empty cells are not stored
+	TMap<FIntPoint, int32> CellLookup;
+
+	// Per point stamp of the last query that found it, used to skip duplicates when query locations overlap
+	mutable TArray<uint32> PointQueryStamps;
+	mutable uint32 QueryStamp;
+};
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnPointManifest.h"
+
+#include "SpawnPoint.h"
+
+#if WITH_EDITOR
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "NavigationSystem.h"
+#endif
+
+bool FSpawnPointManifest::IsValidFor(uint32 InClassSignature) const
+{
+	return Entries.Num() > 0 && ClassSignature == InClassSignature;
+}
+
+bool FSpawnPointManifest::IsValidForClass(int32 EntryIndex, int32 EnemyClassIndex) const
+{
+	if (!Entries.IsValidIndex(EntryIndex) || EnemyClassIndex < 0 || EnemyClassIndex >= MaxEnemyClasses)
+	{
+		return false;
+	}
+
+	return (Entries[EntryIndex].ValidClassMask & (uint64(1) << EnemyClassIndex)) != 0;
+}
+
+FTransform FSpawnPointManifest::GetSpawnTransform(int32 EntryIndex, int32 EnemyClassIndex) const
+{
+	const FSpawnPointManifestEntry& Entry = Entries[EntryIndex];
+	const float HalfHeight = ClassCapsuleHalfHeights.IsValidIndex(EnemyClassIndex) ? ClassCapsuleHalfHeights[EnemyClassIndex] : 0.0f;
+
+	return FTransform(FRotator(0.0f, Entry.Yaw, 0.0f), Entry.FloorLocation + FVector(0.0f, 0.0f, HalfHeight));
+}
+
+uint32 FSpawnPointManifest::ComputeClassSignature(const TArray<FSoftObjectPath>& EnemyClassPaths)
+{
+	uint32 Signature = GetTypeHash(EnemyClassPaths.Num());
+
+	for (const FSoftObjectPath& EnemyClassPath : EnemyClassPaths)
+	{
+		Signature = HashCombine(Signature, GetTypeHash(EnemyClassPath.ToString()));
+	}
+
+	return Signature;
+}
+
+#if WITH_EDITOR
+void FSpawnPointManifest::Build(UWorld* World, const TArray<ASpawnPoint*>& SpawnPoints, const TArray<UClass*>& EnemyClasses, const TArray<AActor*>& IgnoredActors)
+{
+	Entries.Reset();
+	ClassCapsuleHalfHeights.Reset();
+
+	if (!World)
+	{
+		return;
+	}
+
+	if (EnemyClasses.Num() > MaxEnemyClasses)
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "FSpawnPointManifest::Build: Too many enemy classes. Classes past 64 will never be valid");
+	}
+
+	// Capsule size of each class, from the class defaults. Actors that are not characters get the default character capsule
+	TArray<FCollisionShape> ClassCapsules;
+	TArray<FSoftObjectPath> EnemyClassPaths;
+
+	for (UClass* EnemyClass : EnemyClasses)
+	{
+		float CapsuleRadius = 34.0f;
+		float CapsuleHalfHeight = 88.0f;
+
+		const ACharacter* DefaultCharacter = EnemyClass ? Cast<ACharacter>(EnemyClass->GetDefaultObject()) : nullptr;
+		if (DefaultCharacter && DefaultCharacter->GetCapsuleComponent())
+		{
+			DefaultCharacter->GetCapsuleComponent()->GetScaledCapsuleSize(CapsuleRadius, CapsuleHalfHeight);
+		}
+
+		ClassCapsules.Add(FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight));
+		ClassCapsuleHalfHeights.Add(CapsuleHalfHeight);
+		EnemyClassPaths.Add(FSoftObjectPath(EnemyClass));
+	}
+
+	ClassSignature = ComputeClassSignature(EnemyClassPaths);
+
+	UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const bool bHasNavData = NavSystem && NavSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SpawnPointManifest), false);
+	QueryParams.AddIgnoredActors(IgnoredActors);
+	for (ASpawnPoint* SpawnPoint : SpawnPoints)
+	{
+		QueryParams.AddIgnoredActor(SpawnPoint);
+	}
+
+	// Small gap between the capsule and the floor so resting on the floor does not count as blocked
+	const float FloorClearance = 2.0f;
+
+	for (ASpawnPoint* SpawnPoint : SpawnPoints)
+	{
+		if (!IsValid(SpawnPoint))
+		{
+			continue;
+		}
+
+		FVector SpawnLocation = SpawnPoint->GetActorLocation();
+
+		// Spawn points that are off the navmesh are left out when the level has one, as enemies could not move from there
+		if (bHasNavData)
+		{
+			FNavLocation NavLocation;
+			if (!NavSystem->ProjectPointToNavigation(SpawnLocation, NavLocation, FVector(200.0f, 200.0f, 500.0f)))
+			{
+				continue;
+			}
+
+			SpawnLocation = NavLocation.Location;
+		}
+
+		FHitResult FloorHit;
+		if (!World->LineTraceSingleByChannel(FloorHit, SpawnLocation + FVector(0.0f, 0.0f, 100.0f), SpawnLocation - FVector(0.0f, 0.0f, 1000.0f), ECC_Visibility, QueryParams))
+		{
+			continue;
+		}
+
+		FSpawnPointManifestEntry Entry;
+		Entry.SpawnPoint = SpawnPoint;
+		Entry.FloorLocation = FloorHit.ImpactPoint + FVector(0.0f, 0.0f, FloorClearance);
+		Entry.Yaw = SpawnPoint->GetActorRotation().Yaw;
+
+		for (int32 ClassIndex = 0; ClassIndex < FMath::Min(ClassCapsules.Num(), MaxEnemyClasses); ClassIndex++)
+		{
+			const FVector CapsuleCenter = Entry.FloorLocation + FVector(0.0f, 0.0f, ClassCapsuleHalfHeights[ClassIndex]);
+			if (!World->OverlapBlockingTestByChannel(CapsuleCenter, FQuat::Identity, ECC_Pawn, ClassCapsules[ClassIndex], QueryParams))
+			{
+				Entry.ValidClassMask |= uint64(1) << ClassIndex;
+			}
+		}
+
+		if (Entry.ValidClassMask != 0)
+		{
+			Entries.Add(Entry);
+		}
+	}
+}
+#endif
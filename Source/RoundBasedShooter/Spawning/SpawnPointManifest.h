@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpawnPointManifest.generated.h"
+
+class ASpawnPoint;
+
+// A spawn point with its floor location already found and the enemy classes that fit there
+USTRUCT()
+struct FSpawnPointManifestEntry
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	ASpawnPoint* SpawnPoint;
+
+	// Spawn point location projected to the navmesh and then down to the floor
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	FVector FloorLocation;
+
+	// Yaw of the spawn point. Pitch and roll are never used for spawning enemies
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	float Yaw;
+
+	// Bit N is set if the capsule of enemy class N fits at the floor location without touching anything
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	uint64 ValidClassMask;
+
+	FSpawnPointManifestEntry()
+	{
+		SpawnPoint = nullptr;
+		FloorLocation = FVector::ZeroVector;
+		Yaw = 0.0f;
+		ValidClassMask = 0;
+	}
+};
+
+/**
+	Spawn points of a level validated ahead of time in the editor. The spawn manager loads these instead of scanning
+	the level and spawns enemies at the validated transforms without any collision fixup.
+	Enemy classes are referred to by their index in the spawn manager's basic then hard enemy class arrays.
+*/
+USTRUCT()
+struct FSpawnPointManifest
+{
+	GENERATED_BODY()
+
+public:
+
+	// Max number of enemy classes the class mask can hold
+	static constexpr int32 MaxEnemyClasses = 64;
+
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	TArray<FSpawnPointManifestEntry> Entries;
+
+	// Capsule half height of each enemy class. Used to lift the spawn location off the floor
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	TArray<float> ClassCapsuleHalfHeights;
+
+	// Signature of the enemy class list the manifest was built for. A mismatch means the manifest is stale
+	UPROPERTY(VisibleAnywhere, Category = "Spawning")
+	uint32 ClassSignature;
+
+	FSpawnPointManifest()
+	{
+		ClassSignature = 0;
+	}
+
+	// Returns true if the manifest has entries and was built for the given enemy class list
+	bool IsValidFor(uint32 InClassSignature) const;
+
+	// Returns true if the enemy class fits at the entry's spawn location
+	bool IsValidForClass(int32 EntryIndex, int32 EnemyClassIndex) const;
+
+	// Transform an enemy of the class should spawn at for the entry
+	FTransform GetSpawnTransform(int32 EntryIndex, int32 EnemyClassIndex) const;
+
+	// Builds a signature from the paths of the enemy classes, in order
+	static uint32 ComputeClassSignature(const TArray<FSoftObjectPath>& EnemyClassPaths);
+
+#if WITH_EDITOR
+	/**
+		Validates every spawn point against every enemy class and rebuilds the manifest. Editor only as it needs loaded classes,
+		a built navmesh and collision.
+		@param World - The world the spawn points are in
+		@param SpawnPoints - The spawn points to validate
+		@param EnemyClasses - The enemy classes to validate. Order must match the spawn manager's class indices
+		@param IgnoredActors - Actors the collision checks should ignore
+	*/
+	void Build(UWorld* World, const TArray<ASpawnPoint*>& SpawnPoints, const TArray<UClass*>& EnemyClasses, const TArray<AActor*>& IgnoredActors);
+#endif
+};
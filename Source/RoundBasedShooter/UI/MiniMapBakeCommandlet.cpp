@@ -0,0 +1,465 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MiniMapBakeCommandlet.h"
+
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "StaticMeshResources.h"
+#include "UObject/Package.h"
+
+UMiniMapBakeCommandlet::UMiniMapBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+
+	MaxHeight = MAX_flt;
+	TileResolution = 256;
+	NumZoomLevels = 4;
+	MapOrigin = FVector2D::ZeroVector;
+	MapSize = 0.0f;
+}
+
+int32 UMiniMapBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MiniMapBake: No map given. Use -Map=/Game/Maps/MapName"));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("TileResolution="), TileResolution);
+	FParse::Value(*Params, TEXT("ZoomLevels="), NumZoomLevels);
+	FParse::Value(*Params, TEXT("MaxHeight="), MaxHeight);
+	FParse::Value(*Params, TEXT("MapOriginX="), MapOrigin.X);
+	FParse::Value(*Params, TEXT("MapOriginY="), MapOrigin.Y);
+	FParse::Value(*Params, TEXT("MapSize="), MapSize);
+	const bool bWriteToSavedCache = FParse::Param(*Params, TEXT("SavedCache"));
+
+	TileResolution = FMath::Clamp(TileResolution, 64, 2048);
+	NumZoomLevels = FMath::Clamp(NumZoomLevels, 1, 10);
+
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MiniMapBake: Failed to load map %s"), *MapName);
+		return 1;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(false)
+			.RequiresHitProxies(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(false)
+			.SetTransactional(false));
+	}
+
+	// Streamed levels hold geometry too, and components only have world transforms once registered
+	World->LoadSecondaryLevels(true, nullptr);
+	World->UpdateWorldComponents(false, false);
+
+	if (MapSize <= 0.0f)
+	{
+		const FBox LevelBounds = ALevelBounds::CalculateLevelBounds(World->PersistentLevel);
+		if (!LevelBounds.IsValid)
+		{
+			UE_LOG(LogTemp, Error, TEXT("MiniMapBake: %s has no level bounds. Give the map area with -MapOriginX, -MapOriginY and -MapSize"), *MapName);
+			World->RemoveFromRoot();
+			return 1;
+		}
+
+		MapOrigin = FVector2D(LevelBounds.Min);
+		MapSize = FMath::Max(LevelBounds.GetSize().X, LevelBounds.GetSize().Y);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (ULevel* Level : World->GetLevels())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			if (!Actor)
+			{
+				continue;
+			}
+
+			TInlineComponentArray<UStaticMeshComponent*> StaticMeshComponents(Actor);
+			for (const UStaticMeshComponent* StaticMeshComponent : StaticMeshComponents)
+			{
+				GatherComponentTriangles(StaticMeshComponent);
+			}
+		}
+	}
+
+	World->RemoveFromRoot();
+	World->CleanupWorld();
+
+	const double GatheredTime = FPlatformTime::Seconds();
+
+	// Bin the triangles into the finest level tiles. Tile index is X * TilesPerSide + Y
+	const int32 FinestZoomLevel = NumZoomLevels - 1;
+	const int32 FinestTilesPerSide = 1 << FinestZoomLevel;
+	const float FinestTileSize = MapSize / FinestTilesPerSide;
+
+	TArray<TArray<int32>> TileTriangleIndices;
+	TileTriangleIndices.SetNum(FinestTilesPerSide * FinestTilesPerSide);
+
+	for (int32 TriangleIndex = 0; TriangleIndex < Triangles.Num(); TriangleIndex++)
+	{
+		const FBakeTriangle& Triangle = Triangles[TriangleIndex];
+		const FVector2D Min = (FVector2D(Triangle.A.ComponentMin(Triangle.B).ComponentMin(Triangle.C)) - MapOrigin) / FinestTileSize;
+		const FVector2D Max = (FVector2D(Triangle.A.ComponentMax(Triangle.B).ComponentMax(Triangle.C)) - MapOrigin) / FinestTileSize;
+
+		const int32 MinX = FMath::Max(FMath::FloorToInt(Min.X), 0);
+		const int32 MinY = FMath::Max(FMath::FloorToInt(Min.Y), 0);
+		const int32 MaxX = FMath::Min(FMath::FloorToInt(Max.X), FinestTilesPerSide - 1);
+		const int32 MaxY = FMath::Min(FMath::FloorToInt(Max.Y), FinestTilesPerSide - 1);
+
+		for (int32 TileX = MinX; TileX <= MaxX; TileX++)
+		{
+			for (int32 TileY = MinY; TileY <= MaxY; TileY++)
+			{
+				TileTriangleIndices[TileX * FinestTilesPerSide + TileY].Add(TriangleIndex);
+			}
+		}
+	}
+
+	// Tiles do not share pixels, so each one is rasterized on its own worker
+	TArray<TArray<float>> TileHeights;
+	TileHeights.SetNum(TileTriangleIndices.Num());
+
+	ParallelFor(TileTriangleIndices.Num(), [&](int32 TileIndex)
+	{
+		const FMiniMapTileKey Key(FinestZoomLevel, TileIndex / FinestTilesPerSide, TileIndex % FinestTilesPerSide);
+		RasterizeTile(Key, TileTriangleIndices[TileIndex], TileHeights[TileIndex]);
+	});
+
+	const double RasterizedTime = FPlatformTime::Seconds();
+
+	float MinHeight = MAX_flt;
+	float MaxDrawnHeight = -MAX_flt;
+	for (const TArray<float>& Heights : TileHeights)
+	{
+		for (float Height : Heights)
+		{
+			if (Height > -MAX_flt)
+			{
+				MinHeight = FMath::Min(MinHeight, Height);
+				MaxDrawnHeight = FMath::Max(MaxDrawnHeight, Height);
+			}
+		}
+	}
+
+	const float HeightRange = FMath::Max(MaxDrawnHeight - MinHeight, 1.0f);
+
+	// Brightness shows height and alpha shows occupancy, so empty space stays see through on the mini map
+	TArray<FMiniMapTileData> Tiles;
+	Tiles.SetNum(TileHeights.Num());
+
+	ParallelFor(TileHeights.Num(), [&](int32 TileIndex)
+	{
+		FMiniMapTileData& Tile = Tiles[TileIndex];
+		Tile.Resolution = TileResolution;
+		FMiniMapTileCache::GetTileBounds(MapOrigin, MapSize, FMiniMapTileKey(FinestZoomLevel, TileIndex / FinestTilesPerSide, TileIndex % FinestTilesPerSide), Tile.WorldMin, Tile.WorldSize);
+		Tile.Pixels.SetNumUninitialized(TileResolution * TileResolution);
+
+		const TArray<float>& Heights = TileHeights[TileIndex];
+		for (int32 PixelIndex = 0; PixelIndex < Heights.Num(); PixelIndex++)
+		{
+			if (Heights[PixelIndex] > -MAX_flt)
+			{
+				const uint8 Shade = (uint8)(64.0f + 191.0f * FMath::Clamp((Heights[PixelIndex] - MinHeight) / HeightRange, 0.0f, 1.0f));
+				Tile.Pixels[PixelIndex] = FColor(Shade, Shade, Shade, 255);
+			}
+			else
+			{
+				Tile.Pixels[PixelIndex] = FColor(0, 0, 0, 0);
+			}
+		}
+	});
+
+	TileHeights.Empty();
+
+	const FString LevelName = FPackageName::GetShortName(MapName);
+	int32 NumFailedSaves = 0;
+
+	for (int32 ZoomLevel = FinestZoomLevel; ZoomLevel >= 0; ZoomLevel--)
+	{
+		const int32 TilesPerSide = 1 << ZoomLevel;
+
+		// Build this level from the one below it
+		if (ZoomLevel < FinestZoomLevel)
+		{
+			const int32 ChildTilesPerSide = TilesPerSide * 2;
+
+			TArray<FMiniMapTileData> ParentTiles;
+			ParentTiles.SetNum(TilesPerSide * TilesPerSide);
+
+			ParallelFor(ParentTiles.Num(), [&](int32 TileIndex)
+			{
+				const int32 TileX = TileIndex / TilesPerSide;
+				const int32 TileY = TileIndex % TilesPerSide;
+
+				const FMiniMapTileData* Children[4] =
+				{
+					&Tiles[(TileX * 2) * ChildTilesPerSide + TileY * 2],
+					&Tiles[(TileX * 2) * ChildTilesPerSide + TileY * 2 + 1],
+					&Tiles[(TileX * 2 + 1) * ChildTilesPerSide + TileY * 2],
+					&Tiles[(TileX * 2 + 1) * ChildTilesPerSide + TileY * 2 + 1]
+				};
+
+				DownsampleTile(Children, ParentTiles[TileIndex]);
+				FMiniMapTileCache::GetTileBounds(MapOrigin, MapSize, FMiniMapTileKey(ZoomLevel, TileX, TileY), ParentTiles[TileIndex].WorldMin, ParentTiles[TileIndex].WorldSize);
+			});
+
+			Tiles = MoveTemp(ParentTiles);
+		}
+
+		ParallelFor(Tiles.Num(), [&](int32 TileIndex)
+		{
+			const FMiniMapTileKey Key(ZoomLevel, TileIndex / TilesPerSide, TileIndex % TilesPerSide);
+			const FString TilePath = bWriteToSavedCache ? FMiniMapTileCache::GetTilePath(LevelName, Key) : FMiniMapTileCache::GetBakedTilePath(LevelName, Key);
+
+			if (!FMiniMapTileCache::SaveTile(TilePath, Tiles[TileIndex]))
+			{
+				FPlatformAtomics::InterlockedIncrement(&NumFailedSaves);
+			}
+		});
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("MiniMapBake: %s, %d triangles, %d zoom levels of %dpx tiles. Gather %.2fs, rasterize %.2fs, total %.2fs"),
+		*MapName, Triangles.Num(), NumZoomLevels, TileResolution, GatheredTime - StartTime, RasterizedTime - GatheredTime, FPlatformTime::Seconds() - StartTime);
+
+	if (NumFailedSaves > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MiniMapBake: Failed to write %d tiles"), NumFailedSaves);
+		return 1;
+	}
+
+	return 0;
+#else
+	UE_LOG(LogTemp, Error, TEXT("MiniMapBake: Needs an editor build"));
+	return 1;
+#endif
+}
+
+void UMiniMapBakeCommandlet::GatherComponentTriangles(const UStaticMeshComponent* Component)
+{
+	if (Component->Mobility != EComponentMobility::Static || !Component->IsCollisionEnabled())
+	{
+		return;
+	}
+
+	const UStaticMesh* StaticMesh = Component->GetStaticMesh();
+	const FStaticMeshRenderData* RenderData = StaticMesh ? StaticMesh->GetRenderData() : nullptr;
+	if (!RenderData || RenderData->LODResources.Num() == 0)
+	{
+		return;
+	}
+
+	// The LOD complex collision is built from, which is usually cheaper than LOD 0
+	const FStaticMeshLODResources& LODResources = RenderData->LODResources[FMath::Clamp(StaticMesh->LODForCollision, 0, RenderData->LODResources.Num() - 1)];
+	const FPositionVertexBuffer& Positions = LODResources.VertexBuffers.PositionVertexBuffer;
+
+	TArray<uint32> Indices;
+	LODResources.IndexBuffer.GetCopy(Indices);
+
+	TArray<FTransform> Transforms;
+	const UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Component);
+	if (InstancedComponent)
+	{
+		Transforms.SetNum(InstancedComponent->GetInstanceCount());
+		for (int32 InstanceIndex = 0; InstanceIndex < Transforms.Num(); InstanceIndex++)
+		{
+			InstancedComponent->GetInstanceTransform(InstanceIndex, Transforms[InstanceIndex], true);
+		}
+	}
+	else
+	{
+		Transforms.Add(Component->GetComponentTransform());
+	}
+
+	for (const FTransform& Transform : Transforms)
+	{
+		for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+		{
+			FBakeTriangle Triangle;
+			Triangle.A = Transform.TransformPosition(Positions.VertexPosition(Indices[Index]));
+			Triangle.B = Transform.TransformPosition(Positions.VertexPosition(Indices[Index + 1]));
+			Triangle.C = Transform.TransformPosition(Positions.VertexPosition(Indices[Index + 2]));
+
+			if (FMath::Min3(Triangle.A.Z, Triangle.B.Z, Triangle.C.Z) <= MaxHeight)
+			{
+				Triangles.Add(Triangle);
+			}
+		}
+	}
+}
+
+void UMiniMapBakeCommandlet::RasterizeTile(const FMiniMapTileKey& Key, const TArray<int32>& TriangleIndices, TArray<float>& OutHeights) const
+{
+	OutHeights.Init(-MAX_flt, TileResolution * TileResolution);
+
+	FVector2D TileMin;
+	float TileSize;
+	FMiniMapTileCache::GetTileBounds(MapOrigin, MapSize, Key, TileMin, TileSize);
+
+	const float PixelsPerUnit = TileResolution / TileSize;
+	const float TileMaxX = TileMin.X + TileSize;
+
+	// Pixel X follows world Y and pixel Y runs down from the tile's max world X, like the scene capture
+	auto ToPixel = [&](const FVector& WorldLocation)
+	{
+		return FVector((WorldLocation.Y - TileMin.Y) * PixelsPerUnit, (TileMaxX - WorldLocation.X) * PixelsPerUnit, WorldLocation.Z);
+	};
+
+	for (int32 TriangleIndex : TriangleIndices)
+	{
+		const FBakeTriangle& Triangle = Triangles[TriangleIndex];
+		const FVector A = ToPixel(Triangle.A);
+		const FVector B = ToPixel(Triangle.B);
+		const FVector C = ToPixel(Triangle.C);
+
+		// Twice the area in pixels. Under a pixel it can slip between pixel centers
+		const float DoubleArea = (B.X - A.X) * (C.Y - A.Y) - (C.X - A.X) * (B.Y - A.Y);
+		if (FMath::Abs(DoubleArea) < 1.0f)
+		{
+			RasterizeEdge(A, B, C, OutHeights);
+		}
+		else
+		{
+			RasterizeTriangle(A, B, C, OutHeights);
+		}
+	}
+}
+
+void UMiniMapBakeCommandlet::RasterizeTriangle(const FVector& A, const FVector& B, const FVector& C, TArray<float>& OutHeights) const
+{
+	// Height across the triangle as a plane over pixel X and Y
+	const float DoubleArea = (B.X - A.X) * (C.Y - A.Y) - (C.X - A.X) * (B.Y - A.Y);
+	const float HeightPerX = ((B.Z - A.Z) * (C.Y - A.Y) - (C.Z - A.Z) * (B.Y - A.Y)) / DoubleArea;
+	const float HeightPerY = ((C.Z - A.Z) * (B.X - A.X) - (B.Z - A.Z) * (C.X - A.X)) / DoubleArea;
+
+	const FVector Vertices[3] = { A, B, C };
+
+	const int32 FirstRow = FMath::Max(FMath::CeilToInt(FMath::Min3(A.Y, B.Y, C.Y) - 0.5f), 0);
+	const int32 LastRow = FMath::Min(FMath::FloorToInt(FMath::Max3(A.Y, B.Y, C.Y) - 0.5f), TileResolution - 1);
+
+	for (int32 Row = FirstRow; Row <= LastRow; Row++)
+	{
+		const float RowCenter = Row + 0.5f;
+
+		// Where the row's center line crosses the triangle's edges
+		float SpanStart = MAX_flt;
+		float SpanEnd = -MAX_flt;
+
+		for (int32 EdgeIndex = 0; EdgeIndex < 3; EdgeIndex++)
+		{
+			const FVector& EdgeStart = Vertices[EdgeIndex];
+			const FVector& EdgeEnd = Vertices[(EdgeIndex + 1) % 3];
+
+			if ((RowCenter < EdgeStart.Y && RowCenter < EdgeEnd.Y) || (RowCenter > EdgeStart.Y && RowCenter > EdgeEnd.Y) || EdgeStart.Y == EdgeEnd.Y)
+			{
+				continue;
+			}
+
+			const float CrossingX = EdgeStart.X + (RowCenter - EdgeStart.Y) * (EdgeEnd.X - EdgeStart.X) / (EdgeEnd.Y - EdgeStart.Y);
+			SpanStart = FMath::Min(SpanStart, CrossingX);
+			SpanEnd = FMath::Max(SpanEnd, CrossingX);
+		}
+
+		const int32 FirstColumn = FMath::Max(FMath::CeilToInt(SpanStart - 0.5f), 0);
+		const int32 LastColumn = FMath::Min(FMath::FloorToInt(SpanEnd - 0.5f), TileResolution - 1);
+
+		float* RowHeights = OutHeights.GetData() + Row * TileResolution;
+		float Height = A.Z + HeightPerX * (FirstColumn + 0.5f - A.X) + HeightPerY * (RowCenter - A.Y);
+
+		for (int32 Column = FirstColumn; Column <= LastColumn; Column++)
+		{
+			RowHeights[Column] = FMath::Max(RowHeights[Column], Height);
+			Height += HeightPerX;
+		}
+	}
+}
+
+void UMiniMapBakeCommandlet::RasterizeEdge(const FVector& A, const FVector& B, const FVector& C, TArray<float>& OutHeights) const
+{
+	const FVector* Start = &A;
+	const FVector* End = &B;
+
+	if (FVector2D::DistSquared(FVector2D(B), FVector2D(C)) > FVector2D::DistSquared(FVector2D(*Start), FVector2D(*End)))
+	{
+		Start = &B;
+		End = &C;
+	}
+
+	if (FVector2D::DistSquared(FVector2D(C), FVector2D(A)) > FVector2D::DistSquared(FVector2D(*Start), FVector2D(*End)))
+	{
+		Start = &C;
+		End = &A;
+	}
+
+	const float Height = FMath::Max3(A.Z, B.Z, C.Z);
+	const int32 NumSteps = FMath::CeilToInt(FVector2D::Distance(FVector2D(*Start), FVector2D(*End))) + 1;
+
+	for (int32 Step = 0; Step <= NumSteps; Step++)
+	{
+		const FVector2D Point = FMath::Lerp(FVector2D(*Start), FVector2D(*End), (float)Step / NumSteps);
+		const int32 Column = FMath::FloorToInt(Point.X);
+		const int32 Row = FMath::FloorToInt(Point.Y);
+
+		if (Column >= 0 && Row >= 0 && Column < TileResolution && Row < TileResolution)
+		{
+			float& PixelHeight = OutHeights[Row * TileResolution + Column];
+			PixelHeight = FMath::Max(PixelHeight, Height);
+		}
+	}
+}
+
+void UMiniMapBakeCommandlet::DownsampleTile(const FMiniMapTileData* Children[4], FMiniMapTileData& OutTile) const
+{
+	OutTile.Resolution = TileResolution;
+	OutTile.Pixels.SetNumUninitialized(TileResolution * TileResolution);
+
+	const int32 HalfResolution = TileResolution / 2;
+
+	for (int32 Row = 0; Row < TileResolution; Row++)
+	{
+		for (int32 Column = 0; Column < TileResolution; Column++)
+		{
+			// Children are ordered by X then Y, and rows run down from max X, so the top half comes from the upper X children
+			const FMiniMapTileData* Child = Children[(Row < HalfResolution ? 2 : 0) + (Column < HalfResolution ? 0 : 1)];
+			const int32 ChildRow = (Row % HalfResolution) * 2;
+			const int32 ChildColumn = (Column % HalfResolution) * 2;
+
+			uint32 Sum[4] = { 0, 0, 0, 0 };
+			for (int32 SampleIndex = 0; SampleIndex < 4; SampleIndex++)
+			{
+				const FColor& Sample = Child->Pixels[(ChildRow + SampleIndex / 2) * TileResolution + ChildColumn + SampleIndex % 2];
+				Sum[0] += Sample.R;
+				Sum[1] += Sample.G;
+				Sum[2] += Sample.B;
+				Sum[3] += Sample.A;
+			}
+
+			OutTile.Pixels[Row * TileResolution + Column] = FColor(Sum[0] / 4, Sum[1] / 4, Sum[2] / 4, Sum[3] / 4);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MiniMapTileCache.h"
+#include "MiniMapBakeCommandlet.generated.h"
+
+class UStaticMeshComponent;
+
+/**
+	Bakes the mini map tiles of a level on the CPU, so build machines without a GPU can make them as part of the cook.
+	Loads the level, collects the collision LOD triangles of every static mesh with collision, rasterizes them top down
+	into a height and occupancy image per tile in parallel, then builds the coarser zoom levels from the finest one.
+	Tiles are written in the format AMiniMapGenerator reads, to Content/MiniMap/<Level>. Add Content/MiniMap to the
+	additional non asset directories to package so the tiles are staged.
+
+	UE4Editor-Cmd.exe RoundBasedShooter -run=MiniMapBake -Map=/Game/Maps/Arena [-TileResolution=256] [-ZoomLevels=4]
+		[-MaxHeight=2000] [-MapOriginX=0 -MapOriginY=0 -MapSize=10000] [-SavedCache]
+
+	Map bounds default to the level bounds, the same as the generator's, and the tile settings must match the generator's
+	for the tiles to be used. -SavedCache writes to Saved/MiniMapCache instead, for testing without restaging.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UMiniMapBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UMiniMapBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	struct FBakeTriangle
+	{
+		FVector A;
+		FVector B;
+		FVector C;
+	};
+
+	// Adds the world space triangles of the component's collision LOD, once per instance for instanced meshes
+	void GatherComponentTriangles(const UStaticMeshComponent* Component);
+
+	/**
+		Rasterizes the triangles binned to a finest level tile, keeping the highest surface under every pixel center.
+		@param OutHeights - TileResolution * TileResolution heights, -MAX_flt where nothing was drawn
+	*/
+	void RasterizeTile(const FMiniMapTileKey& Key, const TArray<int32>& TriangleIndices, TArray<float>& OutHeights) const;
+
+	// Scanline converts one triangle given in tile pixel coordinates, with world Z kept in Z
+	void RasterizeTriangle(const FVector& A, const FVector& B, const FVector& C, TArray<float>& OutHeights) const;
+
+	// Draws a triangle too thin to cover pixel centers, such as a wall seen from above, as its longest edge at its top height
+	void RasterizeEdge(const FVector& A, const FVector& B, const FVector& C, TArray<float>& OutHeights) const;
+
+	// Builds a tile from the four tiles under it, halving their resolution
+	void DownsampleTile(const FMiniMapTileData* Children[4], FMiniMapTileData& OutTile) const;
+
+	// Triangles above this world Z, such as roofs, are left out. No limit by default
+	float MaxHeight;
+
+	int32 TileResolution;
+
+	int32 NumZoomLevels;
+
+	FVector2D MapOrigin;
+
+	float MapSize;
+
+	TArray<FBakeTriangle> Triangles;
+};
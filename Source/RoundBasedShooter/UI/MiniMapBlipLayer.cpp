@@ -0,0 +1,289 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MiniMapBlipLayer.h"
+
+#include "EngineUtils.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Rendering/DrawElements.h"
+#include "Rendering/SlateRenderer.h"
+#include "Styling/CoreStyle.h"
+#include "../Characters/GameCharacterBase.h"
+#include "../Spawning/EnemyRegistrySubsystem.h"
+#include "../Spawning/SpawnPoint.h"
+
+void SMiniMapBlipLayer::Construct(const FArguments& InArgs)
+{
+	OnGatherBlips = InArgs._OnGatherBlips;
+	ViewCenter = FVector2D::ZeroVector;
+	ViewWorldWidth = 5000.0f;
+
+	SetBrush(InArgs._Brush);
+	SetUpdateRate(InArgs._UpdateRate);
+}
+
+void SMiniMapBlipLayer::SetView(const FVector2D& InViewCenter, float InViewWorldWidth)
+{
+	ViewCenter = InViewCenter;
+	ViewWorldWidth = InViewWorldWidth;
+}
+
+void SMiniMapBlipLayer::SetBlipStyle(EMiniMapBlipType Type, const FMiniMapBlipStyle& Style)
+{
+	if (Type < EMiniMapBlipType::Count)
+	{
+		BlipStyles[(int32)Type] = Style;
+	}
+}
+
+void SMiniMapBlipLayer::SetBrush(const FSlateBrush* InBrush)
+{
+	Brush = InBrush ? InBrush : FCoreStyle::Get().GetBrush("GenericWhiteBox");
+}
+
+void SMiniMapBlipLayer::SetUpdateRate(float InUpdateRate)
+{
+	UpdateRate = FMath::Max(InUpdateRate, 1.0f);
+
+	if (UpdateTimerHandle.IsValid())
+	{
+		UnRegisterActiveTimer(UpdateTimerHandle.ToSharedRef());
+	}
+
+	UpdateTimerHandle = RegisterActiveTimer(1.0f / UpdateRate, FWidgetActiveTimerDelegate::CreateSP(this, &SMiniMapBlipLayer::UpdateBlips));
+}
+
+void SMiniMapBlipLayer::GatherBlips()
+{
+	Blips.Reset();
+	OnGatherBlips.ExecuteIfBound(Blips);
+}
+
+EActiveTimerReturnType SMiniMapBlipLayer::UpdateBlips(double InCurrentTime, float InDeltaTime)
+{
+	GatherBlips();
+	return EActiveTimerReturnType::Continue;
+}
+
+int32 SMiniMapBlipLayer::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+	int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_MiniMapBlipLayer_Paint);
+
+	const int32 NumBlips = Blips.Locations.Num();
+	if (NumBlips == 0 || ViewWorldWidth <= 0.0f)
+	{
+		return LayerId;
+	}
+
+	const FVector2D LocalSize = AllottedGeometry.GetLocalSize();
+	const FVector2D LocalCenter = LocalSize * 0.5f;
+	const FSlateRenderTransform& RenderTransform = AllottedGeometry.GetAccumulatedRenderTransform();
+	const float WorldToLocal = LocalSize.X / ViewWorldWidth;
+
+	FColor BlipColors[(int32)EMiniMapBlipType::Count];
+	float BlipHalfSizes[(int32)EMiniMapBlipType::Count];
+	for (int32 TypeIndex = 0; TypeIndex < (int32)EMiniMapBlipType::Count; TypeIndex++)
+	{
+		BlipColors[TypeIndex] = (BlipStyles[TypeIndex].Color * InWidgetStyle.GetColorAndOpacityTint()).ToFColor(true);
+		BlipHalfSizes[TypeIndex] = BlipStyles[TypeIndex].bVisible ? BlipStyles[TypeIndex].Size * 0.5f : 0.0f;
+	}
+
+	Vertices.Reset(NumBlips * 4);
+	Indices.Reset(NumBlips * 6);
+
+	for (int32 BlipIndex = 0; BlipIndex < NumBlips; BlipIndex++)
+	{
+		const int32 TypeIndex = (int32)Blips.Types[BlipIndex];
+		const float HalfSize = BlipHalfSizes[TypeIndex];
+
+		// World +X is up and world +Y is right
+		const FVector2D WorldOffset = Blips.Locations[BlipIndex] - ViewCenter;
+		const FVector2D Position = LocalCenter + FVector2D(WorldOffset.Y, -WorldOffset.X) * WorldToLocal;
+
+		if (HalfSize <= 0.0f || Position.X < -HalfSize || Position.Y < -HalfSize || Position.X > LocalSize.X + HalfSize || Position.Y > LocalSize.Y + HalfSize)
+		{
+			continue;
+		}
+
+		const FColor& Color = BlipColors[TypeIndex];
+		const SlateIndex FirstVertex = (SlateIndex)Vertices.Num();
+
+		Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(RenderTransform, Position + FVector2D(-HalfSize, -HalfSize), FVector2D(0.0f, 0.0f), FVector2D(0.0f, 0.0f), Color));
+		Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(RenderTransform, Position + FVector2D(HalfSize, -HalfSize), FVector2D(1.0f, 0.0f), FVector2D(1.0f, 0.0f), Color));
+		Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(RenderTransform, Position + FVector2D(HalfSize, HalfSize), FVector2D(1.0f, 1.0f), FVector2D(1.0f, 1.0f), Color));
+		Vertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(RenderTransform, Position + FVector2D(-HalfSize, HalfSize), FVector2D(0.0f, 1.0f), FVector2D(0.0f, 1.0f), Color));
+
+		Indices.Add(FirstVertex);
+		Indices.Add(FirstVertex + 1);
+		Indices.Add(FirstVertex + 2);
+		Indices.Add(FirstVertex);
+		Indices.Add(FirstVertex + 2);
+		Indices.Add(FirstVertex + 3);
+	}
+
+	if (Vertices.Num() == 0)
+	{
+		return LayerId;
+	}
+
+	const FSlateResourceHandle ResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*Brush);
+	FSlateDrawElement::MakeCustomVerts(OutDrawElements, LayerId, ResourceHandle, Vertices, Indices, nullptr, 0, 0);
+
+	return LayerId;
+}
+
+FVector2D SMiniMapBlipLayer::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D(256.0f, 256.0f);
+}
+
+UMiniMapBlipLayer::UMiniMapBlipLayer()
+{
+	EnemyBlipStyle.Color = FLinearColor::Red;
+	SpawnPointBlipStyle.Color = FLinearColor(1.0f, 0.5f, 0.0f, 0.5f);
+	SpawnPointBlipStyle.Size = 4.0f;
+	SpawnPointBlipStyle.bVisible = false;
+	PickupBlipStyle.Color = FLinearColor::Green;
+	UpdateRateHz = 10.0f;
+
+	ViewCenter = FVector2D::ZeroVector;
+	ViewWorldWidth = 5000.0f;
+	bFoundSpawnPoints = false;
+}
+
+void UMiniMapBlipLayer::SetView(const FVector2D& NewViewCenter, float NewViewWorldWidth)
+{
+	ViewCenter = NewViewCenter;
+	ViewWorldWidth = NewViewWorldWidth;
+
+	if (BlipLayer.IsValid())
+	{
+		BlipLayer->SetView(ViewCenter, ViewWorldWidth);
+	}
+}
+
+void UMiniMapBlipLayer::TrackActor(AActor* Actor, EMiniMapBlipType Type)
+{
+	if (!IsValid(Actor) || Type >= EMiniMapBlipType::Count)
+	{
+		return;
+	}
+
+	for (TPair<TWeakObjectPtr<AActor>, EMiniMapBlipType>& TrackedActor : TrackedActors)
+	{
+		if (TrackedActor.Key == Actor)
+		{
+			TrackedActor.Value = Type;
+			return;
+		}
+	}
+
+	TrackedActors.Emplace(Actor, Type);
+}
+
+void UMiniMapBlipLayer::UntrackActor(AActor* Actor)
+{
+	TrackedActors.RemoveAllSwap([Actor](const TPair<TWeakObjectPtr<AActor>, EMiniMapBlipType>& TrackedActor)
+	{
+		return TrackedActor.Key == Actor;
+	}, false);
+}
+
+void UMiniMapBlipLayer::SynchronizeProperties()
+{
+	Super::SynchronizeProperties();
+
+	if (!BlipLayer.IsValid())
+	{
+		return;
+	}
+
+	// An empty brush has nothing to draw, so fall back to a plain square
+	BlipLayer->SetBrush(BlipBrush.GetResourceObject() ? &BlipBrush : nullptr);
+	BlipLayer->SetBlipStyle(EMiniMapBlipType::Enemy, EnemyBlipStyle);
+	BlipLayer->SetBlipStyle(EMiniMapBlipType::SpawnPoint, SpawnPointBlipStyle);
+	BlipLayer->SetBlipStyle(EMiniMapBlipType::Pickup, PickupBlipStyle);
+	BlipLayer->SetUpdateRate(UpdateRateHz);
+	BlipLayer->SetView(ViewCenter, ViewWorldWidth);
+	BlipLayer->GatherBlips();
+}
+
+void UMiniMapBlipLayer::ReleaseSlateResources(bool bReleaseChildren)
+{
+	Super::ReleaseSlateResources(bReleaseChildren);
+
+	BlipLayer.Reset();
+}
+
+TSharedRef<SWidget> UMiniMapBlipLayer::RebuildWidget()
+{
+	BlipLayer = SNew(SMiniMapBlipLayer)
+		.UpdateRate(UpdateRateHz)
+		.OnGatherBlips(FOnGatherMiniMapBlips::CreateUObject(this, &UMiniMapBlipLayer::GatherBlips));
+
+	return BlipLayer.ToSharedRef();
+}
+
+void UMiniMapBlipLayer::GatherBlips(FMiniMapBlipBuffer& OutBlips)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_MiniMapBlipLayer_Gather);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	if (EnemyBlipStyle.bVisible)
+	{
+		const UEnemyRegistrySubsystem* EnemyRegistry = World->GetSubsystem<UEnemyRegistrySubsystem>();
+		if (EnemyRegistry)
+		{
+			for (const AActor* Enemy : EnemyRegistry->GetEnemies())
+			{
+				const AGameCharacterBase* GameCharacter = Cast<AGameCharacterBase>(Enemy);
+				if (IsValid(Enemy) && !Enemy->IsHidden() && (!GameCharacter || GameCharacter->bIsAlive))
+				{
+					OutBlips.Add(Enemy->GetActorLocation(), EMiniMapBlipType::Enemy);
+				}
+			}
+		}
+	}
+
+	if (SpawnPointBlipStyle.bVisible)
+	{
+		if (!bFoundSpawnPoints)
+		{
+			for (TActorIterator<ASpawnPoint> SpawnPointIt(World); SpawnPointIt; ++SpawnPointIt)
+			{
+				SpawnPointLocations.Add(SpawnPointIt->GetActorLocation());
+			}
+
+			bFoundSpawnPoints = true;
+		}
+
+		for (const FVector& SpawnPointLocation : SpawnPointLocations)
+		{
+			OutBlips.Add(SpawnPointLocation, EMiniMapBlipType::SpawnPoint);
+		}
+	}
+
+	for (int32 TrackedIndex = TrackedActors.Num() - 1; TrackedIndex >= 0; TrackedIndex--)
+	{
+		const AActor* TrackedActor = TrackedActors[TrackedIndex].Key.Get();
+		if (!TrackedActor)
+		{
+			TrackedActors.RemoveAtSwap(TrackedIndex, 1, false);
+			continue;
+		}
+
+		const EMiniMapBlipType Type = TrackedActors[TrackedIndex].Value;
+		const bool bTypeVisible = Type == EMiniMapBlipType::Enemy ? EnemyBlipStyle.bVisible : Type == EMiniMapBlipType::SpawnPoint ? SpawnPointBlipStyle.bVisible : PickupBlipStyle.bVisible;
+
+		if (bTypeVisible && !TrackedActor->IsHidden())
+		{
+			OutBlips.Add(TrackedActor->GetActorLocation(), Type);
+		}
+	}
+}
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/Widget.h"
+#include "Styling/SlateBrush.h"
+#include "Widgets/SLeafWidget.h"
+#include "MiniMapBlipLayer.generated.h"
+
+// What a mini map blip stands for
+UENUM(BlueprintType)
+enum class EMiniMapBlipType : uint8
+{
+	Enemy UMETA(DisplayName = "Enemy"),
+	SpawnPoint UMETA(DisplayName = "Spawn Point"),
+	Pickup UMETA(DisplayName = "Pickup"),
+
+	Count UMETA(Hidden)
+};
+
+// Look of one type of mini map blip
+USTRUCT(BlueprintType)
+struct FMiniMapBlipStyle
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mini Map")
+	FLinearColor Color;
+
+	// Width and height of the blip in slate units
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mini Map", meta = (ClampMin = "1.0"))
+	float Size;
+
+	// Blips of this type are gathered and drawn
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mini Map")
+	bool bVisible;
+
+	FMiniMapBlipStyle()
+	{
+		Color = FLinearColor::White;
+		Size = 6.0f;
+		bVisible = true;
+	}
+};
+
+// World locations of every blip, gathered at the update rate. Locations and types are packed in separate arrays so paint is a straight walk
+struct FMiniMapBlipBuffer
+{
+	TArray<FVector2D> Locations;
+	TArray<EMiniMapBlipType> Types;
+
+	void Reset()
+	{
+		Locations.Reset();
+		Types.Reset();
+	}
+
+	void Add(const FVector& Location, EMiniMapBlipType Type)
+	{
+		Locations.Add(FVector2D(Location));
+		Types.Add(Type);
+	}
+};
+
+DECLARE_DELEGATE_OneParam(FOnGatherMiniMapBlips, FMiniMapBlipBuffer&);
+
+/**
+	Draws every blip in a single custom verts element, one textured quad per blip, so the cost does not grow with widgets.
+	Blip locations are gathered through OnGatherBlips at UpdateRate and projected into the widget every paint.
+*/
+class ROUNDBASEDSHOOTER_API SMiniMapBlipLayer : public SLeafWidget
+{
+public:
+
+	SLATE_BEGIN_ARGS(SMiniMapBlipLayer)
+		: _Brush(nullptr)
+		, _UpdateRate(10.0f)
+	{}
+		// Image drawn for every blip, tinted with the blip color
+		SLATE_ARGUMENT(const FSlateBrush*, Brush)
+
+		// Gathers per second
+		SLATE_ARGUMENT(float, UpdateRate)
+
+		SLATE_EVENT(FOnGatherMiniMapBlips, OnGatherBlips)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	/**
+		Sets the part of the world the layer shows. World +X is up and world +Y is right, like the mini map capture.
+		@param InViewCenter - World XY at the center of the widget
+		@param InViewWorldWidth - World width shown across the widget
+	*/
+	void SetView(const FVector2D& InViewCenter, float InViewWorldWidth);
+
+	void SetBlipStyle(EMiniMapBlipType Type, const FMiniMapBlipStyle& Style);
+
+	void SetBrush(const FSlateBrush* InBrush);
+
+	// Restarts the gather timer at the new rate
+	void SetUpdateRate(float InUpdateRate);
+
+	// Gathers the blips right away instead of waiting for the timer
+	void GatherBlips();
+
+	// SWidget
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+		int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+
+	EActiveTimerReturnType UpdateBlips(double InCurrentTime, float InDeltaTime);
+
+	const FSlateBrush* Brush;
+
+	float UpdateRate;
+
+	FOnGatherMiniMapBlips OnGatherBlips;
+
+	TSharedPtr<FActiveTimerHandle> UpdateTimerHandle;
+
+	FVector2D ViewCenter;
+
+	float ViewWorldWidth;
+
+	FMiniMapBlipStyle BlipStyles[(int32)EMiniMapBlipType::Count];
+
+	FMiniMapBlipBuffer Blips;
+
+	// Kept between paints so building the quads does not allocate
+	mutable TArray<FSlateVertex> Vertices;
+	mutable TArray<SlateIndex> Indices;
+};
+
+/**
+	Mini map overlay showing enemies, spawn points and pickups as blips drawn in one batch.
+	Enemies come from the enemy registry the spawn manager fills, spawn points are found once, and pickups are added with TrackActor.
+*/
+UCLASS()
+class ROUNDBASEDSHOOTER_API UMiniMapBlipLayer : public UWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	UMiniMapBlipLayer();
+
+	/**
+		Sets the part of the world the layer shows. Use the same view as the mini map under it.
+		@param NewViewCenter - World XY at the center of the widget
+		@param NewViewWorldWidth - World width shown across the widget
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Mini Map")
+	void SetView(const FVector2D& NewViewCenter, float NewViewWorldWidth);
+
+	// Shows the actor as a blip until it is destroyed or untracked. For pickups and anything else not in the enemy registry
+	UFUNCTION(BlueprintCallable, Category = "Mini Map")
+	void TrackActor(AActor* Actor, EMiniMapBlipType Type = EMiniMapBlipType::Pickup);
+
+	UFUNCTION(BlueprintCallable, Category = "Mini Map")
+	void UntrackActor(AActor* Actor);
+
+	// Image drawn for every blip, tinted with the blip color
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush BlipBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FMiniMapBlipStyle EnemyBlipStyle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FMiniMapBlipStyle SpawnPointBlipStyle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FMiniMapBlipStyle PickupBlipStyle;
+
+	// Times per second blip locations are gathered. Blips are still drawn every frame at the last gathered locations
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mini Map", meta = (ClampMin = "1.0", ClampMax = "60.0"))
+	float UpdateRateHz;
+
+	// UWidget
+	virtual void SynchronizeProperties() override;
+	virtual void ReleaseSlateResources(bool bReleaseChildren) override;
+
+protected:
+
+	// UWidget
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+
+private:
+
+	// Fills the buffer with the locations of every visible blip
+	void GatherBlips(FMiniMapBlipBuffer& OutBlips);
+
+	TSharedPtr<SMiniMapBlipLayer> BlipLayer;
+
+	FVector2D ViewCenter;
+
+	float ViewWorldWidth;
+
+	// Spawn points never move, so they are found once
+	TArray<FVector> SpawnPointLocations;
+
+	bool bFoundSpawnPoints;
+
+	TArray<TPair<TWeakObjectPtr<AActor>, EMiniMapBlipType>> TrackedActors;
+};
@@ -3,27 +3,596 @@
 
 #include "MiniMapGenerator.h"
 
+#include "Async/Async.h"
 #include "Components/SceneCaptureComponent2D.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/Texture2D.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
 
 AMiniMapGenerator::AMiniMapGenerator()
 {
-	PrimaryActorTick.bCanEverTick = false;
+	// Only ticks while a capture is due. See CaptureNow
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	CaptureMode = EMiniMapCaptureMode::Once;
+	CaptureRateHz = 2.0f;
+	RenderTargetResolution = 512;
+	bCaptureRequested = false;
+
+	bUseTiles = false;
+	MapOrigin = FVector2D::ZeroVector;
+	MapSize = 0.0f;
+	TileResolution = 256;
+	NumZoomLevels = 4;
+	TileMargin = 1;
+	MaxTileCapturesPerFrame = 1;
+	MaxTileLoadsInFlight = 4;
+	bUseDiskCache = true;
+	MaxResidentTiles = 0;
+	TileCaptureHeight = 0.0f;
+	bIgnoreDiskCache = false;
 
 	MiniMapCaptureComponent = CreateDefaultSubobject<USceneCaptureComponent2D>("MiniMapCaptureComponent");
 	MiniMapCaptureComponent->SetRelativeLocationAndRotation(FVector(0, 0, 5000), FRotator(-90.0f, 0, 0));
 	MiniMapCaptureComponent->ProjectionType = ECameraProjectionMode::Orthographic;
 	MiniMapCaptureComponent->OrthoWidth = 5000;
 	MiniMapCaptureComponent->CaptureSource = ESceneCaptureSource::SCS_BaseColor;
+	MiniMapCaptureComponent->bCaptureEveryFrame = false;
+	MiniMapCaptureComponent->bCaptureOnMovement = false;
 
 	MiniMapCaptureComponent->SetupAttachment(RootComponent);
+
+	TrimShowFlags();
 }
 
 void AMiniMapGenerator::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (bUseTiles)
+	{
+		InitializeTiles();
+
+		if (CaptureMode == EMiniMapCaptureMode::OnDemand)
+		{
+			LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &AMiniMapGenerator::OnLevelsChanged);
+			LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &AMiniMapGenerator::OnLevelsChanged);
+		}
+
+		return;
+	}
+
+	if (!MiniMapCaptureComponent->TextureTarget)
+	{
+		UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(this);
+		RenderTarget->RenderTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8;
+		RenderTarget->InitAutoFormat(RenderTargetResolution, RenderTargetResolution);
+		RenderTarget->UpdateResourceImmediate(true);
+		MiniMapCaptureComponent->TextureTarget = RenderTarget;
+	}
+
+	switch (CaptureMode)
+	{
+	case EMiniMapCaptureMode::EveryFrame:
+		MiniMapCaptureComponent->bCaptureEveryFrame = true;
+		break;
+
+	case EMiniMapCaptureMode::OnDemand:
+		LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &AMiniMapGenerator::OnLevelsChanged);
+		LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &AMiniMapGenerator::OnLevelsChanged);
+		RequestCapture();
+		break;
+
+	case EMiniMapCaptureMode::TimeSliced:
+		SetActorTickInterval(1.0f / FMath::Max(CaptureRateHz, 0.1f));
+		SetActorTickEnabled(true);
+		break;
+
+	default:
+		RequestCapture();
+		break;
+	}
+}
+
+void AMiniMapGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	// Reads still in flight hold their own tile data, so they can be left to finish on their own
+	PendingTileLoads.Empty();
+
+	Super::EndPlay(EndPlayReason);
 }
 
+void AMiniMapGenerator::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
 
+	if (bUseTiles)
+	{
+		UpdateTileStreaming();
+		return;
+	}
+
+	if (bCaptureRequested || CaptureMode == EMiniMapCaptureMode::TimeSliced)
+	{
+		CaptureNow();
+	}
+}
+
+void AMiniMapGenerator::RequestCapture()
+{
+	if (bUseTiles)
+	{
+		for (const TPair<FMiniMapTileKey, FResidentTile>& ResidentTile : ResidentTiles)
+		{
+			FreeTileTextureIndices.Add(ResidentTile.Value.TextureIndex);
+		}
+
+		ResidentTiles.Empty();
+		PendingTileLoads.Empty();
+		TilesToCapture.Empty();
+		MissingTiles = ViewTiles;
+		MissingTiles.Insert(FMiniMapTileKey(), 0);
+		bIgnoreDiskCache = true;
+		SetActorTickEnabled(true);
+		return;
+	}
+
+	if (CaptureMode == EMiniMapCaptureMode::EveryFrame)
+	{
+		return;
+	}
+
+	// Captured from tick rather than right away so every request made this frame shares one capture
+	bCaptureRequested = true;
+	SetActorTickEnabled(true);
+}
+
+UTextureRenderTarget2D* AMiniMapGenerator::GetMiniMapRenderTarget() const
+{
+	return MiniMapCaptureComponent->TextureTarget;
+}
+
+void AMiniMapGenerator::TrimShowFlags()
+{
+	FEngineShowFlags& ShowFlags = MiniMapCaptureComponent->ShowFlags;
+
+	// Dynamic elements are drawn over the capture by the mini map widget
+	ShowFlags.SetSkeletalMeshes(false);
+	ShowFlags.SetParticles(false);
+
+	// Base color only, so none of the lighting or post processing shows up in the capture anyway
+	ShowFlags.SetDynamicShadows(false);
+	ShowFlags.SetAmbientOcclusion(false);
+	ShowFlags.SetScreenSpaceReflections(false);
+	ShowFlags.SetReflectionEnvironment(false);
+	ShowFlags.SetGlobalIllumination(false);
+	ShowFlags.SetPostProcessing(false);
+	ShowFlags.SetBloom(false);
+	ShowFlags.SetMotionBlur(false);
+	ShowFlags.SetEyeAdaptation(false);
+	ShowFlags.SetAntiAliasing(false);
+	ShowFlags.SetFog(false);
+	ShowFlags.SetVolumetricFog(false);
+	ShowFlags.SetAtmosphere(false);
+	ShowFlags.SetTranslucency(false);
+	ShowFlags.SetLensFlares(false);
+}
 
+void AMiniMapGenerator::CaptureNow()
+{
+	MiniMapCaptureComponent->CaptureScene();
+	bCaptureRequested = false;
+
+	if (CaptureMode != EMiniMapCaptureMode::TimeSliced)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void AMiniMapGenerator::OnLevelsChanged(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		RequestCapture();
+	}
+}
+
+void AMiniMapGenerator::SetTileView(const FVector2D& ViewCenter, float ViewWorldWidth, int ViewportSize)
+{
+	if (!bUseTiles || MapSize <= 0.0f || ViewWorldWidth <= 0.0f || ViewportSize <= 0)
+	{
+		return;
+	}
+
+	// Coarsest zoom level with at least one tile pixel per screen pixel
+	const float ScreenPixelsPerUnit = ViewportSize / ViewWorldWidth;
+	const float TilePixelsPerUnit = TileResolution / MapSize;
+	const int32 ZoomLevel = FMath::Clamp(FMath::CeilToInt(FMath::Log2(ScreenPixelsPerUnit / TilePixelsPerUnit)), 0, NumZoomLevels - 1);
+
+	const int32 TilesPerSide = 1 << ZoomLevel;
+	const float TileWorldSize = MapSize / TilesPerSide;
+
+	const FVector2D ViewMin = (ViewCenter - ViewWorldWidth * 0.5f - MapOrigin) / TileWorldSize;
+	const FVector2D ViewMax = (ViewCenter + ViewWorldWidth * 0.5f - MapOrigin) / TileWorldSize;
+
+	const int32 MinX = FMath::Max(FMath::FloorToInt(ViewMin.X) - TileMargin, 0);
+	const int32 MinY = FMath::Max(FMath::FloorToInt(ViewMin.Y) - TileMargin, 0);
+	const int32 MaxX = FMath::Min(FMath::FloorToInt(ViewMax.X) + TileMargin, TilesPerSide - 1);
+	const int32 MaxY = FMath::Min(FMath::FloorToInt(ViewMax.Y) + TileMargin, TilesPerSide - 1);
+
+	// The zoom level keeps a tile at no less than half the viewport, so the view never spans more than this many tiles a side.
+	// Plus one parent per zoom level to cover tiles still streaming in
+	const int32 MaxTilesPerSide = FMath::Min(FMath::CeilToInt(2.0f * ViewportSize / TileResolution) + 1 + TileMargin * 2, TilesPerSide);
+	MaxResidentTiles = MaxTilesPerSide * MaxTilesPerSide + NumZoomLevels;
+
+	const FVector2D ViewCenterInTiles = (ViewCenter - MapOrigin) / TileWorldSize;
+
+	ViewTiles.Reset();
+	for (int32 TileY = MinY; TileY <= MaxY; TileY++)
+	{
+		for (int32 TileX = MinX; TileX <= MaxX; TileX++)
+		{
+			ViewTiles.Add(FMiniMapTileKey(ZoomLevel, TileX, TileY));
+		}
+	}
+
+	ViewTiles.Sort([&ViewCenterInTiles](const FMiniMapTileKey& A, const FMiniMapTileKey& B)
+	{
+		return FVector2D::DistSquared(FVector2D(A.X + 0.5f, A.Y + 0.5f), ViewCenterInTiles) < FVector2D::DistSquared(FVector2D(B.X + 0.5f, B.Y + 0.5f), ViewCenterInTiles);
+	});
+
+	MissingTiles.Reset();
+	FallbackTiles.Reset();
+	for (const FMiniMapTileKey& Key : ViewTiles)
+	{
+		FResidentTile* ResidentTile = ResidentTiles.Find(Key);
+		if (ResidentTile)
+		{
+			ResidentTile->LastUsedFrame = GFrameCounter;
+			continue;
+		}
+
+		MissingTiles.Add(Key);
+
+		// Keep the parents covering this tile around until it is in
+		for (FMiniMapTileKey ParentKey(Key.ZoomLevel - 1, Key.X / 2, Key.Y / 2); ParentKey.ZoomLevel >= 0; ParentKey = FMiniMapTileKey(ParentKey.ZoomLevel - 1, ParentKey.X / 2, ParentKey.Y / 2))
+		{
+			FResidentTile* ResidentParent = ResidentTiles.Find(ParentKey);
+			if (ResidentParent)
+			{
+				ResidentParent->LastUsedFrame = GFrameCounter;
+				FallbackTiles.Add(ParentKey);
+				break;
+			}
+		}
+	}
+
+	// Stream in the whole map tile first, so there is always something to show
+	if (!ResidentTiles.Contains(FMiniMapTileKey()) && ZoomLevel > 0)
+	{
+		MissingTiles.Insert(FMiniMapTileKey(), 0);
+	}
+
+	TrimResidentTiles();
+
+	if (MissingTiles.Num() > 0 || TilesToCapture.Num() > 0 || PendingTileLoads.Num() > 0)
+	{
+		SetActorTickEnabled(true);
+	}
+}
+
+void AMiniMapGenerator::GetResidentTiles(TArray<FMiniMapTileView>& OutTiles) const
+{
+	OutTiles.Reset();
+
+	TSet<FMiniMapTileKey> AddedTiles;
+
+	for (const FMiniMapTileKey& Key : ViewTiles)
+	{
+		// Fall back to the closest resident parent while the tile streams in
+		for (FMiniMapTileKey TileKey = Key; TileKey.ZoomLevel >= 0; TileKey = FMiniMapTileKey(TileKey.ZoomLevel - 1, TileKey.X / 2, TileKey.Y / 2))
+		{
+			const FResidentTile* ResidentTile = ResidentTiles.Find(TileKey);
+			if (!ResidentTile)
+			{
+				continue;
+			}
+
+			bool bAlreadyAdded;
+			AddedTiles.Add(TileKey, &bAlreadyAdded);
+
+			if (!bAlreadyAdded)
+			{
+				FMiniMapTileView& TileView = OutTiles.AddDefaulted_GetRef();
+				TileView.Texture = TileTextures[ResidentTile->TextureIndex];
+				TileView.ZoomLevel = TileKey.ZoomLevel;
+				FMiniMapTileCache::GetTileBounds(MapOrigin, MapSize, TileKey, TileView.WorldMin, TileView.WorldSize);
+			}
+
+			break;
+		}
+	}
+
+	// Coarse parents are drawn first so finer tiles cover them
+	OutTiles.StableSort([](const FMiniMapTileView& A, const FMiniMapTileView& B)
+	{
+		return A.ZoomLevel < B.ZoomLevel;
+	});
+}
+
+int AMiniMapGenerator::GetNumResidentTiles() const
+{
+	return ResidentTiles.Num();
+}
+
+void AMiniMapGenerator::InitializeTiles()
+{
+	if (MapSize <= 0.0f)
+	{
+		const FBox LevelBounds = ALevelBounds::CalculateLevelBounds(GetWorld()->PersistentLevel);
+		if (!LevelBounds.IsValid)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "AMiniMapGenerator::InitializeTiles: Level has no bounds and no map size is set!");
+			bUseTiles = false;
+			return;
+		}
+
+		MapOrigin = FVector2D(LevelBounds.Min);
+		MapSize = FMath::Max(LevelBounds.GetSize().X, LevelBounds.GetSize().Y);
+	}
+
+	UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(this);
+	RenderTarget->RenderTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8;
+	RenderTarget->InitAutoFormat(TileResolution, TileResolution);
+	RenderTarget->UpdateResourceImmediate(true);
+	MiniMapCaptureComponent->TextureTarget = RenderTarget;
+
+	TileCaptureHeight = MiniMapCaptureComponent->GetComponentLocation().Z;
+	TileCacheLevelName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+}
+
+void AMiniMapGenerator::UpdateTileStreaming()
+{
+	// Finish reads from disk
+	for (int32 LoadIndex = PendingTileLoads.Num() - 1; LoadIndex >= 0; LoadIndex--)
+	{
+		FPendingTileLoad& PendingTileLoad = PendingTileLoads[LoadIndex];
+		if (!PendingTileLoad.bLoaded.IsReady())
+		{
+			continue;
+		}
+
+		const FMiniMapTileData& Tile = *PendingTileLoad.Tile;
+
+		FVector2D ExpectedWorldMin;
+		float ExpectedWorldSize;
+		FMiniMapTileCache::GetTileBounds(MapOrigin, MapSize, PendingTileLoad.Key, ExpectedWorldMin, ExpectedWorldSize);
+
+		// A tile cached with other map bounds or resolution is as good as missing
+		const bool bTileMatches = PendingTileLoad.bLoaded.Get() && Tile.Resolution == TileResolution
+			&& Tile.WorldMin.Equals(ExpectedWorldMin, 1.0f) && FMath::IsNearlyEqual(Tile.WorldSize, ExpectedWorldSize, 1.0f);
+
+		if (bTileMatches)
+		{
+			MakeTileResident(PendingTileLoad.Key, Tile.Pixels);
+		}
+		else
+		{
+			TilesToCapture.Add(PendingTileLoad.Key);
+		}
+
+		PendingTileLoads.RemoveAtSwap(LoadIndex, 1, false);
+	}
+
+	// Start reads for missing tiles, or queue them for capture if they can not be on disk
+	while (MissingTiles.Num() > 0 && PendingTileLoads.Num() < MaxTileLoadsInFlight)
+	{
+		const FMiniMapTileKey Key = MissingTiles[0];
+		MissingTiles.RemoveAt(0, 1, false);
+
+		const bool bAlreadyStreaming = ResidentTiles.Contains(Key) || TilesToCapture.Contains(Key)
+			|| PendingTileLoads.ContainsByPredicate([&Key](const FPendingTileLoad& PendingTileLoad) { return PendingTileLoad.Key == Key; });
+
+		if (bAlreadyStreaming)
+		{
+			continue;
+		}
+
+		if (!bUseDiskCache || bIgnoreDiskCache)
+		{
+			TilesToCapture.Add(Key);
+			continue;
+		}
+
+		FPendingTileLoad& PendingTileLoad = PendingTileLoads.AddDefaulted_GetRef();
+		PendingTileLoad.Key = Key;
+		PendingTileLoad.Tile = MakeShared<FMiniMapTileData, ESPMode::ThreadSafe>();
+
+		TSharedPtr<FMiniMapTileData, ESPMode::ThreadSafe> Tile = PendingTileLoad.Tile;
+		const FString BakedTilePath = FMiniMapTileCache::GetBakedTilePath(TileCacheLevelName, Key);
+		const FString TilePath = FMiniMapTileCache::GetTilePath(TileCacheLevelName, Key);
+
+		// Baked tiles first, then tiles captured in earlier sessions
+		PendingTileLoad.bLoaded = Async(EAsyncExecution::ThreadPool, [Tile, BakedTilePath, TilePath]()
+		{
+			return FMiniMapTileCache::LoadTile(BakedTilePath, *Tile) || FMiniMapTileCache::LoadTile(TilePath, *Tile);
+		});
+	}
+
+	// Captures stall on the GPU read back, so only a few a frame
+	const int32 NumToCapture = FMath::Min(TilesToCapture.Num(), MaxTileCapturesPerFrame);
+	for (int32 CaptureIndex = 0; CaptureIndex < NumToCapture; CaptureIndex++)
+	{
+		if (IsTileInView(TilesToCapture[CaptureIndex]))
+		{
+			CaptureTile(TilesToCapture[CaptureIndex]);
+		}
+	}
+
+	TilesToCapture.RemoveAt(0, NumToCapture, false);
+
+	if (MissingTiles.Num() == 0 && TilesToCapture.Num() == 0 && PendingTileLoads.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void AMiniMapGenerator::CaptureTile(const FMiniMapTileKey& Key)
+{
+	UTextureRenderTarget2D* RenderTarget = MiniMapCaptureComponent->TextureTarget;
+	if (!RenderTarget)
+	{
+		return;
+	}
+
+	FMiniMapTileData Tile;
+	Tile.Resolution = TileResolution;
+	FMiniMapTileCache::GetTileBounds(MapOrigin, MapSize, Key, Tile.WorldMin, Tile.WorldSize);
+
+	MiniMapCaptureComponent->OrthoWidth = Tile.WorldSize;
+	MiniMapCaptureComponent->SetWorldLocation(FVector(Tile.WorldMin + Tile.WorldSize * 0.5f, TileCaptureHeight));
+	MiniMapCaptureComponent->CaptureScene();
+
+	if (!RenderTarget->GameThread_GetRenderTargetResource()->ReadPixels(Tile.Pixels))
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, "AMiniMapGenerator::CaptureTile: Failed to read the tile back!");
+		return;
+	}
+
+	// Scene captures write inverted opacity to alpha
+	for (FColor& Pixel : Tile.Pixels)
+	{
+		Pixel.A = 255;
+	}
+
+	MakeTileResident(Key, Tile.Pixels);
+
+	if (bUseDiskCache)
+	{
+		const FString TilePath = FMiniMapTileCache::GetTilePath(TileCacheLevelName, Key);
+		Async(EAsyncExecution::ThreadPool, [Tile = MoveTemp(Tile), TilePath]()
+		{
+			FMiniMapTileCache::SaveTile(TilePath, Tile);
+		});
+	}
+}
+
+void AMiniMapGenerator::MakeTileResident(const FMiniMapTileKey& Key, const TArray<FColor>& Pixels)
+{
+	if (!IsTileInView(Key))
+	{
+		return;
+	}
+
+	const int32 TextureIndex = AcquireTileTexture();
+	if (TextureIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FResidentTile& ResidentTile = ResidentTiles.Add(Key);
+	ResidentTile.TextureIndex = TextureIndex;
+	ResidentTile.LastUsedFrame = GFrameCounter;
+
+	const int32 NumBytes = Pixels.Num() * sizeof(FColor);
+	uint8* TextureData = (uint8*)FMemory::Malloc(NumBytes);
+	FMemory::Memcpy(TextureData, Pixels.GetData(), NumBytes);
+
+	// The render thread owns the copy and the region until the upload is done
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, TileResolution, TileResolution);
+	TileTextures[TextureIndex]->UpdateTextureRegions(0, 1, Region, TileResolution * sizeof(FColor), sizeof(FColor), TextureData,
+		[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+		{
+			FMemory::Free(SrcData);
+			delete Regions;
+		});
+}
+
+int32 AMiniMapGenerator::AcquireTileTexture()
+{
+	if (FreeTileTextureIndices.Num() > 0)
+	{
+		return FreeTileTextureIndices.Pop(false);
+	}
+
+	if (TileTextures.Num() < MaxResidentTiles)
+	{
+		UTexture2D* Texture = UTexture2D::CreateTransient(TileResolution, TileResolution, PF_B8G8R8A8);
+		Texture->UpdateResource();
+		return TileTextures.Add(Texture);
+	}
+
+	// Reuse the texture of the least recently used tile outside the view that is not covering for a missing one
+	const FMiniMapTileKey* EvictedKey = nullptr;
+	uint64 EvictedLastUsedFrame = MAX_uint64;
+
+	for (const TPair<FMiniMapTileKey, FResidentTile>& ResidentTile : ResidentTiles)
+	{
+		if (ResidentTile.Value.LastUsedFrame < EvictedLastUsedFrame && !IsTileNeeded(ResidentTile.Key))
+		{
+			EvictedKey = &ResidentTile.Key;
+			EvictedLastUsedFrame = ResidentTile.Value.LastUsedFrame;
+		}
+	}
+
+	if (!EvictedKey)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 TextureIndex = ResidentTiles.FindChecked(*EvictedKey).TextureIndex;
+	ResidentTiles.Remove(*EvictedKey);
+	return TextureIndex;
+}
+
+void AMiniMapGenerator::TrimResidentTiles()
+{
+	if (ResidentTiles.Num() <= MaxResidentTiles)
+	{
+		return;
+	}
+
+	TArray<FMiniMapTileKey> EvictableKeys;
+	for (const TPair<FMiniMapTileKey, FResidentTile>& ResidentTile : ResidentTiles)
+	{
+		if (!IsTileNeeded(ResidentTile.Key))
+		{
+			EvictableKeys.Add(ResidentTile.Key);
+		}
+	}
+
+	EvictableKeys.Sort([this](const FMiniMapTileKey& A, const FMiniMapTileKey& B)
+	{
+		return ResidentTiles[A].LastUsedFrame < ResidentTiles[B].LastUsedFrame;
+	});
+
+	for (int32 EvictIndex = 0; EvictIndex < EvictableKeys.Num() && ResidentTiles.Num() > MaxResidentTiles; EvictIndex++)
+	{
+		FreeTileTextureIndices.Add(ResidentTiles.FindChecked(EvictableKeys[EvictIndex]).TextureIndex);
+		ResidentTiles.Remove(EvictableKeys[EvictIndex]);
+	}
+
+	// Let go of textures beyond the budget, so a smaller viewport frees memory. Free textures are always at the end once trimmed
+	FreeTileTextureIndices.Sort();
+	while (FreeTileTextureIndices.Num() > 0 && FreeTileTextureIndices.Last() == TileTextures.Num() - 1 && TileTextures.Num() > MaxResidentTiles)
+	{
+		FreeTileTextureIndices.Pop(false);
+		TileTextures.Pop(false);
+	}
+}
+
+bool AMiniMapGenerator::IsTileInView(const FMiniMapTileKey& Key) const
+{
+	// The whole map tile is kept as the fallback for everything else
+	return Key == FMiniMapTileKey() || ViewTiles.Contains(Key);
+}
+
+bool AMiniMapGenerator::IsTileNeeded(const FMiniMapTileKey& Key) const
+{
+	return FallbackTiles.Contains(Key) || IsTileInView(Key);
+}
@@ -3,12 +3,71 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
 #include "GameFramework/Actor.h"
+#include "MiniMapTileCache.h"
 #include "MiniMapGenerator.generated.h"
 
 class USceneCaptureComponent;
+class UTexture2D;
 class UTextureRenderTarget2D;
 
+// When the mini map is captured
+UENUM(BlueprintType)
+enum class EMiniMapCaptureMode : uint8
+{
+	// Capture every frame. Only for debugging, this renders the whole scene a second time every frame
+	EveryFrame UMETA(DisplayName = "Every Frame"),
+
+	// Capture once on begin play. For levels whose geometry never changes
+	Once UMETA(DisplayName = "Once"),
+
+	// Capture on begin play and whenever RequestCapture is called or a level is streamed in or out
+	OnDemand UMETA(DisplayName = "On Demand"),
+
+	// Capture CaptureRateHz times a second
+	TimeSliced UMETA(DisplayName = "Time Sliced")
+};
+
+// A resident mini map tile for the mini map widget to draw
+USTRUCT(BlueprintType)
+struct FMiniMapTileView
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(BlueprintReadOnly, Category = "Mini Map")
+	UTexture2D* Texture;
+
+	// World XY of the tile's min corner. The tile image has world +X up and world +Y right
+	UPROPERTY(BlueprintReadOnly, Category = "Mini Map")
+	FVector2D WorldMin;
+
+	// World width and height of the tile
+	UPROPERTY(BlueprintReadOnly, Category = "Mini Map")
+	float WorldSize;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Mini Map")
+	int ZoomLevel;
+
+	FMiniMapTileView()
+	{
+		Texture = nullptr;
+		WorldMin = FVector2D::ZeroVector;
+		WorldSize = 0.0f;
+		ZoomLevel = 0;
+	}
+};
+
+/**
+	Captures a top down view of the level's static geometry into a render target for the mini map.
+	Characters, particles and other dynamic elements are left out of the capture and should be drawn over it by the mini map widget.
+
+	With bUseTiles the map is instead split into a quadtree of tiles over several zoom levels. Only the tiles around the view
+	given to SetTileView are kept in memory, so memory use follows the viewport size rather than the map size. Tiles are read from
+	the disk cache written by earlier sessions or the bake commandlet, and captured one at a time when missing.
+*/
 UCLASS()
 class ROUNDBASEDSHOOTER_API AMiniMapGenerator : public AActor
 {
@@ -17,15 +76,184 @@ class ROUNDBASEDSHOOTER_API AMiniMapGenerator : public AActor
 public:	
 	AMiniMapGenerator();
 
+	virtual void Tick(float DeltaTime) override;
+
+	/**
+		Captures the mini map on the next tick. Several requests in the same frame only capture once.
+		With tiles, drops the resident tiles and captures them again, ignoring the disk cache for the rest of the session.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Mini Map")
+	void RequestCapture();
+
+	// The render target the mini map is captured into. Tiles are only staged in it, use GetResidentTiles for those
+	UFUNCTION(BlueprintPure, Category = "Mini Map")
+	UTextureRenderTarget2D* GetMiniMapRenderTarget() const;
+
+	/**
+		Sets the part of the map the mini map shows. Picks the zoom level and streams in the tiles around the view.
+		@param ViewCenter - World XY at the center of the mini map
+		@param ViewWorldWidth - World width shown across the mini map
+		@param ViewportSize - Width of the mini map on screen in pixels
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Mini Map")
+	void SetTileView(const FVector2D& ViewCenter, float ViewWorldWidth, int ViewportSize);
+
+	/**
+		Gets the tiles to draw for the current view, coarsest first. Tiles still streaming in are covered by their closest resident parent.
+		@param OutTiles - Returned tiles. Emptied first
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Mini Map")
+	void GetResidentTiles(TArray<FMiniMapTileView>& OutTiles) const;
+
+	UFUNCTION(BlueprintPure, Category = "Mini Map")
+	int GetNumResidentTiles() const;
+
 protected:
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Scene capture component used to capture the scene
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Mini Map")
 	USceneCaptureComponent2D* MiniMapCaptureComponent;
 
+	// When the mini map is captured. With tiles, only On Demand does anything, recapturing the tiles when levels stream in or out
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map")
+	EMiniMapCaptureMode CaptureMode;
+
+	// Captures per second in the time sliced capture mode
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map", meta = (ClampMin = "0.1"))
+	float CaptureRateHz;
+
+	// Width and height of the render target created when the capture component has none assigned
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map", meta = (ClampMin = "64", ClampMax = "4096"))
+	int RenderTargetResolution;
+
+	// Split the map into streamed tiles instead of capturing it in one go
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles")
+	bool bUseTiles;
+
+	// World XY of the map's min corner. Only used if MapSize is above 0
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles")
+	FVector2D MapOrigin;
+
+	// World width and height of the square area the tiles cover. 0 to use the persistent level's bounds
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles")
+	float MapSize;
+
+	// Width and height of a tile in pixels
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles", meta = (ClampMin = "64", ClampMax = "2048"))
+	int TileResolution;
+
+	// Number of zoom levels. Level 0 is the whole map in one tile and each level after has twice the detail
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles", meta = (ClampMin = "1", ClampMax = "10"))
+	int NumZoomLevels;
+
+	// Rings of tiles kept around the view so panning does not show missing tiles
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles", meta = (ClampMin = "0"))
+	int TileMargin;
+
+	// Max number of tiles captured per frame. Each capture waits for the GPU to read the pixels back
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles", meta = (ClampMin = "1"))
+	int MaxTileCapturesPerFrame;
+
+	// Max number of tiles being read from disk at once
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles", meta = (ClampMin = "1"))
+	int MaxTileLoadsInFlight;
+
+	// Read baked tiles and tiles cached by earlier sessions, and write captured tiles to Saved/MiniMapCache
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Mini Map|Tiles")
+	bool bUseDiskCache;
+
 private:
 
+	struct FResidentTile
+	{
+		// Index into TileTextures
+		int32 TextureIndex;
+
+		// Frame the tile was last part of the view
+		uint64 LastUsedFrame;
+	};
+
+	struct FPendingTileLoad
+	{
+		FMiniMapTileKey Key;
+
+		TSharedPtr<FMiniMapTileData, ESPMode::ThreadSafe> Tile;
+
+		TFuture<bool> bLoaded;
+	};
+
+	// Turns off every show flag the mini map does not need
+	void TrimShowFlags();
+
+	// Captures the scene into the render target and stops ticking if nothing else needs a capture
+	void CaptureNow();
+
+	// Bound to level streaming so on demand captures pick up streamed geometry
+	void OnLevelsChanged(ULevel* Level, UWorld* World);
+
+	// Sets up the tile render target and works out the map area
+	void InitializeTiles();
+
+	// Finishes disk reads, starts new ones and captures missing tiles within the per frame budget
+	void UpdateTileStreaming();
+
+	// Captures the tile, uploads it and writes it to the disk cache
+	void CaptureTile(const FMiniMapTileKey& Key);
+
+	// Copies the pixels into a free tile texture, evicting the least recently used tile that is not needed if there is no free one
+	void MakeTileResident(const FMiniMapTileKey& Key, const TArray<FColor>& Pixels);
+
+	// Finds a texture to put a new tile in. INDEX_NONE if every texture holds a tile in the view
+	int32 AcquireTileTexture();
+
+	// Evicts least recently used tiles that are not needed until no more than MaxResidentTiles are left
+	void TrimResidentTiles();
+
+	bool IsTileInView(const FMiniMapTileKey& Key) const;
+
+	// If the tile is in the view or is the resident parent drawn in place of a view tile still streaming in. Needed tiles are never evicted
+	bool IsTileNeeded(const FMiniMapTileKey& Key) const;
+
+	bool bCaptureRequested;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	// Tile textures, resident or free
+	UPROPERTY()
+	TArray<UTexture2D*> TileTextures;
+
+	TArray<int32> FreeTileTextureIndices;
+
+	TMap<FMiniMapTileKey, FResidentTile> ResidentTiles;
+
+	// Tiles of the current view, nearest the view center first
+	TArray<FMiniMapTileKey> ViewTiles;
+
+	// View tiles not resident yet, nearest the view center first
+	TArray<FMiniMapTileKey> MissingTiles;
+
+	// Closest resident parent of each view tile that was missing when the view was set. Drawn over the hole until the tile is in
+	TSet<FMiniMapTileKey> FallbackTiles;
+
+	// Tiles that failed to load from disk and need capturing
+	TArray<FMiniMapTileKey> TilesToCapture;
+
+	TArray<FPendingTileLoad> PendingTileLoads;
+
+	// Max tiles kept resident. Worked out from the viewport size in SetTileView
+	int32 MaxResidentTiles;
+
+	// Level name the disk cache is kept under
+	FString TileCacheLevelName;
+
+	// World Z the tiles are captured from
+	float TileCaptureHeight;
 
+	// Set by RequestCapture, as the tiles on disk no longer match the level
+	bool bIgnoreDiskCache;
 };
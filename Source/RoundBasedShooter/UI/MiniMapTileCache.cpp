@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MiniMapTileCache.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	// "MMTL"
+	constexpr uint32 TileFileMagic = 0x4C544D4D;
+
+	// Bump when the layout changes so old caches get rebuilt instead of misread
+	constexpr int32 TileFileVersion = 1;
+
+	// Tiles bigger than this are treated as damaged rather than allocated
+	constexpr int32 MaxTileResolution = 4096;
+}
+
+FString FMiniMapTileCache::GetLevelDirectory(const FString& LevelName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("MiniMapCache") / LevelName;
+}
+
+FString FMiniMapTileCache::GetTilePath(const FString& LevelName, const FMiniMapTileKey& Key)
+{
+	return GetLevelDirectory(LevelName) / FString::Printf(TEXT("%d_%d_%d.tile"), Key.ZoomLevel, Key.X, Key.Y);
+}
+
+FString FMiniMapTileCache::GetBakedLevelDirectory(const FString& LevelName)
+{
+	return FPaths::ProjectContentDir() / TEXT("MiniMap") / LevelName;
+}
+
+FString FMiniMapTileCache::GetBakedTilePath(const FString& LevelName, const FMiniMapTileKey& Key)
+{
+	return GetBakedLevelDirectory(LevelName) / FString::Printf(TEXT("%d_%d_%d.tile"), Key.ZoomLevel, Key.X, Key.Y);
+}
+
+bool FMiniMapTileCache::SaveTile(const FString& Path, const FMiniMapTileData& Tile)
+{
+	if (Tile.Resolution <= 0 || Tile.Pixels.Num() != Tile.Resolution * Tile.Resolution)
+	{
+		return false;
+	}
+
+	const int32 UncompressedSize = Tile.Pixels.Num() * sizeof(FColor);
+
+	TArray<uint8> CompressedPixels;
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+	CompressedPixels.SetNumUninitialized(CompressedSize);
+
+	if (!FCompression::CompressMemory(NAME_Zlib, CompressedPixels.GetData(), CompressedSize, Tile.Pixels.GetData(), UncompressedSize))
+	{
+		return false;
+	}
+
+	CompressedPixels.SetNum(CompressedSize, false);
+
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+
+	uint32 Magic = TileFileMagic;
+	int32 Version = TileFileVersion;
+	int32 Resolution = Tile.Resolution;
+	FVector2D WorldMin = Tile.WorldMin;
+	float WorldSize = Tile.WorldSize;
+
+	Writer << Magic << Version << Resolution << WorldMin << WorldSize << CompressedPixels;
+
+	return FFileHelper::SaveArrayToFile(FileData, *Path);
+}
+
+bool FMiniMapTileCache::LoadTile(const FString& Path, FMiniMapTileData& OutTile)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic << Version;
+
+	if (Magic != TileFileMagic || Version != TileFileVersion)
+	{
+		return false;
+	}
+
+	TArray<uint8> CompressedPixels;
+	Reader << OutTile.Resolution << OutTile.WorldMin << OutTile.WorldSize << CompressedPixels;
+
+	if (Reader.IsError() || OutTile.Resolution <= 0 || OutTile.Resolution > MaxTileResolution)
+	{
+		return false;
+	}
+
+	OutTile.Pixels.SetNumUninitialized(OutTile.Resolution * OutTile.Resolution);
+
+	return FCompression::UncompressMemory(NAME_Zlib, OutTile.Pixels.GetData(), OutTile.Pixels.Num() * sizeof(FColor), CompressedPixels.GetData(), CompressedPixels.Num());
+}
+
+void FMiniMapTileCache::ClearLevel(const FString& LevelName)
+{
+	IFileManager::Get().DeleteDirectory(*GetLevelDirectory(LevelName), false, true);
+}
+
+void FMiniMapTileCache::GetTileBounds(const FVector2D& MapOrigin, float MapSize, const FMiniMapTileKey& Key, FVector2D& OutWorldMin, float& OutWorldSize)
+{
+	OutWorldSize = MapSize / (1 << Key.ZoomLevel);
+	OutWorldMin = MapOrigin + FVector2D(Key.X, Key.Y) * OutWorldSize;
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Identifies a mini map tile. Zoom level 0 is the whole map in one tile, each level after splits every tile in four
+struct FMiniMapTileKey
+{
+	int32 ZoomLevel;
+	int32 X;
+	int32 Y;
+
+	FMiniMapTileKey()
+	{
+		ZoomLevel = 0;
+		X = 0;
+		Y = 0;
+	}
+
+	FMiniMapTileKey(int32 InZoomLevel, int32 InX, int32 InY)
+	{
+		ZoomLevel = InZoomLevel;
+		X = InX;
+		Y = InY;
+	}
+
+	bool operator==(const FMiniMapTileKey& Other) const
+	{
+		return ZoomLevel == Other.ZoomLevel && X == Other.X && Y == Other.Y;
+	}
+
+	friend uint32 GetTypeHash(const FMiniMapTileKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.ZoomLevel), GetTypeHash(Key.X)), GetTypeHash(Key.Y));
+	}
+};
+
+// Pixels of one mini map tile and the square area of the world it covers
+struct FMiniMapTileData
+{
+	// Width and height in pixels
+	int32 Resolution;
+
+	// World XY of the tile's min corner
+	FVector2D WorldMin;
+
+	// World width and height of the tile
+	float WorldSize;
+
+	// Resolution * Resolution BGRA pixels row by row, as seen from above with world +X up and world +Y right
+	TArray<FColor> Pixels;
+
+	FMiniMapTileData()
+	{
+		Resolution = 0;
+		WorldMin = FVector2D::ZeroVector;
+		WorldSize = 0.0f;
+	}
+};
+
+/**
+	Reads and writes mini map tiles named <ZoomLevel>_<X>_<Y>.tile. Tiles captured at runtime are cached in Saved/MiniMapCache/<Level>,
+	tiles baked by the bake commandlet go to Content/MiniMap/<Level> so they can be staged with the game.
+	A tile file is a small header followed by the zlib compressed pixels. Both the runtime generator and the bake commandlet use this format.
+*/
+class ROUNDBASEDSHOOTER_API FMiniMapTileCache
+{
+public:
+
+	// Folder holding the tiles of a level. LevelName is the short map name without the PIE prefix
+	static FString GetLevelDirectory(const FString& LevelName);
+
+	static FString GetTilePath(const FString& LevelName, const FMiniMapTileKey& Key);
+
+	// Folder holding the baked tiles of a level
+	static FString GetBakedLevelDirectory(const FString& LevelName);
+
+	static FString GetBakedTilePath(const FString& LevelName, const FMiniMapTileKey& Key);
+
+	// Writes the tile to disk. Safe to call from any thread
+	static bool SaveTile(const FString& Path, const FMiniMapTileData& Tile);
+
+	// Reads a tile from disk. Safe to call from any thread. Fails if the file is missing, from another version or damaged
+	static bool LoadTile(const FString& Path, FMiniMapTileData& OutTile);
+
+	// Deletes every cached tile of the level
+	static void ClearLevel(const FString& LevelName);
+
+	// World area of a tile in a map of the given origin and size
+	static void GetTileBounds(const FVector2D& MapOrigin, float MapSize, const FMiniMapTileKey& Key, FVector2D& OutWorldMin, float& OutWorldSize);
+};